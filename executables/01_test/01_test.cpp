@@ -20,10 +20,12 @@
 #include <bullet/BulletWorldImporter/btBulletWorldImporter.h>
 #include <bullet/btBulletCollisionCommon.h>
 #include <bullet/btBulletDynamicsCommon.h>
+#include <charconv>
 #include <gev/audio/audio.hpp>
 #include <gev/audio/playback.hpp>
 #include <gev/audio/sound.hpp>
 #include <gev/buffer.hpp>
+#include <gev/cpu_profiler.hpp>
 #include <gev/descriptors.hpp>
 #include <gev/engine.hpp>
 #include <gev/game/addition.hpp>
@@ -35,6 +37,7 @@
 #include <gev/game/mesh_renderer.hpp>
 #include <gev/game/render_target_2d.hpp>
 #include <gev/game/renderer.hpp>
+#include <gev/gpu_profiler.hpp>
 #include <gev/imgui/imgui.h>
 #include <gev/imgui/imgui_extra.hpp>
 #include <gev/per_frame.hpp>
@@ -71,6 +74,14 @@ rnu::vec4ui8 pack_vec4(rnu::vec4 v)
   return rnu::vec4ui8(clamp(v * 255.f, 0.f, 255.f));
 }
 
+void write_profiler_trace(std::filesystem::path const& path)
+{
+  gev::cpu_profiler::get().collect();
+  auto events = gev::cpu_profiler::get().trace_events();
+  std::ranges::move(gev::service<gev::gpu_profiler>()->trace_events(), std::back_inserter(events));
+  gev::write_chrome_trace(path, events);
+}
+
 class ui_shader : public gev::game::shader
 {
 public:
@@ -394,39 +405,48 @@ private:
 void register_all_types(gev::serializer& s)
 {
 #define reg_one(Name) s.register_type<Name>(#Name);
+#define reg_component(Name)    \
+  s.register_type<Name>(#Name); \
+  gev::scenery::register_component<Name>();
   reg_one(gev::game::mesh);
   reg_one(gev::game::texture);
   reg_one(gev::game::material);
   reg_one(gev::scenery::entity);
   reg_one(gev::scenery::collision_shape);
-  reg_one(gev::scenery::collider_component);
+  reg_component(gev::scenery::collider_component);
 
   reg_one(gev::scenery::joint_animation);
   reg_one(gev::scenery::animation);
   reg_one(gev::scenery::transform_tree);
   reg_one(gev::scenery::skin);
-
-  reg_one(bone_component);
-  reg_one(camera_component);
-  reg_one(camera_controller_component);
-  reg_one(debug_ui_component);
-  reg_one(ground_component);
-  reg_one(remote_controller_component);
-  reg_one(shadow_map_component);
-  reg_one(skin_component);
-  reg_one(renderer_component);
-  reg_one(sound_component);
+  reg_one(gev::scenery::skeleton);
+
+  reg_component(bone_component);
+  reg_component(camera_component);
+  reg_component(camera_controller_component);
+  reg_component(debug_ui_component);
+  reg_component(ground_component);
+  reg_component(remote_controller_component);
+  reg_component(shadow_map_component);
+  reg_component(skin_component);
+  reg_component(renderer_component);
+  reg_component(sound_component);
+#undef reg_component
 #undef reg_one
 }
 
 class test01
 {
 public:
-  test01()
+  test01(std::optional<gev::headless_options> headless = std::nullopt)
   {
-    gev::engine::get().start("Test 01", 1280, 720);
+    if (headless)
+      gev::engine::get().start_headless("Test 01", 1280, 720, *headless);
+    else
+      gev::engine::get().start("Test 01", 1280, 720);
     gev::register_service<gev::game::renderer>(gev::engine::get().swapchain_size(), _render_samples);
     auto const renderer = gev::register_service<gev::game::mesh_renderer>();
+    renderer->set_compute_skinning(true);
     auto const shadow_map_holder = gev::register_service<gev::game::shadow_map_holder>();
     renderer->set_shadow_maps(shadow_map_holder->descriptor());
     gev::register_service<main_controls>();
@@ -434,10 +454,13 @@ public:
     auto const serializer = gev::register_service<gev::serializer>();
     register_all_types(*serializer);
 
+    auto compute_warmup = gev::engine::get().pipelines().prewarm(
+      {[this] { _post_process = std::make_shared<post_process>(vk::Format::eR16G16B16A16Sfloat); }});
     _environment = std::make_shared<environment>();
-    _post_process = std::make_shared<post_process>(vk::Format::eR16G16B16A16Sfloat);
 
     shader_repo->emplace("UI", std::make_shared<ui_shader>());
+    shader_repo->prewarm();
+    compute_warmup.get();
     _font = std::make_unique<font>(*serializer, "res/Poppins-Regular.ttf", 512, 16.0f);
 
     float xm = 0.0f;
@@ -535,6 +558,8 @@ public:
     auto audio_host = gev::service<gev::audio::audio_host>();
     auto audio_repo = gev::service<gev::audio_repo>();
 
+    renderer_component::register_system(*entity_manager);
+
     auto const torus =
       serializer->initial_load("torus.gevas", [] { return std::make_shared<gev::game::mesh>("res/torus.obj"); });
     auto const grass =
@@ -564,8 +589,8 @@ public:
           std::move(shape), 10.0f, false, collisions::player, collisions::all ^ collisions::player);
         auto const ptcl = load_gltf_entity("res/ptcl/scene.gltf");
         entity_manager->reparent(ptcl, player);
-        ptcl->local_transform.position.y = -0.5;
-        player->local_transform.position.y = 0.5;
+        ptcl->edit_local_transform().position.y = -0.5;
+        player->edit_local_transform().position.y = 0.5;
         player->emplace<debug_ui_component>("Player");
         player->emplace<remote_controller_component>()->own();
         return player;
@@ -585,8 +610,9 @@ public:
         c->emplace<camera_component>();
         c->emplace<camera_controller_component>();
         c->emplace<sound_component>();
-        c->local_transform.position = rnu::vec3(4, 2, 5);
-        c->local_transform.rotation = rnu::look_at(c->local_transform.position, rnu::vec3(0, 0, 0), rnu::vec3(0, 1, 0));
+        auto& local = c->edit_local_transform();
+        local.position = rnu::vec3(4, 2, 5);
+        local.rotation = rnu::look_at(local.position, rnu::vec3(0, 0, 0), rnu::vec3(0, 1, 0));
         return c;
       }));
     entity_manager->add(e2);
@@ -619,7 +645,7 @@ public:
 
     auto const sphere_prefab = as<gev::scenery::entity>(serializer->initial_load("sphere_prefab.gevas", [&]{
       auto collider = entity_manager->instantiate();
-      collider->local_transform.position = {5, 0, 3};
+      collider->edit_local_transform().position = {5, 0, 3};
       collider->emplace<debug_ui_component>("Collider Sphere");
       auto sphere_rnd = collider->emplace<renderer_component>();
       sphere_rnd->set_mesh(as<gev::game::mesh>(sphere));
@@ -640,8 +666,9 @@ public:
         auto sm = entity_manager->instantiate();
         sm->emplace<debug_ui_component>("ShadowMap Camera");
         sm->emplace<shadow_map_component>();
-        sm->local_transform.position = {5, 10, 10};
-        sm->local_transform.rotation = rnu::look_at(sm->local_transform.position, rnu::vec3(0), rnu::vec3(0, 1, 0));
+        auto& local = sm->edit_local_transform();
+        local.position = {5, 10, 10};
+        local.rotation = rnu::look_at(local.position, rnu::vec3(0), rnu::vec3(0, 1, 0));
         return sm;
       }));
     entity_manager->add(sm, e);
@@ -740,12 +767,26 @@ private:
         std::println("{}", std::stacktrace::current());
       }
 
+      ImGui::Checkbox("CPU Profiler", &_show_cpu_profiler);
+      ImGui::Checkbox("GPU Profiler", &_show_gpu_profiler);
+      if (ImGui::Button("Save Trace"))
+        write_profiler_trace("trace.json");
+
+      auto const culling =
+        gev::service<gev::game::mesh_renderer>()->statistics(*gev::service<main_controls>()->main_camera);
+      ImGui::Text("Visible Instances: %u / %u", culling.visible, culling.instances);
+
       ImGui::BeginGroupPanel("Entities", ImVec2(ImGui::GetContentRegionAvail().x, 0.0));
       draw_component_tree(gev::service<gev::scenery::entity_manager>()->root_entities());
       ImGui::EndGroupPanel();
     }
     ImGui::End();
 
+    if (_show_cpu_profiler)
+      gev::cpu_profiler::get().draw_overlay();
+    if (_show_gpu_profiler)
+      gev::service<gev::gpu_profiler>()->draw_overlay();
+
     if (_selected_entity.lock() && ImGui::Begin("Entity"))
     {
       auto nc = _selected_entity.lock()->get<debug_ui_component>();
@@ -775,6 +816,7 @@ private:
     shadow_map_holder->sync(frame.command_buffer);
     mesh_renderer->sync(frame.command_buffer);
     controls->main_camera->sync(frame.command_buffer);
+    mesh_renderer->cull(frame.command_buffer, *controls->main_camera);
 
     // ENVIRONMENT
     _environment->render(frame.command_buffer, 0, 0, size.width, size.height);
@@ -823,6 +865,8 @@ private:
   std::weak_ptr<gev::scenery::entity> _selected_entity;
 
   bool _fullscreen = false;
+  bool _show_cpu_profiler = false;
+  bool _show_gpu_profiler = false;
   rnu::vec2i _position_before_fullscreen = {0, 0};
   rnu::vec2i _size_before_fullscreen = {0, 0};
 
@@ -837,10 +881,32 @@ private:
 
 int main(int argc, char** argv)
 {
+  std::optional<gev::headless_options> headless;
+  for (int i = 1; i < argc; ++i)
+  {
+    if (std::string_view(argv[i]) == "--headless")
+    {
+      headless.emplace();
+      if (i + 1 < argc && !std::string_view(argv[i + 1]).starts_with("--"))
+      {
+        std::string_view const count = argv[++i];
+        auto const [end, error] = std::from_chars(count.data(), count.data() + count.size(), headless->num_frames);
+        if (error != std::errc{} || end != count.data() + count.size())
+        {
+          std::println(stderr, "Invalid frame count for --headless: \"{}\".", count);
+          return 1;
+        }
+      }
+    }
+  }
+
   int retval = 0;
   {
-    test01 test{};
+    test01 test{headless};
     retval = test.start();
+
+    if (headless)
+      write_profiler_trace("trace.json");
   }
 
   gev::engine::reset();
@@ -54,8 +54,10 @@ void camera_controller_component::early_update()
 
   _base_camera.mouse(_cursor.value().x, _cursor.value().y, !_cursor.finished());
 
-  owner()->local_transform.position = _base_camera.position();
-  owner()->local_transform.rotation = _base_camera.rotation();
+  auto local = owner()->local_transform();
+  local.position = _base_camera.position();
+  local.rotation = _base_camera.rotation();
+  owner()->set_local_transform(local);
 
   if (!_camera.expired())
   {
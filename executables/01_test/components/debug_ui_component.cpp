@@ -19,15 +19,17 @@ void debug_ui_component::ui()
     owner()->set_active(active);
   }
 
-  ImGui::DragFloat3("Position", owner()->local_transform.position.data(), 0.01);
+  auto local = owner()->local_transform();
+  ImGui::DragFloat3("Position", local.position.data(), 0.01);
 
-  auto euler = gev::scenery::to_euler(owner()->local_transform.rotation);
+  auto euler = gev::scenery::to_euler(local.rotation);
   if (ImGui::DragFloat3("Orientation", euler.data(), 0.01))
   {
-    owner()->local_transform.rotation = gev::scenery::from_euler(euler);
+    local.rotation = gev::scenery::from_euler(euler);
   }
 
-  ImGui::DragFloat3("Scale", owner()->local_transform.scale.data(), 0.01);
+  ImGui::DragFloat3("Scale", local.scale.data(), 0.01);
+  owner()->set_local_transform(local);
 
   auto const global = owner()->global_transform();
   ImGui::Text("Global:");
@@ -81,7 +83,7 @@ void debug_ui_component::ui()
   ImGui::PushStyleColor(ImGuiCol_ButtonHovered, ImVec4(0.8f, 0.1f, 0.0f, 1.0f));
   if (ImGui::Button("Destroy"))
   {
-    owner()->manager()->destroy(owner());
+    owner()->manager()->commands().destroy(owner());
   }
   ImGui::PopStyleColor(3);
 }
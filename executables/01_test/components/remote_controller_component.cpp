@@ -77,8 +77,9 @@ void remote_controller_component::update()
       }
     }
 
-    owner()->local_transform.rotation = rnu::slerp(
-      owner()->local_transform.rotation, _target_rotation, 10 * gev::engine::get().current_frame().delta_time);
+    auto& local = owner()->edit_local_transform();
+    local.rotation =
+      rnu::slerp(local.rotation, _target_rotation, 10 * gev::engine::get().current_frame().delta_time);
     _smooth.update(10 * gev::engine::get().current_frame().delta_time);
   }
 }
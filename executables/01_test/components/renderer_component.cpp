@@ -6,10 +6,22 @@ void renderer_component::spawn()
     set_shader(gev::game::shaders::standard);
 }
 
-void renderer_component::early_update()
+void renderer_component::register_system(gev::scenery::entity_manager& manager)
 {
-  if (_mesh_instance)
-    _mesh_instance->update_transform(owner()->global_transform().matrix());
+  manager.add_system(gev::scenery::system_phase::early_update,
+    [&manager]
+    {
+      manager.view<render_binding>().each(
+        [](gev::scenery::entity& e, render_binding& binding)
+        {
+          // Instances are only touched when their entity moved, so static ones are not uploaded again.
+          if (auto const version = e.transform_version(); version != binding.transform_version)
+          {
+            binding.instance->update_transform(e.global_transform().matrix());
+            binding.transform_version = version;
+          }
+        });
+    });
 }
 
 void renderer_component::deactivate()
@@ -50,6 +62,15 @@ gev::resource_id renderer_component::get_shader()
   return _shader_id;
 }
 
+void renderer_component::set_joint_offset(std::uint32_t offset)
+{
+  _joint_offset = offset;
+  if (_skinned_instance)
+    _skinned_instance->set_palette(offset);
+  else if (_mesh_instance)
+    _mesh_instance->update_joint_offset(offset);
+}
+
 void renderer_component::set_material(std::shared_ptr<gev::game::material> value)
 {
   _material = std::move(value);
@@ -59,7 +80,8 @@ void renderer_component::set_material(std::shared_ptr<gev::game::material> value
 void renderer_component::update_mesh()
 {
   try_destroy();
-  if (is_inherited_active())
+  // Entities outside of a manager cannot hold the render binding yet, they instantiate on activation.
+  if (is_inherited_active() && owner() && owner()->manager())
     try_instantiate();
 }
 
@@ -67,8 +89,11 @@ void renderer_component::try_destroy()
 {
   if (_mesh_instance)
   {
+    if (auto const o = owner())
+      o->detach<render_binding>();
     _mesh_instance->destroy();
     _mesh_instance = nullptr;
+    _skinned_instance = nullptr;
   }
 }
 
@@ -101,5 +126,19 @@ void renderer_component::deserialize(gev::serializer& base, std::istream& in)
 void renderer_component::try_instantiate()
 {
   if (_mesh && _shader && _material)
-    _mesh_instance = _renderer->batch(_shader, _material)->instantiate(_mesh, owner()->global_transform());
+  {
+    // Compute skinned meshes are skinned once per frame and drawn like static ones in every pass.
+    if (_mesh->is_skinned() && _shader_id.get() == gev::game::shaders::skinned.get() && _renderer->compute_skinning())
+    {
+      _skinned_instance = _renderer->skinning().add(_mesh);
+      _mesh_instance = _renderer->instantiate(gev::service<gev::game::shader_repo>()->get(gev::game::shaders::standard),
+        _material, _skinned_instance->target(), owner()->global_transform());
+    }
+    else
+      _mesh_instance = _renderer->instantiate(_shader, _material, _mesh, owner()->global_transform());
+
+    if (_joint_offset)
+      set_joint_offset(*_joint_offset);
+    owner()->attach<render_binding>(_mesh_instance);
+  }
 }
\ No newline at end of file
@@ -5,12 +5,23 @@
 #include <gev/game/mesh_batch.hpp>
 #include <gev/game/mesh_renderer.hpp>
 #include <gev/scenery/component.hpp>
+#include <gev/scenery/entity_manager.hpp>
+#include <optional>
+
+// Dense component attached to the owner while the mesh is instantiated, so that transforms can be pushed to the mesh
+// instances in one linear pass.
+struct render_binding
+{
+  std::shared_ptr<gev::game::mesh_instance> instance;
+  std::uint64_t transform_version = ~0ull;
+};
 
 class renderer_component : public gev::scenery::component
 {
 public:
+  static void register_system(gev::scenery::entity_manager& manager);
+
   void spawn() override;
-  void early_update() override;
   void activate() override;
   void deactivate() override;
 
@@ -22,6 +33,9 @@ public:
   void set_shader(gev::resource_id shader);
   gev::resource_id get_shader();
 
+  // Where the joint matrices of the skin of a skinned mesh start in the joint palette of the mesh renderer.
+  void set_joint_offset(std::uint32_t offset);
+
   void serialize(gev::serializer& base, std::ostream& out) override;
   void deserialize(gev::serializer& base, std::istream& in) override;
 
@@ -32,6 +46,8 @@ private:
 
   gev::service_proxy<gev::game::mesh_renderer> _renderer;
   std::shared_ptr<gev::game::mesh_instance> _mesh_instance;
+  std::shared_ptr<gev::game::skinned_instance> _skinned_instance;
+  std::optional<std::uint32_t> _joint_offset;
   std::shared_ptr<gev::game::mesh> _mesh;
   std::shared_ptr<gev::game::material> _material;
   gev::resource_id _shader_id;
@@ -7,7 +7,7 @@
 void shadow_map_component::spawn()
 {
   constexpr std::uint32_t size = 2048;
-  _csm = std::make_unique<gev::game::cascaded_shadow_mapping>(vk::Extent2D(size, size), 4, 0.6f);
+  _csm = std::make_unique<gev::game::cascaded_shadow_mapping>(vk::Extent2D(size, size), 0.6f);
 }
 
 void shadow_map_component::activate()
@@ -22,11 +22,13 @@ void shadow_map_component::deactivate()
 
 void shadow_map_component::late_update()
 {
-  if (auto const p = owner()->parent())
-    p->apply_transform();
-  else
-    owner()->apply_transform();
+  // Only recomputes what moved since the last call.
+  owner()->manager()->apply_transform();
+
+  // The shadow pass is the first one to draw this frame, the sync in the main loop does nothing afterwards.
+  auto const c = gev::current_frame().command_buffer;
+  _renderer->sync(c);
 
   auto const dir = owner()->global_transform().forward();
-  _csm->render(gev::current_frame().command_buffer, *_controls->main_camera, *_renderer, dir);
+  _csm->render(c, *_controls->main_camera, *_renderer, dir);
 }
\ No newline at end of file
@@ -1,41 +1,42 @@
 #include "skin_component.hpp"
 
 #include "bone_component.hpp"
+#include "renderer_component.hpp"
 
-#include <gev/descriptors.hpp>
 #include <gev/engine.hpp>
-#include <gev/game/layouts.hpp>
 #include <gev/game/mesh_renderer.hpp>
 
-skin_component::skin_component(gev::resource_id shader_id, gev::scenery::skin skin, gev::scenery::transform_tree tree,
-  std::unordered_map<std::string, gev::scenery::joint_animation> animations)
-  : _shader_id(shader_id), _skin(std::move(skin)), _tree(std::move(tree)), _animations(std::move(animations))
+namespace
+{
+  // Older assets store the skeleton inline, starting with the root node index of the skin.
+  constexpr std::size_t shared_skeleton_tag = ~0ull;
+}    // namespace
+
+skin_component::skin_component(gev::resource_id shader_id, std::shared_ptr<gev::scenery::skeleton const> skeleton)
+  : _shader_id(shader_id), _skeleton(std::move(skeleton)), _pose(_skeleton->rest_pose())
 {
 }
 
-vk::DescriptorSet skin_component::skin_descriptor() const
+skin_component::~skin_component()
 {
-  return _joints;
+  if (auto const palette = _joint_palette.lock(); palette && _palette_count != 0)
+    palette->free(_palette_offset, _palette_count);
 }
 
 void skin_component::early_update()
 {
-  if (!_joints)
-  {
-    auto const& layouts = gev::game::layouts::defaults();
-    _joints = gev::engine::get().get_descriptor_allocator().allocate(layouts.skinning_set_layout());
-  }
-
-  _shader_repo->get(_shader_id)->attach_always(_joints, gev::game::mesh_renderer::skin_set);
-  auto const iter = _animations.find(_current_animation);
-  if (iter != _animations.end())
+  auto const& animations = _skeleton->animations();
+  auto const iter = animations.find(_current_animation);
+  if (iter != animations.end())
   {
     if (!_running)
     {
       _running = true;
-      iter->second.start();
+      _playback = iter->second;
+      _playback.start();
     }
-    _tree.animate(iter->second, std::chrono::duration<double>(gev::engine::get().current_frame().delta_time));
+    _pose.animate(_skeleton->rest_pose(), _playback,
+      std::chrono::duration<double>(gev::engine::get().current_frame().delta_time));
 
     if (auto const p = owner()->parent())
       apply_child_transform(*p);
@@ -43,14 +44,29 @@ void skin_component::early_update()
       apply_child_transform(*owner());
   }
 
-  auto const& mats = _skin.apply_global_transforms(_tree);
+  _skeleton->joints().apply_global_transforms(_pose, _palette);
+  if (_palette.empty())
+    return;
 
-  if (!_joints_buffer)
+  auto const palette = _renderer->palette();
+  if (_joint_palette.lock() != palette || _palette_count != _palette.size())
+  {
+    if (auto const previous = _joint_palette.lock(); previous && _palette_count != 0)
+      previous->free(_palette_offset, _palette_count);
+    _joint_palette = palette;
+    _palette_count = std::uint32_t(_palette.size());
+    _palette_offset = palette->allocate(_palette);
+  }
+  else
   {
-    _joints_buffer = gev::buffer::host_local(mats.size() * sizeof(rnu::mat4), vk::BufferUsageFlagBits::eStorageBuffer);
-    gev::update_descriptor(_joints, 0, *_joints_buffer, vk::DescriptorType::eStorageBuffer);
+    palette->write(_palette_offset, _palette);
   }
-  _joints_buffer->load_data<rnu::mat4>(mats);
+
+  // Renderers keep the offset when they are instantiated again, ones added later pick it up in the next frame.
+  if (auto const p = owner()->parent())
+    attach_palette(*p);
+  else
+    attach_palette(*owner());
 }
 
 void skin_component::set_animation(std::string name)
@@ -64,35 +80,37 @@ void skin_component::set_animation(std::string name)
 
 std::unordered_map<std::string, gev::scenery::joint_animation> const& skin_component::animations() const
 {
-  return _animations;
+  return _skeleton->animations();
 }
 
 void skin_component::apply_child_transform(gev::scenery::entity& e)
 {
   if (auto const bone = e.get<bone_component>())
   {
-    bone->owner()->local_transform = _tree.nodes()[_skin.joint_node(bone->index())].transformation.matrix();
+    bone->owner()->set_local_transform(_pose.local_transform(_skeleton->joints().joint_node(bone->index())));
   }
 
   for (auto const& c : e.children())
     apply_child_transform(*c);
 }
 
+void skin_component::attach_palette(gev::scenery::entity& e)
+{
+  if (auto const renderer = e.get<renderer_component>())
+    renderer->set_joint_offset(_palette_offset);
+
+  for (auto const& c : e.children())
+    attach_palette(*c);
+}
+
 void skin_component::serialize(gev::serializer& base, std::ostream& out)
 {
   gev::scenery::component::serialize(base, out);
 
   write_typed(_shader_id, out);
   write_string(_current_animation, out);
-  _skin.serialize(base, out);
-  _tree.serialize(base, out);
-
-  write_size(_animations.size(), out);
-  for (auto& [name, anim] : _animations)
-  {
-    write_string(name, out);
-    anim.serialize(base, out);
-  }
+  write_size(shared_skeleton_tag, out);
+  base.write_direct_or_reference(out, std::const_pointer_cast<gev::scenery::skeleton>(_skeleton));
 }
 
 void skin_component::deserialize(gev::serializer& base, std::istream& in)
@@ -101,16 +119,19 @@ void skin_component::deserialize(gev::serializer& base, std::istream& in)
 
   read_typed(_shader_id, in);
   read_string(_current_animation, in);
-  _skin.deserialize(base, in);
-  _tree.deserialize(base, in);
 
-  std::size_t count = 0ull;
-  read_size(count, in);
-  for (std::size_t i = 0; i < count; ++i)
+  auto const start = in.tellg();
+  std::size_t tag = 0;
+  read_size(tag, in);
+  if (tag == shared_skeleton_tag)
+    _skeleton = as<gev::scenery::skeleton>(base.read_direct_or_reference(in));
+  else
   {
-    std::string name;
-    read_string(name, in);
-    _animations[name].deserialize(base, in);
+    in.seekg(start);
+    auto const inline_skeleton = std::make_shared<gev::scenery::skeleton>();
+    inline_skeleton->deserialize(base, in);
+    _skeleton = inline_skeleton;
   }
+  _pose = gev::scenery::skeleton_pose(_skeleton->rest_pose());
   _running = false;
 }
\ No newline at end of file
@@ -1,8 +1,8 @@
 #pragma once
 
-#include <gev/buffer.hpp>
 #include <gev/scenery/component.hpp>
 #include <gev/scenery/gltf.hpp>
+#include <gev/game/mesh_renderer.hpp>
 #include <gev/game/shader.hpp>
 #include <gev/engine.hpp>
 
@@ -10,10 +10,9 @@ class skin_component : public gev::scenery::component
 {
 public:
   skin_component() = default;
-  skin_component(gev::resource_id shader_id, gev::scenery::skin skin, gev::scenery::transform_tree tree,
-    std::unordered_map<std::string, gev::scenery::joint_animation> animations);
+  skin_component(gev::resource_id shader_id, std::shared_ptr<gev::scenery::skeleton const> skeleton);
+  ~skin_component();
 
-  vk::DescriptorSet skin_descriptor() const;
   void early_update() override;
 
   void set_animation(std::string name);
@@ -24,15 +23,18 @@ public:
 
 private:
   void apply_child_transform(gev::scenery::entity& e);
+  void attach_palette(gev::scenery::entity& e);
 
   std::string _current_animation = "";
   bool _running = false;
   
   gev::resource_id _shader_id;
-  vk::DescriptorSet _joints;
-  std::unique_ptr<gev::buffer> _joints_buffer;
-  gev::scenery::skin _skin;
-  gev::scenery::transform_tree _tree;
-  std::unordered_map<std::string, gev::scenery::joint_animation> _animations;
-  gev::service_proxy<gev::game::shader_repo> _shader_repo;
+  std::shared_ptr<gev::scenery::skeleton const> _skeleton;
+  gev::scenery::skeleton_pose _pose;
+  gev::scenery::joint_animation _playback;
+  std::vector<rnu::mat4> _palette;
+  std::weak_ptr<gev::game::joint_palette> _joint_palette;
+  std::uint32_t _palette_offset = 0;
+  std::uint32_t _palette_count = 0;
+  gev::service_proxy<gev::game::mesh_renderer> _renderer;
 };
\ No newline at end of file
@@ -3,6 +3,7 @@
 #include <gev/game/samplers.hpp>
 #include <gev/game/camera.hpp>
 #include <gev/game/layouts.hpp>
+#include <gev/gpu_profiler.hpp>
 
 environment::environment(vk::Format cube_format) : _format(cube_format)
 {
@@ -86,6 +87,7 @@ void environment::render_cube(vk::CommandBuffer c)
 
 void environment::render(vk::CommandBuffer c, std::int32_t x, std::int32_t y, std::uint32_t w, std::uint32_t h)
 {
+  auto const scope = gev::profile_gpu(c, "environment::render");
   _renderer->begin_render(c, false);
   _forward_shader->bind(c, gev::game::pass_id::forward);
   c.setViewport(0, vk::Viewport(float(x), float(y), float(w), float(h), 0.f, 1.f));
@@ -11,7 +11,8 @@
 #include <gev/scenery/entity_manager.hpp>
 
 std::shared_ptr<gev::scenery::entity> child_from_node(std::shared_ptr<gev::scenery::entity> e, std::uint32_t node_index,
-  gev::scenery::transform_node const& node, gev::scenery::gltf_data const& gltf)
+  gev::scenery::transform_node const& node, gev::scenery::gltf_data const& gltf,
+  std::shared_ptr<gev::scenery::skeleton const> const& skeleton)
 {
   auto entity_manager = gev::service<gev::scenery::entity_manager>();
   auto shader_repo = gev::service<gev::game::shader_repo>();
@@ -20,12 +21,12 @@ std::shared_ptr<gev::scenery::entity> child_from_node(std::shared_ptr<gev::scene
   //auto const default_shader = shader_repo->get(gev::game::shaders::standard);
 
   auto ptcl = entity_manager->instantiate(e);
-  ptcl->local_transform = node.transformation.matrix();
+  ptcl->set_local_transform(node.transformation.matrix());
   ptcl->emplace<debug_ui_component>(node.name);
 
   if (gltf.skins[0].root_node() == node_index)
   {
-    ptcl->emplace<skin_component>(gev::game::shaders::skinned, gltf.skins[0], gltf.nodes, gltf.animations);
+    ptcl->emplace<skin_component>(gev::game::shaders::skinned, skeleton);
   }
   else if (auto const node = gltf.skins[0].find_joint_index(node_index))
   {
@@ -74,22 +75,29 @@ std::shared_ptr<gev::scenery::entity> child_from_node(std::shared_ptr<gev::scene
 }
 
 void emplace_children(std::shared_ptr<gev::scenery::entity> e, gev::scenery::transform_node const& node,
-  gev::scenery::gltf_data const& gltf)
+  gev::scenery::gltf_data const& gltf, std::shared_ptr<gev::scenery::skeleton const> const& skeleton)
 {
   for (std::size_t i = 0; i < node.num_children; ++i)
   {
     auto const index = i + node.children_offset;
     auto const& child = gltf.nodes.nodes()[index];
-    auto const ptcl = child_from_node(e, index, child, gltf);
-    emplace_children(ptcl, child, gltf);
+    auto const ptcl = child_from_node(e, index, child, gltf, skeleton);
+    emplace_children(ptcl, child, gltf, skeleton);
   }
 }
 
 std::shared_ptr<gev::scenery::entity> load_gltf_entity(std::filesystem::path const& path)
 {
   auto gltf = gev::scenery::load_gltf(path);
+
+  // Every character loaded from the same file shares one skeleton resource, also when saved.
+  auto const serializer = gev::service<gev::serializer>();
+  auto const skeleton = as<gev::scenery::skeleton>(serializer->initial_load(
+    std::filesystem::path(path).replace_extension("skeleton.gevas"),
+    [&] { return std::make_shared<gev::scenery::skeleton>(gltf.skins[0], gltf.nodes, std::move(gltf.animations)); }));
+
   gev::scenery::transform_node const root = gltf.nodes.nodes()[0];
-  auto const root_entity = child_from_node(nullptr, 0, root, gltf);
-  emplace_children(root_entity, root, gltf);
+  auto const root_entity = child_from_node(nullptr, 0, root, gltf, skeleton);
+  emplace_children(root_entity, root, gltf, skeleton);
   return root_entity;
 }
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include "post_process.hpp"
+#include <gev/gpu_profiler.hpp>
 #include <gev/imgui/imgui.h>
 
 post_process::post_process(vk::Format format) : _format(format) {}
@@ -20,13 +21,35 @@ gev::game::render_target_2d const& post_process::process(vk::CommandBuffer c, ge
   constexpr float vignette = 0.44f;
   constexpr float grain = 0.08f;
 
-  _cutoff.apply(c, 1.0f, in, b);
-  _blur.apply(c, gev::game::blur_dir::horizontal, blur_size, b, a);
-  _blur.apply(c, gev::game::blur_dir::vertical, blur_size, a, b);
-  _addition.apply(c, bloom_factor, in, b, a);
-  _tonemap.apply(c, gamma, a, b);
-  _vignette.apply(c, vignette, b, a);
-  _film_grain.apply(c, grain, a, b);
+  auto const scope = gev::profile_gpu(c, "post_process");
+  {
+    auto const stage = gev::profile_gpu(c, "cutoff");
+    _cutoff.apply(c, 1.0f, in, b);
+  }
+  {
+    auto const stage = gev::profile_gpu(c, "blur horizontal");
+    _blur.apply(c, gev::game::blur_dir::horizontal, blur_size, b, a);
+  }
+  {
+    auto const stage = gev::profile_gpu(c, "blur vertical");
+    _blur.apply(c, gev::game::blur_dir::vertical, blur_size, a, b);
+  }
+  {
+    auto const stage = gev::profile_gpu(c, "addition");
+    _addition.apply(c, bloom_factor, in, b, a);
+  }
+  {
+    auto const stage = gev::profile_gpu(c, "tonemap");
+    _tonemap.apply(c, gamma, a, b);
+  }
+  {
+    auto const stage = gev::profile_gpu(c, "vignette");
+    _vignette.apply(c, vignette, b, a);
+  }
+  {
+    auto const stage = gev::profile_gpu(c, "film_grain");
+    _film_grain.apply(c, grain, a, b);
+  }
 
   return b;
 }
@@ -12,8 +12,8 @@ layout(set = 0, binding = 0) uniform Camera
 
 struct entity_info
 {
-  mat4 transform;
-  mat4 inverse_transform;
+  vec4 transform[3];
+  uint material_index;
 };
 
 layout(set = 3, binding = 0) restrict readonly buffer EntityInfos
@@ -21,6 +21,18 @@ layout(set = 3, binding = 0) restrict readonly buffer EntityInfos
   entity_info entity_infos[];
 };
 
+// Instances store the rows of their affine transform.
+mat4 entity_transform(entity_info info)
+{
+  return transpose(mat4(info.transform[0], info.transform[1], info.transform[2], vec4(0, 0, 0, 1)));
+}
+
+// The cofactor matrix is the inverse transpose scaled by the determinant, the fragment shader normalizes it away.
+mat3 normal_matrix(mat3 m)
+{
+  return mat3(cross(m[1], m[2]), cross(m[2], m[0]), cross(m[0], m[1])) * sign(determinant(m));
+}
+
 layout(location = 0) out vec3 vertex_position;
 layout(location = 1) out vec3 vertex_normal;
 layout(location = 2) out vec2 vertex_texcoord;
@@ -32,7 +44,7 @@ void main()
   
   entity_info info = entity_infos[gl_InstanceIndex];
 
-  mat4 modelView = camera.view_matrix * info.transform;
+  mat4 modelView = camera.view_matrix * entity_transform(info);
   
   modelView[0][0] = 1.0; 
   modelView[0][1] = 0.0; 
@@ -46,7 +58,7 @@ void main()
   float height = texcoord.y;
   float offset_pos = height * height * 0.3;
 
-  vertex_normal = (transpose(inverse(transform)) * vec4(normal, 0)).xyz;
+  vertex_normal = normal_matrix(mat3(transform)) * normal;
   vertex_color = vec3(0.1, 0.6, 0.0);
   vec4 pos = transform * vec4(position.xyz, 1);
 
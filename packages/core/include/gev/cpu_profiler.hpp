@@ -0,0 +1,102 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <filesystem>
+#include <gev/trace.hpp>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#define GEV_PROFILE_CONCAT_IMPL(a, b) a##b
+#define GEV_PROFILE_CONCAT(a, b)      GEV_PROFILE_CONCAT_IMPL(a, b)
+#define GEV_PROFILE_ZONE(name)        ::gev::cpu_profiler::zone GEV_PROFILE_CONCAT(gev_profile_zone_, __LINE__)(name)
+#define GEV_PROFILE_FUNCTION()        GEV_PROFILE_ZONE(__func__)
+
+namespace gev
+{
+  struct cpu_zone_statistics
+  {
+    std::string name;
+    double last_ms = 0.0;
+    double min_ms = 0.0;
+    double avg_ms = 0.0;
+    double p99_ms = 0.0;
+    double max_ms = 0.0;
+    std::size_t num_samples = 0;
+  };
+
+  class cpu_profiler
+  {
+  public:
+    static constexpr std::size_t ring_capacity = 1 << 14;
+    static constexpr std::size_t max_samples = 512;
+    static constexpr std::size_t max_trace_events = 1 << 18;
+
+    class zone
+    {
+    public:
+      explicit zone(char const* name);
+      ~zone();
+
+      zone(zone const&) = delete;
+      zone& operator=(zone const&) = delete;
+
+    private:
+      char const* _name;
+      std::uint64_t _begin_ns;
+    };
+
+    static cpu_profiler& get();
+
+    void set_enabled(bool enabled);
+    bool enabled() const noexcept;
+
+    // Drains the per-thread rings. Call once per frame from the main thread.
+    void collect();
+
+    std::vector<cpu_zone_statistics> statistics() const;
+    std::vector<trace_event> trace_events() const;
+    std::size_t num_dropped() const noexcept;
+    void draw_overlay();
+    void write_trace(std::filesystem::path const& path) const;
+
+    // Nanoseconds since the profiler was created, the timebase of all zones and trace events.
+    std::uint64_t now_ns() const;
+
+  private:
+    struct record
+    {
+      char const* name = nullptr;
+      std::uint64_t begin_ns = 0;
+      std::uint64_t end_ns = 0;
+    };
+
+    struct thread_ring
+    {
+      std::uint32_t thread_id = 0;
+      std::array<record, ring_capacity> records;
+      std::atomic<std::uint64_t> head = 0;
+      std::atomic<std::uint64_t> tail = 0;
+    };
+
+    cpu_profiler();
+
+    thread_ring& local_ring();
+    void push(record const& r);
+
+    std::chrono::steady_clock::time_point _epoch;
+    std::atomic_bool _enabled = true;
+    std::atomic<std::size_t> _dropped = 0;
+
+    std::mutex _rings_mutex;
+    std::vector<std::unique_ptr<thread_ring>> _rings;
+
+    std::unordered_map<std::string, std::deque<double>> _samples;
+    std::deque<trace_event> _events;
+  };
+}    // namespace gev
@@ -12,10 +12,12 @@
 #include <gev/image.hpp>
 #include <gev/imgui/imgui.h>
 #include <gev/logger.hpp>
+#include <gev/pipeline_cache.hpp>
 #include <gev/res/repo.hpp>
 #include <gev/service_locator.hpp>
 #include <gev/vma.hpp>
 #include <gev/window.hpp>
+#include <optional>
 #include <string>
 #include <unordered_map>
 
@@ -52,6 +54,7 @@ namespace gev
   {
     double delta_time = 0.0;
     std::uint32_t frame_index = 0;
+    std::uint64_t frame_number = 0;
     std::shared_ptr<image> output_image;
     vk::ImageView output_view;
     vk::CommandBuffer command_buffer;
@@ -59,6 +62,16 @@ namespace gev
     void present_image(image& source) const;
   };
 
+  struct headless_options
+  {
+    constexpr static std::uint32_t default_num_frames = 300;
+
+    // Zero renders until the application closes the window itself.
+    std::uint32_t num_frames = default_num_frames;
+    vk::Format format = vk::Format::eB8G8R8A8Srgb;
+    bool prefer_software_device = true;
+  };
+
   using audio_repo = repo<audio::sound>;
 
   class engine
@@ -76,6 +89,14 @@ namespace gev
       ImGui::SetCurrentContext(_imgui_context);
     }
 
+    void start_headless(std::string const& title, int width, int height, headless_options const& options = {})
+    {
+      _headless = options;
+      start_impl(title, width, height);
+      ImGui::SetCurrentContext(_imgui_context);
+    }
+
+    bool headless() const noexcept;
     int run(std::function<bool(frame const& f)> runnable);
     void on_resized(std::function<void(int w, int h)> callback);
     std::uint32_t num_images() const noexcept;
@@ -89,6 +110,8 @@ namespace gev
     vk::PhysicalDevice physical_device() const;
     vk::Device device() const;
     shared_allocator const& allocator() const;
+    pipeline_cache& pipelines();
+    pipeline_cache const& pipelines() const;
     queues const& queues() const;
     GLFWwindow* window() const;
     vk::SurfaceKHR window_surface() const;
@@ -122,10 +145,12 @@ namespace gev
     unique_allocator create_allocator();
     void open_window(std::string const& title, int width, int height);
     void create_swapchain();
+    void create_offscreen_targets();
 
     static std::unique_ptr<engine> _engine;
 
     gev::logger _logger;
+    std::optional<headless_options> _headless;
 
     vk::UniqueInstance _instance;
     vk::PhysicalDevice _physical_device;
@@ -133,6 +158,7 @@ namespace gev
     vk::PhysicalDeviceProperties _physical_device_properties;
     VmaVulkanFunctions _vma_functions{};
     shared_allocator _allocator;
+    std::unique_ptr<pipeline_cache> _pipeline_cache;
     gev::queues _queues;
     vk::Format _depth_format;
     vk::UniqueDebugUtilsMessengerEXT _debug_messenger;
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <deque>
+#include <filesystem>
+#include <gev/trace.hpp>
+#include <string>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+
+namespace gev
+{
+  struct gpu_scope_timing
+  {
+    std::string name;
+    std::uint32_t depth = 0;
+    double begin_ms = 0.0;
+    double duration_ms = 0.0;
+  };
+
+  struct gpu_frame_timings
+  {
+    std::uint64_t frame_number = 0;
+    // On the timebase of the CPU profiler, so both can be shown in one trace.
+    double start_us = 0.0;
+    double duration_ms = 0.0;
+    std::vector<gpu_scope_timing> scopes;
+  };
+
+  class gpu_profiler
+  {
+  public:
+    static constexpr std::uint32_t max_scopes = 256;
+    static constexpr std::size_t max_history = 300;
+
+    class scope
+    {
+    public:
+      scope() = default;
+      scope(gpu_profiler* profiler, vk::CommandBuffer c, std::uint32_t index);
+      scope(scope&& other) noexcept;
+      scope& operator=(scope&& other) noexcept;
+      ~scope();
+
+    private:
+      gpu_profiler* _profiler = nullptr;
+      vk::CommandBuffer _command_buffer;
+      std::uint32_t _index = 0;
+    };
+
+    gpu_profiler();
+
+    void set_enabled(bool enabled);
+    bool enabled() const noexcept;
+    bool supported() const noexcept;
+
+    void begin_frame(vk::CommandBuffer c, std::uint32_t frame_index);
+    [[nodiscard]] scope begin_scope(vk::CommandBuffer c, std::string name);
+    // Timestamps in a pass with a view mask write one query per view, scopes are not recorded in between. Scopes must
+    // not cross the boundaries of such a pass.
+    void begin_multiview();
+    void end_multiview();
+
+    std::deque<gpu_frame_timings> const& history() const noexcept;
+    std::vector<trace_event> trace_events() const;
+    void draw_overlay();
+    void write_trace(std::filesystem::path const& path) const;
+
+  private:
+    static constexpr std::uint32_t invalid_scope = ~0u;
+
+    struct recorded_scope
+    {
+      std::string name;
+      std::uint32_t depth = 0;
+    };
+
+    struct frame_queries
+    {
+      vk::UniqueQueryPool pool;
+      std::vector<recorded_scope> scopes;
+      std::uint64_t frame_number = 0;
+    };
+
+    void calibrate();
+    double to_cpu_us(std::uint64_t tick) const;
+    std::uint32_t begin(vk::CommandBuffer c, std::string name);
+    void end(vk::CommandBuffer c, std::uint32_t index);
+    void collect(frame_queries& frame);
+
+    bool _enabled = true;
+    bool _supported = false;
+    double _timestamp_period = 1.0;
+    std::uint64_t _timestamp_mask = ~0ull;
+    // A GPU timestamp and the time of the CPU profiler it was taken at, GPU events are placed on the CPU timebase.
+    std::uint64_t _calibration_tick = 0;
+    std::uint64_t _calibration_ns = 0;
+    std::uint64_t _frame_number = 0;
+    std::uint32_t _depth = 0;
+    bool _multiview = false;
+    std::vector<frame_queries> _frames;
+    frame_queries* _current = nullptr;
+    std::deque<gpu_frame_timings> _history;
+  };
+
+  [[nodiscard]] gpu_profiler::scope profile_gpu(vk::CommandBuffer c, std::string name);
+}    // namespace gev
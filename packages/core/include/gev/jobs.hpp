@@ -0,0 +1,118 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <vector>
+
+namespace gev
+{
+  enum class job_affinity
+  {
+    any,
+    // Only executed on the thread that created the job system, e.g. for recording or submitting Vulkan work.
+    main_thread
+  };
+
+  // Handle to a scheduled job. It can be waited on and passed as a dependency of other jobs.
+  class job
+  {
+    friend class jobs;
+
+  public:
+    job() = default;
+
+    bool valid() const noexcept;
+    bool done() const noexcept;
+
+  private:
+    struct state;
+
+    explicit job(std::shared_ptr<state> s);
+
+    std::shared_ptr<state> _state;
+  };
+
+  // Work-stealing scheduler. Every worker owns a deque, it pops its own jobs LIFO and steals from the others FIFO.
+  // Threads outside of the pool push into a shared deque that the workers steal from.
+  class jobs
+  {
+  public:
+    static std::size_t default_num_workers();
+
+    explicit jobs(std::size_t num_workers = default_num_workers());
+    ~jobs();
+
+    jobs(jobs const&) = delete;
+    jobs& operator=(jobs const&) = delete;
+
+    job run(std::function<void()> func, job_affinity affinity = job_affinity::any);
+    // The job is scheduled once all dependencies have finished, whether they threw or not.
+    job run_after(
+      std::span<job const> dependencies, std::function<void()> func, job_affinity affinity = job_affinity::any);
+    job run_after(job const& dependency, std::function<void()> func, job_affinity affinity = job_affinity::any);
+
+    // Blocks until the jobs have finished and rethrows the first exception thrown by one of them. The calling thread
+    // executes pending jobs while waiting, the main thread also executes main thread jobs.
+    void wait(job const& j);
+    void wait(std::span<job const> js);
+
+    // Executes all main thread jobs that are ready. The engine calls this once per frame.
+    void run_main_thread_jobs();
+
+    // Splits [0, count) into batches of batch_size and calls func(begin, end) for each batch in parallel. Returns when
+    // all batches are done. A batch_size of 0 picks one that gives each thread a few batches to steal.
+    void parallel_for(std::size_t count, std::function<void(std::size_t begin, std::size_t end)> const& func,
+      std::size_t batch_size = 0);
+
+    template<typename T, typename Func>
+    void parallel_for(std::span<T> items, Func&& func, std::size_t batch_size = 0)
+    {
+      parallel_for(
+        items.size(),
+        [&](std::size_t begin, std::size_t end)
+        {
+          for (auto& item : items.subspan(begin, end - begin))
+            func(item);
+        },
+        batch_size);
+    }
+
+    std::size_t num_workers() const noexcept;
+    bool is_main_thread() const noexcept;
+
+  private:
+    struct worker_queue;
+
+    void schedule(std::shared_ptr<job::state> s);
+    void release(std::shared_ptr<job::state> const& s);
+    void execute(std::shared_ptr<job::state> const& s);
+    std::shared_ptr<job::state> take(std::size_t queue);
+    std::shared_ptr<job::state> take_main_thread_job();
+    bool try_run_one(bool main_thread);
+    void sleep_until_done(job const& j, bool main_thread);
+    void worker_main(std::size_t queue);
+    std::size_t local_queue() const;
+
+    std::thread::id _main_thread;
+    // Index 0 is shared by all threads outside of the pool, workers own the ones after it.
+    std::vector<std::unique_ptr<worker_queue>> _queues;
+    std::unique_ptr<worker_queue> _main_queue;
+
+    std::atomic<std::int64_t> _queued = 0;
+    std::atomic<std::int64_t> _main_queued = 0;
+    std::atomic<std::int64_t> _sleeping = 0;
+    std::atomic<std::int64_t> _waiting = 0;
+    std::atomic_bool _stop = false;
+    std::mutex _sleep_mutex;
+    std::condition_variable _work_available;
+    std::condition_variable _job_done;
+
+    std::vector<std::jthread> _workers;
+  };
+}    // namespace gev
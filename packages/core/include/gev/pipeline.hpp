@@ -52,6 +52,7 @@ namespace gev
     simple_pipeline_builder& stencil_attachment(vk::Format format);
     simple_pipeline_builder& raster_discard(bool discard);
     simple_pipeline_builder& cull(vk::CullModeFlags mode);
+    simple_pipeline_builder& view_mask(std::uint32_t mask);
 
     void clear();
     vk::UniquePipeline build();
@@ -74,5 +75,6 @@ namespace gev
     vk::PrimitiveTopology _topology = vk::PrimitiveTopology::eTriangleList;
     vk::CullModeFlags _cull = vk::CullModeFlagBits::eBack;
     bool _raster_discard = false;
+    std::uint32_t _view_mask = 0;
   };
 }    // namespace gev
\ No newline at end of file
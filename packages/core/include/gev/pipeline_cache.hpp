@@ -0,0 +1,36 @@
+#pragma once
+
+#include <filesystem>
+#include <functional>
+#include <future>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+
+namespace gev
+{
+  class pipeline_cache
+  {
+  public:
+    static constexpr char const* default_path = "pipeline_cache.bin";
+
+    pipeline_cache(vk::Device device, vk::PhysicalDeviceProperties const& properties,
+      std::filesystem::path path = default_path);
+
+    vk::PipelineCache get() const;
+    std::filesystem::path const& path() const;
+    bool loaded_from_disk() const;
+
+    bool save() const;
+
+    // Runs the builders on worker threads. Every pipeline they create ends up in this cache, so later builds of
+    // the same pipelines on the render thread are cheap.
+    [[nodiscard]] std::future<void> prewarm(std::vector<std::function<void()>> builders) const;
+
+  private:
+    bool is_compatible(std::span<std::byte const> data, vk::PhysicalDeviceProperties const& properties) const;
+
+    std::filesystem::path _path;
+    vk::UniquePipelineCache _cache;
+    bool _loaded_from_disk = false;
+  };
+}    // namespace gev
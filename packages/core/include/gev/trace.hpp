@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <string>
+
+namespace gev
+{
+  struct trace_event
+  {
+    std::string name;
+    std::string category;
+    double start_us = 0.0;
+    double duration_us = 0.0;
+    std::uint32_t process_id = 0;
+    std::uint32_t thread_id = 0;
+  };
+
+  void write_chrome_trace(std::filesystem::path const& path, std::span<trace_event const> events);
+}    // namespace gev
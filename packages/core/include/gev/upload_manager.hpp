@@ -0,0 +1,89 @@
+#pragma once
+
+#include <deque>
+#include <functional>
+#include <gev/buffer.hpp>
+#include <gev/image.hpp>
+#include <memory>
+#include <optional>
+#include <span>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+
+namespace gev
+{
+  struct upload_ticket
+  {
+    std::uint64_t value = 0;
+  };
+
+  class upload_manager
+  {
+  public:
+    static constexpr std::size_t default_staging_size = 64ull << 20;
+    static constexpr std::size_t staging_alignment = 16;
+
+    upload_manager(std::size_t staging_size = default_staging_size);
+    ~upload_manager();
+
+    upload_ticket upload(std::shared_ptr<buffer> dst, void const* data, std::size_t size, std::size_t dst_offset = 0);
+    upload_ticket upload(std::shared_ptr<image> dst, void const* data, std::size_t size,
+      std::span<vk::BufferImageCopy const> regions, std::function<void(vk::CommandBuffer c)> on_acquire = {});
+
+    template<typename T>
+    upload_ticket upload(std::shared_ptr<buffer> dst, std::span<T const> data, std::size_t dst_offset = 0)
+    {
+      return upload(std::move(dst), data.data(), data.size_bytes(), dst_offset);
+    }
+
+    // Submits all recorded uploads to the transfer queue.
+    void flush();
+    // Takes ownership of all finished uploads on the graphics queue. Submissions containing c have to wait for the
+    // returned ticket on the timeline semaphore.
+    upload_ticket acquire(vk::CommandBuffer c);
+
+    bool is_complete(upload_ticket ticket) const;
+    void wait(upload_ticket ticket);
+    void wait_all();
+
+    vk::Semaphore timeline() const;
+
+  private:
+    struct batch
+    {
+      std::uint64_t value = 0;
+      vk::UniqueCommandBuffer command_buffer;
+      std::uint64_t staging_end = 0;
+      std::vector<std::unique_ptr<buffer>> dedicated_staging;
+    };
+
+    struct pending_acquire
+    {
+      std::uint64_t value = 0;
+      std::shared_ptr<buffer> target_buffer;
+      std::size_t offset = 0;
+      std::size_t size = 0;
+      std::shared_ptr<image> target_image;
+      std::function<void(vk::CommandBuffer c)> on_acquire;
+    };
+
+    batch& open_batch();
+    std::pair<vk::Buffer, std::size_t> stage(void const* data, std::size_t size);
+    void retire(std::uint64_t completed);
+    void finish_pending();
+    bool needs_ownership_transfer() const;
+
+    std::size_t _staging_size;
+    std::unique_ptr<buffer> _staging;
+    std::uint64_t _staging_head = 0;
+    std::uint64_t _staging_tail = 0;
+
+    vk::UniqueSemaphore _timeline;
+    std::uint64_t _next_value = 1;
+    std::uint64_t _acquired_value = 0;
+
+    std::optional<batch> _open_batch;
+    std::deque<batch> _in_flight;
+    std::deque<pending_acquire> _pending;
+  };
+}    // namespace gev
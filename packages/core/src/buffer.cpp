@@ -86,6 +86,7 @@ namespace gev
       vmaGetAllocationInfo(allocator.get(), _allocation.get(), &ai);
 
       void* memory = nullptr;
+      vmaInvalidateAllocation(allocator.get(), _allocation.get(), offset, size);
       vmaMapMemory(allocator.get(), _allocation.get(), &memory);
       std::byte* src = static_cast<std::byte*>(memory) + offset;
       std::memcpy(data, src, size);
@@ -96,8 +97,8 @@ namespace gev
       auto const pool = engine::get().queues().transfer_command_pool.get();
 
       auto const staging_buffer = host_local(size, vk::BufferUsageFlagBits::eTransferDst);
-      engine::get().execute_once([&](auto c) { copy_to(c, *staging_buffer, size, 0, offset); }, pool, true);
-      staging_buffer->get_data(data, size, offset);
+      engine::get().execute_once([&](auto c) { copy_to(c, *staging_buffer, size, offset, 0); }, pool, true);
+      staging_buffer->get_data(data, size, 0);
     }
   }
 
@@ -0,0 +1,207 @@
+#include <algorithm>
+#include <gev/cpu_profiler.hpp>
+#include <gev/imgui/imgui.h>
+
+namespace gev
+{
+  cpu_profiler::zone::zone(char const* name) : _name(name), _begin_ns(0)
+  {
+    auto& profiler = cpu_profiler::get();
+    if (profiler.enabled())
+      _begin_ns = profiler.now_ns();
+    else
+      _name = nullptr;
+  }
+
+  cpu_profiler::zone::~zone()
+  {
+    if (!_name)
+      return;
+    auto& profiler = cpu_profiler::get();
+    profiler.push(record{_name, _begin_ns, profiler.now_ns()});
+  }
+
+  cpu_profiler& cpu_profiler::get()
+  {
+    static cpu_profiler profiler;
+    return profiler;
+  }
+
+  cpu_profiler::cpu_profiler() : _epoch(std::chrono::steady_clock::now()) {}
+
+  void cpu_profiler::set_enabled(bool enabled)
+  {
+    _enabled = enabled;
+  }
+
+  bool cpu_profiler::enabled() const noexcept
+  {
+    return _enabled.load(std::memory_order_relaxed);
+  }
+
+  std::size_t cpu_profiler::num_dropped() const noexcept
+  {
+    return _dropped.load(std::memory_order_relaxed);
+  }
+
+  std::uint64_t cpu_profiler::now_ns() const
+  {
+    return std::uint64_t(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - _epoch).count());
+  }
+
+  cpu_profiler::thread_ring& cpu_profiler::local_ring()
+  {
+    thread_local thread_ring* ring = nullptr;
+    if (!ring)
+    {
+      std::unique_lock lock(_rings_mutex);
+      auto& r = _rings.emplace_back(std::make_unique<thread_ring>());
+      r->thread_id = std::uint32_t(_rings.size() - 1);
+      ring = r.get();
+    }
+    return *ring;
+  }
+
+  void cpu_profiler::push(record const& r)
+  {
+    auto& ring = local_ring();
+    auto const head = ring.head.load(std::memory_order_relaxed);
+    if (head - ring.tail.load(std::memory_order_acquire) >= ring_capacity)
+    {
+      _dropped.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+    ring.records[head % ring_capacity] = r;
+    ring.head.store(head + 1, std::memory_order_release);
+  }
+
+  void cpu_profiler::collect()
+  {
+    std::vector<thread_ring*> rings;
+    {
+      std::unique_lock lock(_rings_mutex);
+      rings.reserve(_rings.size());
+      for (auto const& r : _rings)
+        rings.push_back(r.get());
+    }
+
+    for (auto* ring : rings)
+    {
+      auto const head = ring->head.load(std::memory_order_acquire);
+      auto tail = ring->tail.load(std::memory_order_relaxed);
+      for (; tail != head; ++tail)
+      {
+        auto const& r = ring->records[tail % ring_capacity];
+        auto const duration_ns = r.end_ns - std::min(r.end_ns, r.begin_ns);
+
+        auto& samples = _samples[r.name];
+        samples.push_back(double(duration_ns) * 1e-6);
+        if (samples.size() > max_samples)
+          samples.pop_front();
+
+        _events.push_back(trace_event{
+          .name = r.name,
+          .category = "cpu",
+          .start_us = double(r.begin_ns) * 1e-3,
+          .duration_us = double(duration_ns) * 1e-3,
+          .process_id = 0,
+          .thread_id = ring->thread_id,
+        });
+      }
+      ring->tail.store(tail, std::memory_order_release);
+    }
+
+    while (_events.size() > max_trace_events)
+      _events.pop_front();
+  }
+
+  std::vector<cpu_zone_statistics> cpu_profiler::statistics() const
+  {
+    std::vector<cpu_zone_statistics> result;
+    result.reserve(_samples.size());
+
+    std::vector<double> sorted;
+    for (auto const& [name, samples] : _samples)
+    {
+      if (samples.empty())
+        continue;
+
+      sorted.assign(samples.begin(), samples.end());
+      std::ranges::sort(sorted);
+
+      double sum = 0.0;
+      for (auto const s : sorted)
+        sum += s;
+
+      auto const p99_index = std::min(sorted.size() - 1, (sorted.size() * 99) / 100);
+      result.push_back(cpu_zone_statistics{
+        .name = name,
+        .last_ms = samples.back(),
+        .min_ms = sorted.front(),
+        .avg_ms = sum / double(sorted.size()),
+        .p99_ms = sorted[p99_index],
+        .max_ms = sorted.back(),
+        .num_samples = sorted.size(),
+      });
+    }
+
+    std::ranges::sort(result, std::ranges::greater{}, &cpu_zone_statistics::avg_ms);
+    return result;
+  }
+
+  std::vector<trace_event> cpu_profiler::trace_events() const
+  {
+    return {_events.begin(), _events.end()};
+  }
+
+  void cpu_profiler::draw_overlay()
+  {
+    if (!ImGui::Begin("CPU Profiler"))
+    {
+      ImGui::End();
+      return;
+    }
+
+    bool enabled = this->enabled();
+    if (ImGui::Checkbox("Enabled", &enabled))
+      set_enabled(enabled);
+    if (auto const dropped = num_dropped(); dropped != 0)
+      ImGui::Text("Dropped zones: %zu", dropped);
+
+    if (ImGui::BeginTable("cpu_zones", 6, ImGuiTableFlags_RowBg | ImGuiTableFlags_Borders))
+    {
+      ImGui::TableSetupColumn("Zone");
+      ImGui::TableSetupColumn("Last (ms)");
+      ImGui::TableSetupColumn("Min (ms)");
+      ImGui::TableSetupColumn("Avg (ms)");
+      ImGui::TableSetupColumn("P99 (ms)");
+      ImGui::TableSetupColumn("Max (ms)");
+      ImGui::TableHeadersRow();
+
+      for (auto const& s : statistics())
+      {
+        ImGui::TableNextRow();
+        ImGui::TableNextColumn();
+        ImGui::TextUnformatted(s.name.c_str());
+        ImGui::TableNextColumn();
+        ImGui::Text("%.3f", s.last_ms);
+        ImGui::TableNextColumn();
+        ImGui::Text("%.3f", s.min_ms);
+        ImGui::TableNextColumn();
+        ImGui::Text("%.3f", s.avg_ms);
+        ImGui::TableNextColumn();
+        ImGui::Text("%.3f", s.p99_ms);
+        ImGui::TableNextColumn();
+        ImGui::Text("%.3f", s.max_ms);
+      }
+      ImGui::EndTable();
+    }
+    ImGui::End();
+  }
+
+  void cpu_profiler::write_trace(std::filesystem::path const& path) const
+  {
+    write_chrome_trace(path, trace_events());
+  }
+}    // namespace gev
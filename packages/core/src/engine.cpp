@@ -7,13 +7,18 @@
 #include <GLFW/glfw3.h>
 // clang-format on
 
+#include <format>
 #include <gev/audio/audio.hpp>
+#include <gev/cpu_profiler.hpp>
 #include <gev/engine.hpp>
+#include <gev/gpu_profiler.hpp>
 #include <gev/imgui/imgui.h>
 #include <gev/imgui/imgui_impl_glfw.h>
 #include <gev/imgui/imgui_impl_vulkan.h>
+#include <gev/jobs.hpp>
 #include <gev/scenery/collider.hpp>
 #include <gev/scenery/entity_manager.hpp>
+#include <gev/upload_manager.hpp>
 #include <print>
 #include <ranges>
 #include <sstream>
@@ -48,6 +53,19 @@ namespace gev
     bool _done = false;
   };
 
+  static GLFWwindow* create_window(std::string const& title, int w, int h)
+  {
+    auto const window = glfwCreateWindow(w, h, title.data(), nullptr, nullptr);
+    if (!window)
+    {
+      char const* description = nullptr;
+      glfwGetError(&description);
+      throw std::runtime_error(
+        std::format("Failed to create a {}x{} window: {}", w, h, description ? description : "unknown error"));
+    }
+    return window;
+  }
+
   void frame::present_image(image& source) const
   {
     assert(source.extent() == output_image->extent());
@@ -128,6 +146,11 @@ namespace gev
 
   void engine::start_impl(std::string const& title, int width, int height)
   {
+#ifdef GLFW_PLATFORM_NULL
+    if (_headless)
+      glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+#endif
+
     static class glfw_initializer
     {
     public:
@@ -180,6 +203,9 @@ namespace gev
     _device = create_device();
     VULKAN_HPP_DEFAULT_DISPATCHER.init(*_device);
     _allocator = create_allocator();
+    _pipeline_cache = std::make_unique<pipeline_cache>(_device.get(), _physical_device_properties);
+    if (_pipeline_cache->loaded_from_disk())
+      _logger.log("Loaded pipeline cache from {}.", _pipeline_cache->path().string());
 
     vk::CommandPoolCreateInfo cpc;
     cpc.flags = vk::CommandPoolCreateFlagBits::eResetCommandBuffer;
@@ -192,12 +218,20 @@ namespace gev
 
     open_window(title, width, height);
 
-    _present_modes = _physical_device.getSurfacePresentModesKHR(*_window_surface);
-    _present_mode = vk::PresentModeKHR::eFifo;
-    if (std::ranges::find(_present_modes, vk::PresentModeKHR::eMailbox) != end(_present_modes))
-      _present_mode = vk::PresentModeKHR::eMailbox;
+    if (_headless)
+    {
+      _present_mode = vk::PresentModeKHR::eImmediate;
+      create_offscreen_targets();
+    }
+    else
+    {
+      _present_modes = _physical_device.getSurfacePresentModesKHR(*_window_surface);
+      _present_mode = vk::PresentModeKHR::eFifo;
+      if (std::ranges::find(_present_modes, vk::PresentModeKHR::eMailbox) != end(_present_modes))
+        _present_mode = vk::PresentModeKHR::eMailbox;
 
-    create_swapchain();
+      create_swapchain();
+    }
 
     auto const imgui_pool_size = vk::DescriptorPoolSize(vk::DescriptorType::eCombinedImageSampler, 128);
     _imgui_descriptor_pool = _device->createDescriptorPoolUnique(
@@ -233,10 +267,21 @@ namespace gev
       select_format({vk::Format::eD32SfloatS8Uint, vk::Format::eD24UnormS8Uint, vk::Format::eD16UnormS8Uint},
         vk::ImageTiling::eOptimal, vk::FormatFeatureFlagBits::eDepthStencilAttachment);
 
+    auto const job_system = register_service<jobs>();
     _services.register_existing_service<audio::audio_host>(audio::audio_host::create());
-    register_service<scenery::entity_manager>();
+    register_service<scenery::entity_manager>()->set_executor(
+      [job_system = std::weak_ptr(job_system)](
+        std::size_t count, std::function<void(std::size_t begin, std::size_t end)> const& func)
+      {
+        if (auto const j = job_system.lock())
+          j->parallel_for(count, func);
+        else
+          func(0, count);
+      });
     _services.register_existing_service(scenery::collision_system::get_default());
     register_service<audio_repo>();
+    register_service<upload_manager>();
+    register_service<gpu_profiler>();
   }
 
   VkBool32 engine::debug_message_callback(VkDebugUtilsMessageSeverityFlagBitsEXT messageSeverity,
@@ -268,6 +313,10 @@ namespace gev
     auto const cbufs = _device->allocateCommandBuffersUnique(cballoc);
     auto const entity_manager = gev::service<gev::scenery::entity_manager>();
     auto const collision_system = gev::service<gev::scenery::collision_system>();
+    auto const uploads = gev::service<gev::upload_manager>();
+    auto const profiler = gev::service<gev::gpu_profiler>();
+    auto const job_system = gev::service<gev::jobs>();
+    uploads->wait_all();
 
     double fixed_update_time = 0.0;
     double fixed_update_target = 0.0;
@@ -276,36 +325,60 @@ namespace gev
     bool first_frame = true;
 
     std::uint32_t current_frame = 0;
-    double last_time = glfwGetTime();
+    std::uint64_t num_frames_rendered = 0;
+    double const start_time = glfwGetTime();
     double last_frame_time = glfwGetTime();
     while (!glfwWindowShouldClose(_window.get()))
     {
+      if (_headless && _headless->num_frames != 0 && num_frames_rendered >= _headless->num_frames)
+        break;
+
+      cpu_profiler::get().collect();
+      GEV_PROFILE_ZONE("engine::frame");
+
       double const delta = glfwGetTime() - last_frame_time;
       last_frame_time = glfwGetTime();
 
-      if (glfwGetWindowAttrib(_window.get(), GLFW_ICONIFIED))
+      if (!_headless && glfwGetWindowAttrib(_window.get(), GLFW_ICONIFIED))
       {
         glfwWaitEvents();
         continue;
       }
       auto& frame = _per_swapchain_image[current_frame];
 
-      [[maybe_unused]] auto const wait_result =
-        _device->waitForFences(frame.render_fence.get(), true, std::numeric_limits<std::uint64_t>::max());
-      _device->resetFences(frame.render_fence.get());
+      {
+        GEV_PROFILE_ZONE("engine::wait_for_frame");
+        [[maybe_unused]] auto const wait_result =
+          _device->waitForFences(frame.render_fence.get(), true, std::numeric_limits<std::uint64_t>::max());
+        _device->resetFences(frame.render_fence.get());
+      }
 
-      vk::AcquireNextImageInfoKHR acquire;
-      acquire.semaphore = frame.available_semaphore.get();
-      acquire.swapchain = _swapchain.get();
-      acquire.timeout = std::numeric_limits<std::uint64_t>::max();
-      acquire.deviceMask = 1;
-      auto const [acquire_result, image_index] = _device->acquireNextImage2KHR(acquire);
+      std::uint32_t image_index = current_frame;
+      if (!_headless)
+      {
+        GEV_PROFILE_ZONE("engine::acquire");
+        vk::AcquireNextImageInfoKHR acquire;
+        acquire.semaphore = frame.available_semaphore.get();
+        acquire.swapchain = _swapchain.get();
+        acquire.timeout = std::numeric_limits<std::uint64_t>::max();
+        acquire.deviceMask = 1;
+        image_index = _device->acquireNextImage2KHR(acquire).value;
+      }
 
       auto const& c = cbufs[current_frame].get();
 
       c.reset();
       c.begin(vk::CommandBufferBeginInfo().setFlags(vk::CommandBufferUsageFlagBits::eSimultaneousUse));
 
+      {
+        GEV_PROFILE_ZONE("jobs::run_main_thread_jobs");
+        job_system->run_main_thread_jobs();
+      }
+      uploads->flush();
+      auto const uploads_ready = uploads->acquire(c);
+      profiler->begin_frame(c, current_frame);
+      auto frame_scope = profiler->begin_scope(c, "Frame");
+
       ImGui_ImplVulkan_NewFrame();
       ImGui_ImplGlfw_NewFrame();
       ImGui::NewFrame();
@@ -318,67 +391,142 @@ namespace gev
 
       _current_frame.delta_time = delta;
       _current_frame.frame_index = current_frame;
+      _current_frame.frame_number = num_frames_rendered;
       _current_frame.output_image = frame.output_image;
       _current_frame.output_view = frame.output_view.get();
       _current_frame.command_buffer = c;
 
-      entity_manager->apply_transform();
-      entity_manager->early_update();
+      {
+        GEV_PROFILE_ZONE("entity_manager::apply_transform");
+        entity_manager->apply_transform();
+      }
+      {
+        GEV_PROFILE_ZONE("entity_manager::early_update");
+        entity_manager->early_update();
+      }
+
       double const target = fixed_update_target + delta;
-      for (double t = fixed_update_time; t < target; t += fixed_update_step)
       {
-        entity_manager->fixed_update(t, fixed_update_step);
-        collision_system->fixed_step(fixed_update_step);
-        fixed_update_time += fixed_update_step;
+        GEV_PROFILE_ZONE("engine::fixed_update_loop");
+        for (double t = fixed_update_time; t < target; t += fixed_update_step)
+        {
+          {
+            GEV_PROFILE_ZONE("entity_manager::fixed_update");
+            entity_manager->fixed_update(t, fixed_update_step);
+          }
+          {
+            GEV_PROFILE_ZONE("collision_system::fixed_step");
+            collision_system->fixed_step(fixed_update_step);
+          }
+          fixed_update_time += fixed_update_step;
+        }
       }
       fixed_update_target = target;
-      collision_system->sync(target - fixed_update_time);
-
-      entity_manager->update();
-      entity_manager->late_update();
-
-      if (!runnable(_current_frame))
       {
-        glfwSetWindowShouldClose(_window.get(), true);
+        GEV_PROFILE_ZONE("collision_system::sync");
+        collision_system->sync(target - fixed_update_time);
+      }
+      {
+        GEV_PROFILE_ZONE("entity_manager::update");
+        entity_manager->update();
+      }
+      {
+        GEV_PROFILE_ZONE("entity_manager::late_update");
+        entity_manager->late_update();
+      }
+      {
+        GEV_PROFILE_ZONE("entity_manager::flush_commands");
+        entity_manager->flush_commands();
       }
 
-      ImGui::Render();
-
-      frame.output_image->layout(c, vk::ImageLayout::eColorAttachmentOptimal,
-        vk::PipelineStageFlagBits2::eColorAttachmentOutput, vk::AccessFlagBits2::eColorAttachmentWrite,
-        _queues.graphics_family);
-      auto out_att =
-        vk::RenderingAttachmentInfo()
-          .setImageLayout(vk::ImageLayout::eColorAttachmentOptimal)
-          .setImageView(frame.output_view.get())
-          .setLoadOp(vk::AttachmentLoadOp::eLoad)
-          .setStoreOp(vk::AttachmentStoreOp::eStore);
-      c.beginRendering(vk::RenderingInfo().setColorAttachments(out_att).setLayerCount(1).setRenderArea(
-        vk::Rect2D({0, 0}, {_swapchain_size.width, _swapchain_size.height})));
+      {
+        GEV_PROFILE_ZONE("engine::runnable");
+        if (!runnable(_current_frame))
+        {
+          glfwSetWindowShouldClose(_window.get(), true);
+        }
+      }
 
-      ImGui_ImplVulkan_RenderDrawData(ImGui::GetDrawData(), c);
-      c.endRendering();
+      {
+        GEV_PROFILE_ZONE("engine::imgui");
+        ImGui::Render();
+        auto const imgui_scope = profiler->begin_scope(c, "ImGui");
+        frame.output_image->layout(c, vk::ImageLayout::eColorAttachmentOptimal,
+          vk::PipelineStageFlagBits2::eColorAttachmentOutput, vk::AccessFlagBits2::eColorAttachmentWrite,
+          _queues.graphics_family);
+        auto out_att =
+          vk::RenderingAttachmentInfo()
+            .setImageLayout(vk::ImageLayout::eColorAttachmentOptimal)
+            .setImageView(frame.output_view.get())
+            .setLoadOp(vk::AttachmentLoadOp::eLoad)
+            .setStoreOp(vk::AttachmentStoreOp::eStore);
+        c.beginRendering(vk::RenderingInfo().setColorAttachments(out_att).setLayerCount(1).setRenderArea(
+          vk::Rect2D({0, 0}, {_swapchain_size.width, _swapchain_size.height})));
+
+        ImGui_ImplVulkan_RenderDrawData(ImGui::GetDrawData(), c);
+        c.endRendering();
+      }
+      frame_scope = {};
 
-      frame.output_image->layout(c, vk::ImageLayout::ePresentSrcKHR, vk::PipelineStageFlagBits2::eColorAttachmentOutput,
-        vk::AccessFlagBits2::eColorAttachmentRead, _queues.present_family);
+      if (_headless)
+      {
+        frame.output_image->layout(c, vk::ImageLayout::eTransferSrcOptimal, vk::PipelineStageFlagBits2::eTransfer,
+          vk::AccessFlagBits2::eTransferRead, _queues.graphics_family);
+      }
+      else
+      {
+        frame.output_image->layout(c, vk::ImageLayout::ePresentSrcKHR,
+          vk::PipelineStageFlagBits2::eColorAttachmentOutput, vk::AccessFlagBits2::eColorAttachmentRead,
+          _queues.present_family);
+      }
       c.end();
 
-      vk::SubmitInfo submit;
-      submit.setWaitSemaphores(frame.available_semaphore.get());
-      submit.setCommandBuffers(c);
-      submit.setSignalSemaphores(frame.finished_semaphore.get());
-      vk::PipelineStageFlags wait_stage_mask = vk::PipelineStageFlagBits::eColorAttachmentOutput;
-      submit.setWaitDstStageMask(wait_stage_mask);
-      _queues.graphics.submit(submit, frame.render_fence.get());
+      std::vector<vk::SemaphoreSubmitInfo> wait_semaphores;
+      if (!_headless)
+      {
+        wait_semaphores.push_back(vk::SemaphoreSubmitInfo(
+          frame.available_semaphore.get(), 0, vk::PipelineStageFlagBits2::eColorAttachmentOutput));
+      }
+      if (uploads_ready.value != 0)
+      {
+        wait_semaphores.push_back(vk::SemaphoreSubmitInfo(
+          uploads->timeline(), uploads_ready.value, vk::PipelineStageFlagBits2::eAllCommands));
+      }
+      auto const command_buffer_info = vk::CommandBufferSubmitInfo(c);
+      auto const finished_semaphore = vk::SemaphoreSubmitInfo(
+        frame.finished_semaphore.get(), 0, vk::PipelineStageFlagBits2::eColorAttachmentOutput);
+
+      vk::SubmitInfo2 submit;
+      submit.setWaitSemaphoreInfos(wait_semaphores);
+      submit.setCommandBufferInfos(command_buffer_info);
+      if (!_headless)
+        submit.setSignalSemaphoreInfos(finished_semaphore);
+      {
+        GEV_PROFILE_ZONE("engine::submit");
+        _queues.graphics.submit2(submit, frame.render_fence.get());
+      }
+
+      if (_headless)
+      {
+        glfwPollEvents();
+        current_frame = (current_frame + 1) % _per_swapchain_image.size();
+        ++num_frames_rendered;
+        continue;
+      }
 
       vk::PresentInfoKHR present;
       present.setImageIndices(image_index);
       present.setSwapchains(_swapchain.get());
       present.setWaitSemaphores(frame.finished_semaphore.get());
-      auto const present_result = _queues.present.presentKHR(&present);
+      vk::Result present_result;
+      {
+        GEV_PROFILE_ZONE("engine::present");
+        present_result = _queues.present.presentKHR(&present);
+      }
 
       glfwPollEvents();
       current_frame = (current_frame + 1) % _per_swapchain_image.size();
+      ++num_frames_rendered;
 
       if (_swapchain_dirty || present_result == vk::Result::eErrorOutOfDateKHR ||
         present_result == vk::Result::eSuboptimalKHR)
@@ -390,12 +538,28 @@ namespace gev
 
     _device->waitIdle();
     entity_manager->despawn();
+
+    if (_headless && num_frames_rendered != 0)
+    {
+      double const total_time = glfwGetTime() - start_time;
+      _logger.log("Headless run finished: {} frames in {:.3f}s ({:.3f}ms per frame).", num_frames_rendered,
+        total_time, 1000.0 * total_time / double(num_frames_rendered));
+    }
     return 0;
   }
 
+  bool engine::headless() const noexcept
+  {
+    return _headless.has_value();
+  }
+
   engine::~engine()
   {
     _device->waitIdle();
+    if (_pipeline_cache && !_pipeline_cache->save())
+      _logger.error("Failed to save pipeline cache to {}.", _pipeline_cache->path().string());
+    // Workers may still run jobs that use other services.
+    _services.erase<jobs>();
     _services.erase<audio_repo>();
     _services.clear();
     ImGui_ImplGlfw_Shutdown();
@@ -554,8 +718,17 @@ namespace gev
   vk::PhysicalDevice engine::pick_physical_device()
   {
     auto const devices = _instance->enumeratePhysicalDevices();
+    if (devices.empty())
+      throw std::runtime_error("No Vulkan device found.");
 
     // Todo: better query
+    if (_headless && _headless->prefer_software_device)
+    {
+      auto const software = std::ranges::find_if(
+        devices, [](vk::PhysicalDevice d) { return d.getProperties().deviceType == vk::PhysicalDeviceType::eCpu; });
+      if (software != devices.end())
+        return *software;
+    }
 
     return devices[0];
   }
@@ -578,6 +751,7 @@ namespace gev
     rend.pNext = &clock;
     vk::PhysicalDeviceVulkan11Features vk11f;
     vk11f.setShaderDrawParameters(true);
+    vk11f.setMultiview(true);
     clock.pNext = &vk11f;
     vk::PhysicalDeviceVertexInputDynamicStateFeaturesEXT dynamic_vertex_input;
     dynamic_vertex_input.setVertexInputDynamicState(true);
@@ -588,6 +762,10 @@ namespace gev
     ft12.setDescriptorBindingPartiallyBound(true);
     ft12.setDescriptorBindingVariableDescriptorCount(true);
     ft12.setShaderSampledImageArrayNonUniformIndexing(true);
+    ft12.setDescriptorBindingSampledImageUpdateAfterBind(true);
+    ft12.setDescriptorBindingUpdateUnusedWhilePending(true);
+    ft12.setDrawIndirectCount(true);
+    ft12.setTimelineSemaphore(true);
     dynamic_vertex_input.pNext = &ft12;
 
     vk::PhysicalDeviceExtendedDynamicState3FeaturesEXT extd3;
@@ -598,9 +776,11 @@ namespace gev
     robust.setNullDescriptor(true);
     extd3.pNext = &robust;
 
-    const std::array required_device_extensions = {VK_KHR_SWAPCHAIN_EXTENSION_NAME, VK_KHR_SHADER_CLOCK_EXTENSION_NAME,
+    std::vector required_device_extensions = {VK_KHR_SHADER_CLOCK_EXTENSION_NAME,
       VK_EXT_VERTEX_INPUT_DYNAMIC_STATE_EXTENSION_NAME, VK_EXT_EXTENDED_DYNAMIC_STATE_3_EXTENSION_NAME,
       VK_KHR_PUSH_DESCRIPTOR_EXTENSION_NAME, VK_EXT_ROBUSTNESS_2_EXTENSION_NAME};
+    if (!_headless)
+      required_device_extensions.push_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
 
     std::vector<const char*> found_device_extensions;
     for (auto const& req : required_device_extensions)
@@ -628,7 +808,7 @@ namespace gev
     queue_family transfer_family;
     queue_family compute_family;
 
-    for (std::uint32_t i = 0; i < queue_infos.size(); ++i)
+    for (std::uint32_t i = 0; !_headless && i < queue_infos.size(); ++i)
     {
       if (glfwGetPhysicalDevicePresentationSupport(*_instance, _physical_device, i))
       {
@@ -643,6 +823,9 @@ namespace gev
       {
         graphics_family.set(i);
 
+        if (_headless)
+          present_family.set(i);
+
         if (!compute_family.done() && queue_infos[i].queueFamilyProperties.queueFlags & vk::QueueFlagBits::eCompute)
         {
           compute_family.set(i);
@@ -716,10 +899,21 @@ namespace gev
   void engine::open_window(std::string const& title, int w, int h)
   {
     glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
-    _window = unique_window{glfwCreateWindow(w, h, title.data(), nullptr, nullptr)};
+    if (_headless)
+    {
+      glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+      _window = unique_window{create_window(title, w, h)};
+      _swapchain_format = vk::SurfaceFormat2KHR(
+        vk::SurfaceFormatKHR(_headless->format, vk::ColorSpaceKHR::eSrgbNonlinear));
+      _swapchain_size = vk::Extent2D(std::uint32_t(w), std::uint32_t(h));
+      return;
+    }
+
+    _window = unique_window{create_window(title, w, h)};
 
     VkSurfaceKHR surface = nullptr;
-    glfwCreateWindowSurface(*_instance, _window.get(), nullptr, &surface);
+    if (glfwCreateWindowSurface(*_instance, _window.get(), nullptr, &surface) != VK_SUCCESS)
+      throw std::runtime_error("Failed to create a Vulkan surface for the window.");
     _window_surface = vk::UniqueSurfaceKHR(
       surface, vk::ObjectDestroy<vk::Instance, VULKAN_HPP_DEFAULT_DISPATCHER_TYPE>(_instance.get()));
 
@@ -828,6 +1022,54 @@ namespace gev
     _device->waitIdle();
   }
 
+  void engine::create_offscreen_targets()
+  {
+    _device->waitIdle();
+    _swapchain_dirty = false;
+
+    _per_swapchain_image.clear();
+    _per_swapchain_image.resize(requested_num_swapchain_images);
+
+    vk::CommandBufferAllocateInfo cballoc;
+    cballoc.commandBufferCount = 1;
+    cballoc.commandPool = _queues.graphics_command_pool.get();
+    cballoc.level = vk::CommandBufferLevel::ePrimary;
+
+    auto const cbufs = _device->allocateCommandBuffersUnique(cballoc);
+    auto const fence = _device->createFenceUnique({});
+
+    vk::CommandBufferBeginInfo begin;
+    begin.flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit;
+    cbufs[0]->begin(begin);
+
+    for (auto& pi : _per_swapchain_image)
+    {
+      pi.output_image = image_creator::get()
+                          .size(_swapchain_size.width, _swapchain_size.height)
+                          .format(_swapchain_format.surfaceFormat.format)
+                          .usage(vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eTransferSrc |
+                            vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eSampled)
+                          .build();
+      pi.output_view = pi.output_image->create_view(vk::ImageViewType::e2D);
+      pi.render_fence = _device->createFenceUnique(vk::FenceCreateInfo().setFlags(vk::FenceCreateFlagBits::eSignaled));
+
+      pi.output_image->layout(cbufs[0].get(), vk::ImageLayout::eTransferSrcOptimal,
+        vk::PipelineStageFlagBits2::eTransfer, {}, _queues.graphics_family);
+    }
+    cbufs[0]->end();
+
+    vk::SubmitInfo2 submit;
+    vk::CommandBufferSubmitInfo cbs;
+    cbs.commandBuffer = cbufs[0].get();
+    submit.setCommandBufferInfos(cbs);
+    _queues.graphics.submit2(submit, fence.get());
+    [[maybe_unused]] auto const wait_result =
+      _device->waitForFences(fence.get(), true, std::numeric_limits<std::uint64_t>::max());
+
+    for (auto& callback : _resize_callbacks)
+      callback(_swapchain_size.width, _swapchain_size.height);
+  }
+
   descriptor_allocator& engine::get_descriptor_allocator()
   {
     return _descriptor_allocator;
@@ -858,6 +1100,16 @@ namespace gev
     return _allocator;
   }
 
+  pipeline_cache& engine::pipelines()
+  {
+    return *_pipeline_cache;
+  }
+
+  pipeline_cache const& engine::pipelines() const
+  {
+    return *_pipeline_cache;
+  }
+
   queues const& engine::queues() const
   {
     return _queues;
@@ -0,0 +1,315 @@
+#include <algorithm>
+#include <cfloat>
+#include <format>
+#include <gev/cpu_profiler.hpp>
+#include <gev/engine.hpp>
+#include <gev/gpu_profiler.hpp>
+#include <gev/imgui/imgui.h>
+#include <gev/trace.hpp>
+#include <unordered_map>
+#include <utility>
+
+namespace gev
+{
+  gpu_profiler::scope::scope(gpu_profiler* profiler, vk::CommandBuffer c, std::uint32_t index)
+    : _profiler(profiler), _command_buffer(c), _index(index)
+  {
+  }
+
+  gpu_profiler::scope::scope(scope&& other) noexcept
+    : _profiler(std::exchange(other._profiler, nullptr)), _command_buffer(other._command_buffer), _index(other._index)
+  {
+  }
+
+  gpu_profiler::scope& gpu_profiler::scope::operator=(scope&& other) noexcept
+  {
+    if (this != &other)
+    {
+      if (_profiler)
+        _profiler->end(_command_buffer, _index);
+      _profiler = std::exchange(other._profiler, nullptr);
+      _command_buffer = other._command_buffer;
+      _index = other._index;
+    }
+    return *this;
+  }
+
+  gpu_profiler::scope::~scope()
+  {
+    if (_profiler)
+      _profiler->end(_command_buffer, _index);
+  }
+
+  gpu_profiler::gpu_profiler()
+  {
+    auto const& e = engine::get();
+    auto const properties = e.physical_device().getProperties();
+    auto const families = e.physical_device().getQueueFamilyProperties();
+    auto const valid_bits = families[e.queues().graphics_family].timestampValidBits;
+
+    _supported = valid_bits != 0 && properties.limits.timestampPeriod > 0.0f;
+    _timestamp_period = properties.limits.timestampPeriod;
+    _timestamp_mask = valid_bits >= 64 ? ~0ull : ((1ull << valid_bits) - 1);
+    if (_supported)
+      calibrate();
+  }
+
+  void gpu_profiler::calibrate()
+  {
+    // The timestamp is written between the two CPU reads, so their midpoint is off by at most half of the round trip.
+    auto& e = engine::get();
+    auto const pool = e.device().createQueryPoolUnique(
+      vk::QueryPoolCreateInfo().setQueryType(vk::QueryType::eTimestamp).setQueryCount(1));
+    auto const cpu_begin = cpu_profiler::get().now_ns();
+    e.execute_once(
+      [&](vk::CommandBuffer c)
+      {
+        c.resetQueryPool(pool.get(), 0, 1);
+        c.writeTimestamp2(vk::PipelineStageFlagBits2::eAllCommands, pool.get(), 0);
+      },
+      e.queues().graphics_command_pool.get(), true);
+    auto const cpu_end = cpu_profiler::get().now_ns();
+
+    auto const result = e.device().getQueryPoolResults<std::uint64_t>(pool.get(), 0, 1, sizeof(std::uint64_t),
+      sizeof(std::uint64_t), vk::QueryResultFlagBits::e64 | vk::QueryResultFlagBits::eWait);
+    if (result.result != vk::Result::eSuccess)
+      return;
+    _calibration_tick = result.value[0] & _timestamp_mask;
+    _calibration_ns = cpu_begin + (cpu_end - cpu_begin) / 2;
+  }
+
+  double gpu_profiler::to_cpu_us(std::uint64_t tick) const
+  {
+    auto const ticks = double(std::int64_t(tick - _calibration_tick));
+    return (double(_calibration_ns) + ticks * _timestamp_period) * 1e-3;
+  }
+
+  void gpu_profiler::set_enabled(bool enabled)
+  {
+    _enabled = enabled;
+  }
+
+  bool gpu_profiler::enabled() const noexcept
+  {
+    return _enabled;
+  }
+
+  bool gpu_profiler::supported() const noexcept
+  {
+    return _supported;
+  }
+
+  void gpu_profiler::begin_frame(vk::CommandBuffer c, std::uint32_t frame_index)
+  {
+    _current = nullptr;
+    _depth = 0;
+    if (!_supported)
+      return;
+
+    if (frame_index >= _frames.size())
+      _frames.resize(frame_index + 1);
+
+    auto& frame = _frames[frame_index];
+    if (!frame.pool)
+    {
+      frame.pool = engine::get().device().createQueryPoolUnique(
+        vk::QueryPoolCreateInfo().setQueryType(vk::QueryType::eTimestamp).setQueryCount(2 * max_scopes));
+    }
+
+    collect(frame);
+    frame.scopes.clear();
+    frame.frame_number = _frame_number++;
+
+    if (!_enabled)
+      return;
+
+    c.resetQueryPool(frame.pool.get(), 0, 2 * max_scopes);
+    _current = &frame;
+  }
+
+  gpu_profiler::scope gpu_profiler::begin_scope(vk::CommandBuffer c, std::string name)
+  {
+    auto const index = begin(c, std::move(name));
+    if (index == invalid_scope)
+      return {};
+    return scope(this, c, index);
+  }
+
+  void gpu_profiler::begin_multiview()
+  {
+    _multiview = true;
+  }
+
+  void gpu_profiler::end_multiview()
+  {
+    _multiview = false;
+  }
+
+  std::uint32_t gpu_profiler::begin(vk::CommandBuffer c, std::string name)
+  {
+    if (!_current || _multiview || _current->scopes.size() >= max_scopes)
+      return invalid_scope;
+
+    auto const index = std::uint32_t(_current->scopes.size());
+    _current->scopes.push_back(recorded_scope{std::move(name), _depth++});
+    c.writeTimestamp2(vk::PipelineStageFlagBits2::eTopOfPipe, _current->pool.get(), 2 * index);
+    return index;
+  }
+
+  void gpu_profiler::end(vk::CommandBuffer c, std::uint32_t index)
+  {
+    if (!_current || index >= _current->scopes.size())
+      return;
+
+    --_depth;
+    c.writeTimestamp2(vk::PipelineStageFlagBits2::eBottomOfPipe, _current->pool.get(), 2 * index + 1);
+  }
+
+  void gpu_profiler::collect(frame_queries& frame)
+  {
+    if (frame.scopes.empty())
+      return;
+
+    auto const count = std::uint32_t(2 * frame.scopes.size());
+    auto const results = engine::get().device().getQueryPoolResults<std::uint64_t>(frame.pool.get(), 0, count,
+      count * sizeof(std::uint64_t), sizeof(std::uint64_t), vk::QueryResultFlagBits::e64);
+    if (results.result != vk::Result::eSuccess)
+      return;
+
+    auto const tick = [&](std::uint32_t i) { return results.value[i] & _timestamp_mask; };
+    std::uint64_t frame_begin = std::numeric_limits<std::uint64_t>::max();
+    std::uint64_t frame_end = 0;
+    for (std::uint32_t i = 0; i < count; i += 2)
+    {
+      frame_begin = std::min(frame_begin, tick(i));
+      frame_end = std::max(frame_end, tick(i + 1));
+    }
+
+    auto const to_ms = [&](std::uint64_t ticks) { return double(ticks) * _timestamp_period * 1e-6; };
+
+    gpu_frame_timings& timings = _history.emplace_back();
+    timings.frame_number = frame.frame_number;
+    timings.start_us = to_cpu_us(frame_begin);
+    timings.duration_ms = to_ms(frame_end - frame_begin);
+    timings.scopes.reserve(frame.scopes.size());
+    for (std::uint32_t i = 0; i < frame.scopes.size(); ++i)
+    {
+      auto const begin = tick(2 * i);
+      auto const end = std::max(begin, tick(2 * i + 1));
+      timings.scopes.push_back(gpu_scope_timing{
+        .name = frame.scopes[i].name,
+        .depth = frame.scopes[i].depth,
+        .begin_ms = to_ms(begin - frame_begin),
+        .duration_ms = to_ms(end - begin),
+      });
+    }
+
+    while (_history.size() > max_history)
+      _history.pop_front();
+  }
+
+  std::deque<gpu_frame_timings> const& gpu_profiler::history() const noexcept
+  {
+    return _history;
+  }
+
+  void gpu_profiler::draw_overlay()
+  {
+    if (!ImGui::Begin("GPU Profiler"))
+    {
+      ImGui::End();
+      return;
+    }
+
+    ImGui::Checkbox("Enabled", &_enabled);
+    if (!_supported)
+      ImGui::TextUnformatted("Timestamp queries are not supported on the graphics queue.");
+
+    if (!_history.empty())
+    {
+      std::vector<float> durations;
+      durations.reserve(_history.size());
+      for (auto const& frame : _history)
+        durations.push_back(float(frame.duration_ms));
+      ImGui::PlotLines("##gpu_frames", durations.data(), int(durations.size()), 0,
+        std::format("{:.3f} ms", _history.back().duration_ms).c_str(), 0.0f, FLT_MAX, ImVec2(-1, 60));
+
+      struct stats
+      {
+        double sum = 0.0;
+        double max = 0.0;
+        std::size_t count = 0;
+      };
+      std::unordered_map<std::string, stats> per_scope;
+      for (auto const& frame : _history)
+      {
+        for (auto const& s : frame.scopes)
+        {
+          auto& st = per_scope[s.name];
+          st.sum += s.duration_ms;
+          st.max = std::max(st.max, s.duration_ms);
+          ++st.count;
+        }
+      }
+
+      if (ImGui::BeginTable("gpu_scopes", 4, ImGuiTableFlags_RowBg | ImGuiTableFlags_Borders))
+      {
+        ImGui::TableSetupColumn("Scope");
+        ImGui::TableSetupColumn("Last (ms)");
+        ImGui::TableSetupColumn("Avg (ms)");
+        ImGui::TableSetupColumn("Max (ms)");
+        ImGui::TableHeadersRow();
+
+        for (auto const& s : _history.back().scopes)
+        {
+          auto const& st = per_scope[s.name];
+          ImGui::TableNextRow();
+          ImGui::TableNextColumn();
+          ImGui::Indent(float(s.depth) * 10.0f + 1.0f);
+          ImGui::TextUnformatted(s.name.c_str());
+          ImGui::Unindent(float(s.depth) * 10.0f + 1.0f);
+          ImGui::TableNextColumn();
+          ImGui::Text("%.3f", s.duration_ms);
+          ImGui::TableNextColumn();
+          ImGui::Text("%.3f", st.sum / double(st.count));
+          ImGui::TableNextColumn();
+          ImGui::Text("%.3f", st.max);
+        }
+        ImGui::EndTable();
+      }
+    }
+    ImGui::End();
+  }
+
+  std::vector<trace_event> gpu_profiler::trace_events() const
+  {
+    std::vector<trace_event> events;
+    for (auto const& frame : _history)
+    {
+      for (auto const& s : frame.scopes)
+      {
+        events.push_back(trace_event{
+          .name = s.name,
+          .category = "gpu",
+          .start_us = frame.start_us + s.begin_ms * 1000.0,
+          .duration_us = s.duration_ms * 1000.0,
+          .process_id = 1,
+        });
+      }
+    }
+    return events;
+  }
+
+  void gpu_profiler::write_trace(std::filesystem::path const& path) const
+  {
+    write_chrome_trace(path, trace_events());
+  }
+
+  gpu_profiler::scope profile_gpu(vk::CommandBuffer c, std::string name)
+  {
+    auto const profiler = service<gpu_profiler>();
+    if (!profiler)
+      return {};
+    return profiler->begin_scope(c, std::move(name));
+  }
+}    // namespace gev
@@ -0,0 +1,343 @@
+#include <algorithm>
+#include <deque>
+#include <exception>
+#include <gev/jobs.hpp>
+
+namespace gev
+{
+  struct job::state
+  {
+    std::function<void()> func;
+    job_affinity affinity = job_affinity::any;
+    // Unfinished dependencies, plus one that is held while the job is being set up.
+    std::atomic<std::uint32_t> pending = 1;
+    std::atomic_bool finished = false;
+    std::mutex mutex;
+    std::vector<std::shared_ptr<state>> continuations;
+    std::exception_ptr exception;
+  };
+
+  struct jobs::worker_queue
+  {
+    std::mutex mutex;
+    std::deque<std::shared_ptr<job::state>> jobs;
+  };
+
+  namespace
+  {
+    thread_local jobs const* local_pool = nullptr;
+    thread_local std::size_t local_pool_queue = 0;
+  }    // namespace
+
+  job::job(std::shared_ptr<state> s) : _state(std::move(s)) {}
+
+  bool job::valid() const noexcept
+  {
+    return _state != nullptr;
+  }
+
+  bool job::done() const noexcept
+  {
+    return !_state || _state->finished.load();
+  }
+
+  std::size_t jobs::default_num_workers()
+  {
+    // The main thread helps out while it waits, so it does not need a worker of its own.
+    return std::max(1u, std::thread::hardware_concurrency()) - 1;
+  }
+
+  jobs::jobs(std::size_t num_workers)
+    : _main_thread(std::this_thread::get_id()),
+      _main_queue(std::make_unique<worker_queue>())
+  {
+    _queues.resize(num_workers + 1);
+    for (auto& q : _queues)
+      q = std::make_unique<worker_queue>();
+
+    _workers.reserve(num_workers);
+    for (std::size_t i = 0; i < num_workers; ++i)
+      _workers.emplace_back([this, i] { worker_main(i + 1); });
+  }
+
+  jobs::~jobs()
+  {
+    {
+      std::unique_lock lock(_sleep_mutex);
+      _stop = true;
+      _work_available.notify_all();
+    }
+    _workers.clear();
+  }
+
+  job jobs::run(std::function<void()> func, job_affinity affinity)
+  {
+    return run_after(std::span<job const>(), std::move(func), affinity);
+  }
+
+  job jobs::run_after(job const& dependency, std::function<void()> func, job_affinity affinity)
+  {
+    return run_after(std::span(&dependency, 1), std::move(func), affinity);
+  }
+
+  job jobs::run_after(std::span<job const> dependencies, std::function<void()> func, job_affinity affinity)
+  {
+    auto s = std::make_shared<job::state>();
+    s->func = std::move(func);
+    s->affinity = affinity;
+
+    for (auto const& dependency : dependencies)
+    {
+      if (!dependency._state)
+        continue;
+
+      std::unique_lock lock(dependency._state->mutex);
+      if (!dependency._state->finished)
+      {
+        ++s->pending;
+        dependency._state->continuations.push_back(s);
+      }
+    }
+    release(s);
+    return job(std::move(s));
+  }
+
+  void jobs::wait(job const& j)
+  {
+    wait(std::span(&j, 1));
+  }
+
+  void jobs::wait(std::span<job const> js)
+  {
+    auto const main_thread = is_main_thread();
+    for (auto const& j : js)
+    {
+      while (!j.done())
+      {
+        if (!try_run_one(main_thread))
+          sleep_until_done(j, main_thread);
+      }
+    }
+
+    for (auto const& j : js)
+    {
+      if (j._state && j._state->exception)
+        std::rethrow_exception(j._state->exception);
+    }
+  }
+
+  void jobs::run_main_thread_jobs()
+  {
+    if (!is_main_thread())
+      return;
+
+    while (auto s = take_main_thread_job())
+      execute(s);
+  }
+
+  void jobs::parallel_for(
+    std::size_t count, std::function<void(std::size_t begin, std::size_t end)> const& func, std::size_t batch_size)
+  {
+    if (count == 0)
+      return;
+
+    if (batch_size == 0)
+      batch_size = std::max<std::size_t>(1, count / (4 * (_workers.size() + 1)));
+
+    if (count <= batch_size || _workers.empty())
+    {
+      func(0, count);
+      return;
+    }
+
+    std::vector<job> batches;
+    batches.reserve((count - 1) / batch_size);
+    for (std::size_t begin = batch_size; begin < count; begin += batch_size)
+      batches.push_back(run([&func, begin, end = std::min(count, begin + batch_size)] { func(begin, end); }));
+
+    // The calling thread takes the first batch itself. The others reference func, so they have to finish before
+    // anything is rethrown.
+    std::exception_ptr exception;
+    try
+    {
+      func(0, batch_size);
+    }
+    catch (...)
+    {
+      exception = std::current_exception();
+    }
+
+    try
+    {
+      wait(batches);
+    }
+    catch (...)
+    {
+      if (!exception)
+        exception = std::current_exception();
+    }
+
+    if (exception)
+      std::rethrow_exception(exception);
+  }
+
+  std::size_t jobs::num_workers() const noexcept
+  {
+    return _workers.size();
+  }
+
+  bool jobs::is_main_thread() const noexcept
+  {
+    return std::this_thread::get_id() == _main_thread;
+  }
+
+  void jobs::schedule(std::shared_ptr<job::state> s)
+  {
+    if (s->affinity == job_affinity::main_thread)
+    {
+      std::unique_lock lock(_main_queue->mutex);
+      ++_main_queued;
+      _main_queue->jobs.push_back(std::move(s));
+    }
+    else
+    {
+      auto& queue = *_queues[local_queue()];
+      std::unique_lock lock(queue.mutex);
+      ++_queued;
+      queue.jobs.push_back(std::move(s));
+    }
+
+    // Sleepers register themselves under the mutex before checking the counters, so taking it here cannot miss one.
+    if (_sleeping > 0 || _waiting > 0)
+    {
+      std::unique_lock lock(_sleep_mutex);
+      _work_available.notify_one();
+      _job_done.notify_all();
+    }
+  }
+
+  void jobs::release(std::shared_ptr<job::state> const& s)
+  {
+    if (s->pending.fetch_sub(1) == 1)
+      schedule(s);
+  }
+
+  void jobs::execute(std::shared_ptr<job::state> const& s)
+  {
+    try
+    {
+      s->func();
+    }
+    catch (...)
+    {
+      s->exception = std::current_exception();
+    }
+    s->func = nullptr;
+
+    std::vector<std::shared_ptr<job::state>> continuations;
+    {
+      std::unique_lock lock(s->mutex);
+      s->finished = true;
+      continuations.swap(s->continuations);
+    }
+
+    for (auto const& c : continuations)
+      release(c);
+
+    if (_waiting > 0)
+    {
+      std::unique_lock lock(_sleep_mutex);
+      _job_done.notify_all();
+    }
+  }
+
+  std::shared_ptr<job::state> jobs::take(std::size_t queue)
+  {
+    {
+      auto& own = *_queues[queue];
+      std::unique_lock lock(own.mutex);
+      if (!own.jobs.empty())
+      {
+        auto s = std::move(own.jobs.back());
+        own.jobs.pop_back();
+        --_queued;
+        return s;
+      }
+    }
+
+    for (std::size_t i = 1; i < _queues.size(); ++i)
+    {
+      auto& victim = *_queues[(queue + i) % _queues.size()];
+      std::unique_lock lock(victim.mutex);
+      if (!victim.jobs.empty())
+      {
+        auto s = std::move(victim.jobs.front());
+        victim.jobs.pop_front();
+        --_queued;
+        return s;
+      }
+    }
+    return nullptr;
+  }
+
+  std::shared_ptr<job::state> jobs::take_main_thread_job()
+  {
+    std::unique_lock lock(_main_queue->mutex);
+    if (_main_queue->jobs.empty())
+      return nullptr;
+
+    auto s = std::move(_main_queue->jobs.front());
+    _main_queue->jobs.pop_front();
+    --_main_queued;
+    return s;
+  }
+
+  bool jobs::try_run_one(bool main_thread)
+  {
+    auto s = main_thread ? take_main_thread_job() : nullptr;
+    if (!s)
+      s = take(local_queue());
+    if (!s)
+      return false;
+
+    execute(s);
+    return true;
+  }
+
+  void jobs::sleep_until_done(job const& j, bool main_thread)
+  {
+    std::unique_lock lock(_sleep_mutex);
+    ++_waiting;
+    _job_done.wait(lock, [&] { return j.done() || _queued > 0 || (main_thread && _main_queued > 0); });
+    --_waiting;
+  }
+
+  void jobs::worker_main(std::size_t queue)
+  {
+    local_pool = this;
+    local_pool_queue = queue;
+
+    while (true)
+    {
+      if (auto s = take(queue))
+      {
+        execute(s);
+        continue;
+      }
+
+      std::unique_lock lock(_sleep_mutex);
+      ++_sleeping;
+      _work_available.wait(lock, [&] { return _stop || _queued > 0; });
+      --_sleeping;
+
+      // Jobs that are still queued are drained before shutting down.
+      if (_stop && _queued == 0)
+        break;
+    }
+  }
+
+  std::size_t jobs::local_queue() const
+  {
+    return local_pool == this ? local_pool_queue : 0;
+  }
+}    // namespace gev
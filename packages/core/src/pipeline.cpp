@@ -58,7 +58,8 @@ namespace gev
     vk::ComputePipelineCreateInfo ci;
     ci.setStage(vk::PipelineShaderStageCreateInfo({}, vk::ShaderStageFlagBits::eCompute, module, entry, spec));
     ci.setLayout(layout);
-    return gev::engine::get().device().createComputePipelineUnique(nullptr, ci).value;
+    auto const& e = gev::engine::get();
+    return e.device().createComputePipelineUnique(e.pipelines().get(), ci).value;
   }
 
   simple_pipeline_builder simple_pipeline_builder::get(vk::PipelineLayout layout)
@@ -170,6 +171,12 @@ namespace gev
     return *this;
   }
 
+  simple_pipeline_builder& simple_pipeline_builder::view_mask(std::uint32_t mask)
+  {
+    _view_mask = mask;
+    return *this;
+  }
+
   void simple_pipeline_builder::clear()
   {
     _stage_names.clear();
@@ -200,7 +207,8 @@ namespace gev
     vk::PipelineRenderingCreateInfo rinfo;
     rinfo.setColorAttachmentFormats(_color_formats)
       .setDepthAttachmentFormat(_depth_format)
-      .setStencilAttachmentFormat(_stencil_format);
+      .setStencilAttachmentFormat(_stencil_format)
+      .setViewMask(_view_mask);
     info.pNext = &rinfo;
 
     vk::PipelineColorBlendStateCreateInfo blend;
@@ -256,6 +264,7 @@ namespace gev
     vp.setScissors(scissor);
     info.pViewportState = &vp;
 
-    return engine::get().device().createGraphicsPipelineUnique(nullptr, info).value;
+    auto const& e = engine::get();
+    return e.device().createGraphicsPipelineUnique(e.pipelines().get(), info).value;
   }
 }    // namespace gev
\ No newline at end of file
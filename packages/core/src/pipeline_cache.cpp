@@ -0,0 +1,125 @@
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <fstream>
+#include <gev/cpu_profiler.hpp>
+#include <gev/pipeline_cache.hpp>
+#include <mutex>
+#include <thread>
+
+namespace gev
+{
+  pipeline_cache::pipeline_cache(
+    vk::Device device, vk::PhysicalDeviceProperties const& properties, std::filesystem::path path)
+    : _path(std::move(path))
+  {
+    std::vector<std::byte> data;
+    if (std::ifstream file(_path, std::ios::binary | std::ios::ate); file)
+    {
+      data.resize(std::size_t(file.tellg()));
+      file.seekg(0, std::ios::beg);
+      file.read(reinterpret_cast<char*>(data.data()), data.size());
+      if (!file || !is_compatible(data, properties))
+        data.clear();
+    }
+
+    _loaded_from_disk = !data.empty();
+    _cache = device.createPipelineCacheUnique(
+      vk::PipelineCacheCreateInfo().setInitialDataSize(data.size()).setPInitialData(data.data()));
+  }
+
+  vk::PipelineCache pipeline_cache::get() const
+  {
+    return _cache.get();
+  }
+
+  std::filesystem::path const& pipeline_cache::path() const
+  {
+    return _path;
+  }
+
+  bool pipeline_cache::loaded_from_disk() const
+  {
+    return _loaded_from_disk;
+  }
+
+  bool pipeline_cache::is_compatible(
+    std::span<std::byte const> data, vk::PhysicalDeviceProperties const& properties) const
+  {
+    VkPipelineCacheHeaderVersionOne header;
+    if (data.size() < sizeof(header))
+      return false;
+
+    std::memcpy(&header, data.data(), sizeof(header));
+    return header.headerSize >= sizeof(header) && header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+      header.vendorID == properties.vendorID && header.deviceID == properties.deviceID &&
+      std::memcmp(header.pipelineCacheUUID, properties.pipelineCacheUUID.data(), VK_UUID_SIZE) == 0;
+  }
+
+  bool pipeline_cache::save() const
+  {
+    auto const data = _cache.getOwner().getPipelineCacheData(_cache.get());
+    if (data.empty())
+      return false;
+
+    // Write next to the target first so that a crash while saving never leaves a truncated cache behind.
+    auto temp_path = _path;
+    temp_path += ".tmp";
+    {
+      std::ofstream file(temp_path, std::ios::binary);
+      if (!file)
+        return false;
+      file.write(reinterpret_cast<char const*>(data.data()), data.size());
+      if (!file)
+        return false;
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(temp_path, _path, ec);
+    return !ec;
+  }
+
+  std::future<void> pipeline_cache::prewarm(std::vector<std::function<void()>> builders) const
+  {
+    return std::async(std::launch::async,
+      [builders = std::move(builders)]
+      {
+        if (builders.empty())
+          return;
+
+        std::atomic_size_t next = 0;
+        std::exception_ptr error;
+        std::mutex error_mutex;
+
+        auto const worker = [&]
+        {
+          for (auto i = next++; i < builders.size(); i = next++)
+          {
+            try
+            {
+              GEV_PROFILE_ZONE("pipeline_cache::prewarm");
+              builders[i]();
+            }
+            catch (...)
+            {
+              std::unique_lock lock(error_mutex);
+              if (!error)
+                error = std::current_exception();
+            }
+          }
+        };
+
+        auto const num_workers = std::clamp<std::size_t>(std::thread::hardware_concurrency(), 1, builders.size());
+        {
+          std::vector<std::jthread> workers;
+          workers.reserve(num_workers - 1);
+          for (std::size_t i = 1; i < num_workers; ++i)
+            workers.emplace_back(worker);
+          worker();
+        }
+
+        if (error)
+          std::rethrow_exception(error);
+      });
+  }
+}    // namespace gev
@@ -0,0 +1,50 @@
+#include <format>
+#include <fstream>
+#include <gev/trace.hpp>
+#include <stdexcept>
+
+namespace gev
+{
+  static std::string escape_json(std::string_view text)
+  {
+    std::string result;
+    result.reserve(text.size());
+    for (char const c : text)
+    {
+      switch (c)
+      {
+        case '"': result += "\\\""; break;
+        case '\\': result += "\\\\"; break;
+        case '\n': result += "\\n"; break;
+        case '\t': result += "\\t"; break;
+        default:
+          // JSON strings must not contain raw control characters.
+          if (std::uint8_t(c) < 0x20)
+            result += std::format("\\u{:04x}", std::uint8_t(c));
+          else
+            result += c;
+          break;
+      }
+    }
+    return result;
+  }
+
+  void write_chrome_trace(std::filesystem::path const& path, std::span<trace_event const> events)
+  {
+    std::ofstream out(path);
+    if (!out)
+      throw std::runtime_error(std::format("Could not open trace file {}.", path.string()));
+
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool first = true;
+    for (auto const& e : events)
+    {
+      out << (first ? "\n" : ",\n");
+      out << std::format(
+        R"({{"name":"{}","cat":"{}","ph":"X","ts":{:.3f},"dur":{:.3f},"pid":{},"tid":{}}})",
+        escape_json(e.name), escape_json(e.category), e.start_us, e.duration_us, e.process_id, e.thread_id);
+      first = false;
+    }
+    out << "\n]}\n";
+  }
+}    // namespace gev
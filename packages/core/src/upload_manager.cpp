@@ -0,0 +1,315 @@
+#include <gev/engine.hpp>
+#include <gev/upload_manager.hpp>
+
+namespace gev
+{
+  upload_manager::upload_manager(std::size_t staging_size)
+    : _staging_size(staging_size), _staging(buffer::host_local(staging_size, vk::BufferUsageFlagBits::eTransferSrc))
+  {
+    vk::SemaphoreTypeCreateInfo type(vk::SemaphoreType::eTimeline, 0);
+    _timeline = engine::get().device().createSemaphoreUnique(vk::SemaphoreCreateInfo().setPNext(&type));
+  }
+
+  upload_manager::~upload_manager()
+  {
+    if (!_in_flight.empty())
+    {
+      [[maybe_unused]] auto const result = _timeline.getOwner().waitSemaphores(
+        vk::SemaphoreWaitInfo().setSemaphores(_timeline.get()).setValues(_in_flight.back().value),
+        std::numeric_limits<std::uint64_t>::max());
+    }
+  }
+
+  upload_ticket upload_manager::upload(
+    std::shared_ptr<buffer> dst, void const* data, std::size_t size, std::size_t dst_offset)
+  {
+    if (size == 0)
+      return {};
+
+    auto const [staging, staging_offset] = stage(data, size);
+    auto& b = open_batch();
+    b.command_buffer->copyBuffer(staging, dst->get_buffer(), vk::BufferCopy(staging_offset, dst_offset, size));
+
+    if (needs_ownership_transfer())
+    {
+      auto const& queues = engine::get().queues();
+      vk::BufferMemoryBarrier2 release;
+      release.srcStageMask = vk::PipelineStageFlagBits2::eTransfer;
+      release.srcAccessMask = vk::AccessFlagBits2::eTransferWrite;
+      release.srcQueueFamilyIndex = queues.transfer_family;
+      release.dstQueueFamilyIndex = queues.graphics_family;
+      release.buffer = dst->get_buffer();
+      release.offset = dst_offset;
+      release.size = size;
+      b.command_buffer->pipelineBarrier2(vk::DependencyInfo().setBufferMemoryBarriers(release));
+    }
+
+    _pending.push_back(pending_acquire{
+      .value = b.value, .target_buffer = std::move(dst), .offset = dst_offset, .size = size});
+    return {b.value};
+  }
+
+  upload_ticket upload_manager::upload(std::shared_ptr<image> dst, void const* data, std::size_t size,
+    std::span<vk::BufferImageCopy const> regions, std::function<void(vk::CommandBuffer c)> on_acquire)
+  {
+    auto const [staging, staging_offset] = stage(data, size);
+    auto& b = open_batch();
+
+    std::vector<vk::BufferImageCopy> copies(regions.begin(), regions.end());
+    for (auto& copy : copies)
+      copy.bufferOffset += staging_offset;
+
+    auto const range = vk::ImageSubresourceRange(dst->aspect_flags(), 0, dst->mip_levels(), 0, dst->array_layers());
+
+    vk::ImageMemoryBarrier2 to_transfer;
+    to_transfer.oldLayout = vk::ImageLayout::eUndefined;
+    to_transfer.newLayout = vk::ImageLayout::eTransferDstOptimal;
+    to_transfer.srcStageMask = vk::PipelineStageFlagBits2::eNone;
+    to_transfer.dstStageMask = vk::PipelineStageFlagBits2::eTransfer;
+    to_transfer.dstAccessMask = vk::AccessFlagBits2::eTransferWrite;
+    to_transfer.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    to_transfer.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    to_transfer.image = dst->get_image();
+    to_transfer.subresourceRange = range;
+    b.command_buffer->pipelineBarrier2(vk::DependencyInfo().setImageMemoryBarriers(to_transfer));
+
+    b.command_buffer->copyBufferToImage(staging, dst->get_image(), vk::ImageLayout::eTransferDstOptimal, copies);
+
+    if (needs_ownership_transfer())
+    {
+      auto const& queues = engine::get().queues();
+      vk::ImageMemoryBarrier2 release;
+      release.oldLayout = vk::ImageLayout::eTransferDstOptimal;
+      release.newLayout = vk::ImageLayout::eTransferDstOptimal;
+      release.srcStageMask = vk::PipelineStageFlagBits2::eTransfer;
+      release.srcAccessMask = vk::AccessFlagBits2::eTransferWrite;
+      release.srcQueueFamilyIndex = queues.transfer_family;
+      release.dstQueueFamilyIndex = queues.graphics_family;
+      release.image = dst->get_image();
+      release.subresourceRange = range;
+      b.command_buffer->pipelineBarrier2(vk::DependencyInfo().setImageMemoryBarriers(release));
+    }
+
+    _pending.push_back(
+      pending_acquire{.value = b.value, .target_image = std::move(dst), .on_acquire = std::move(on_acquire)});
+    return {b.value};
+  }
+
+  void upload_manager::flush()
+  {
+    if (!_open_batch)
+      return;
+
+    auto& b = *_open_batch;
+    b.command_buffer->end();
+    b.staging_end = _staging_head;
+
+    auto const command_buffer_info = vk::CommandBufferSubmitInfo(b.command_buffer.get());
+    auto const signal = vk::SemaphoreSubmitInfo(_timeline.get(), b.value, vk::PipelineStageFlagBits2::eAllCommands);
+    engine::get().queues().transfer.submit2(
+      vk::SubmitInfo2().setCommandBufferInfos(command_buffer_info).setSignalSemaphoreInfos(signal));
+
+    _in_flight.push_back(std::move(b));
+    _open_batch.reset();
+  }
+
+  upload_ticket upload_manager::acquire(vk::CommandBuffer c)
+  {
+    auto const completed = engine::get().device().getSemaphoreCounterValue(_timeline.get());
+    retire(completed);
+
+    if (completed <= _acquired_value)
+      return {};
+
+    auto const& queues = engine::get().queues();
+    auto const transfer_ownership = needs_ownership_transfer();
+
+    std::vector<pending_acquire> acquired;
+    std::vector<vk::BufferMemoryBarrier2> buffer_barriers;
+    std::vector<vk::ImageMemoryBarrier2> image_barriers;
+    while (!_pending.empty() && _pending.front().value <= completed)
+    {
+      auto& pending = acquired.emplace_back(std::move(_pending.front()));
+      _pending.pop_front();
+
+      if (!transfer_ownership)
+        continue;
+
+      if (pending.target_buffer)
+      {
+        auto& barrier = buffer_barriers.emplace_back();
+        barrier.dstStageMask = vk::PipelineStageFlagBits2::eAllCommands;
+        barrier.dstAccessMask = vk::AccessFlagBits2::eMemoryRead;
+        barrier.srcQueueFamilyIndex = queues.transfer_family;
+        barrier.dstQueueFamilyIndex = queues.graphics_family;
+        barrier.buffer = pending.target_buffer->get_buffer();
+        barrier.offset = pending.offset;
+        barrier.size = pending.size;
+      }
+      else if (pending.target_image)
+      {
+        auto const& img = *pending.target_image;
+        auto& barrier = image_barriers.emplace_back();
+        barrier.oldLayout = vk::ImageLayout::eTransferDstOptimal;
+        barrier.newLayout = vk::ImageLayout::eTransferDstOptimal;
+        barrier.dstStageMask = vk::PipelineStageFlagBits2::eTransfer;
+        barrier.dstAccessMask = vk::AccessFlagBits2::eTransferRead | vk::AccessFlagBits2::eTransferWrite;
+        barrier.srcQueueFamilyIndex = queues.transfer_family;
+        barrier.dstQueueFamilyIndex = queues.graphics_family;
+        barrier.image = img.get_image();
+        barrier.subresourceRange =
+          vk::ImageSubresourceRange(img.aspect_flags(), 0, img.mip_levels(), 0, img.array_layers());
+      }
+    }
+
+    if (!buffer_barriers.empty() || !image_barriers.empty())
+    {
+      c.pipelineBarrier2(
+        vk::DependencyInfo().setBufferMemoryBarriers(buffer_barriers).setImageMemoryBarriers(image_barriers));
+    }
+
+    for (auto& pending : acquired)
+    {
+      if (!pending.target_image)
+        continue;
+
+      pending.target_image->layout_hint(vk::ImageLayout::eTransferDstOptimal, vk::PipelineStageFlagBits2::eTransfer,
+        vk::AccessFlagBits2::eTransferWrite, queues.graphics_family);
+
+      if (pending.on_acquire)
+        pending.on_acquire(c);
+      else
+        pending.target_image->layout(c, vk::ImageLayout::eShaderReadOnlyOptimal,
+          vk::PipelineStageFlagBits2::eFragmentShader | vk::PipelineStageFlagBits2::eComputeShader,
+          vk::AccessFlagBits2::eShaderSampledRead);
+    }
+
+    _acquired_value = completed;
+    return {completed};
+  }
+
+  bool upload_manager::is_complete(upload_ticket ticket) const
+  {
+    return ticket.value <= _acquired_value;
+  }
+
+  void upload_manager::wait(upload_ticket ticket)
+  {
+    if (is_complete(ticket))
+      return;
+
+    if (_open_batch && ticket.value >= _open_batch->value)
+      flush();
+
+    [[maybe_unused]] auto const result = engine::get().device().waitSemaphores(
+      vk::SemaphoreWaitInfo().setSemaphores(_timeline.get()).setValues(ticket.value),
+      std::numeric_limits<std::uint64_t>::max());
+    finish_pending();
+  }
+
+  void upload_manager::wait_all()
+  {
+    wait({_next_value - 1});
+  }
+
+  vk::Semaphore upload_manager::timeline() const
+  {
+    return _timeline.get();
+  }
+
+  upload_manager::batch& upload_manager::open_batch()
+  {
+    if (!_open_batch)
+    {
+      auto& b = _open_batch.emplace();
+      b.value = _next_value++;
+      b.command_buffer = std::move(engine::get().device().allocateCommandBuffersUnique(
+        vk::CommandBufferAllocateInfo(
+          engine::get().queues().transfer_command_pool.get(), vk::CommandBufferLevel::ePrimary, 1))[0]);
+      b.command_buffer->begin(vk::CommandBufferBeginInfo(vk::CommandBufferUsageFlagBits::eOneTimeSubmit));
+    }
+    return *_open_batch;
+  }
+
+  std::pair<vk::Buffer, std::size_t> upload_manager::stage(void const* data, std::size_t size)
+  {
+    if (size > _staging_size)
+    {
+      auto& dedicated =
+        open_batch().dedicated_staging.emplace_back(buffer::host_local(size, vk::BufferUsageFlagBits::eTransferSrc));
+      dedicated->load_data(data, std::uint32_t(size));
+      return {dedicated->get_buffer(), 0};
+    }
+
+    auto const aligned_size = (size + staging_alignment - 1) / staging_alignment * staging_alignment;
+    auto const fits = [&] { return _staging_head + aligned_size - _staging_tail <= _staging_size; };
+
+    if (_staging_head % _staging_size + aligned_size > _staging_size)
+      _staging_head += _staging_size - _staging_head % _staging_size;
+
+    while (!fits())
+    {
+      if (_in_flight.empty())
+        flush();
+
+      if (_in_flight.empty())
+      {
+        _staging_tail = _staging_head;
+        break;
+      }
+
+      auto const oldest = _in_flight.front().value;
+      [[maybe_unused]] auto const result = engine::get().device().waitSemaphores(
+        vk::SemaphoreWaitInfo().setSemaphores(_timeline.get()).setValues(oldest),
+        std::numeric_limits<std::uint64_t>::max());
+      retire(oldest);
+    }
+
+    auto const offset = std::size_t(_staging_head % _staging_size);
+    _staging->load_data(data, std::uint32_t(size), std::uint32_t(offset));
+    _staging_head += aligned_size;
+    return {_staging->get_buffer(), offset};
+  }
+
+  void upload_manager::retire(std::uint64_t completed)
+  {
+    while (!_in_flight.empty() && _in_flight.front().value <= completed)
+    {
+      _staging_tail = _in_flight.front().staging_end;
+      _in_flight.pop_front();
+    }
+
+    if (_in_flight.empty() && !_open_batch)
+      _staging_tail = _staging_head;
+  }
+
+  void upload_manager::finish_pending()
+  {
+    auto const& queues = engine::get().queues();
+    auto const device = engine::get().device();
+
+    auto const cbufs = device.allocateCommandBuffersUnique(
+      vk::CommandBufferAllocateInfo(queues.graphics_command_pool.get(), vk::CommandBufferLevel::ePrimary, 1));
+    auto const fence = device.createFenceUnique({});
+
+    cbufs[0]->begin(vk::CommandBufferBeginInfo(vk::CommandBufferUsageFlagBits::eOneTimeSubmit));
+    auto const ready = acquire(cbufs[0].get());
+    cbufs[0]->end();
+
+    auto const command_buffer_info = vk::CommandBufferSubmitInfo(cbufs[0].get());
+    auto const wait = vk::SemaphoreSubmitInfo(_timeline.get(), ready.value, vk::PipelineStageFlagBits2::eAllCommands);
+    auto submit = vk::SubmitInfo2().setCommandBufferInfos(command_buffer_info);
+    if (ready.value != 0)
+      submit.setWaitSemaphoreInfos(wait);
+    queues.graphics.submit2(submit, fence.get());
+
+    [[maybe_unused]] auto const result =
+      device.waitForFences(fence.get(), true, std::numeric_limits<std::uint64_t>::max());
+  }
+
+  bool upload_manager::needs_ownership_transfer() const
+  {
+    auto const& queues = engine::get().queues();
+    return queues.transfer_family != queues.graphics_family;
+  }
+}    // namespace gev
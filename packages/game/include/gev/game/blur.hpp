@@ -15,8 +15,9 @@ namespace gev::game
   {
   public:
     blur();
-    void apply(vk::CommandBuffer c, blur_dir dir, float step_size, 
-      render_target_2d const& src, render_target_2d const& dst);
+    // Blurs all layers of src in one dispatch. Layer i uses step_size / (1 + i * layer_falloff).
+    void apply(vk::CommandBuffer c, blur_dir dir, float step_size, render_target_2d const& src,
+      render_target_2d const& dst, float layer_falloff = 0.0f);
 
   private:
     vk::UniquePipeline _pipeline;
@@ -6,6 +6,7 @@
 #include <gev/scenery/transform.hpp>
 #include <rnu/math/math.hpp>
 #include <rnu/camera.hpp>
+#include <span>
 
 namespace gev::game
 {
@@ -19,8 +20,13 @@ namespace gev::game
   class camera
   {
   public:
+    constexpr static std::uint32_t max_views = 4;
+
     camera();
 
+    // Unique for the lifetime of the application, unlike the address of a camera.
+    std::uint64_t id() const;
+
     void set_transform(rnu::mat4 transform);
     void set_view(rnu::mat4 view_matrix);
     void set_projection(projection projection);
@@ -28,11 +34,20 @@ namespace gev::game
     projection projection() const;
     rnu::mat4 projection_matrix() const;
 
+    // Overrides the view-projection matrices used by multiview passes. An empty span goes back to the single view
+    // described by view() and projection().
+    void set_views(std::span<rnu::mat4 const> view_projections);
+    std::uint32_t num_views() const;
+
     void sync(vk::CommandBuffer c);
     vk::DescriptorSet descriptor() const;
+    gev::buffer const& uniform_buffer() const;
     void bind(vk::CommandBuffer c, vk::PipelineLayout layout, std::uint32_t binding);
 
   private:
+    void update_views();
+
+    std::uint64_t _id;
     rnu::mat4 _view_matrix;
     game::projection _proj;
     rnu::mat4 _proj_matrix;
@@ -45,6 +60,9 @@ namespace gev::game
         rnu::mat4 proj_matrix = {};
         rnu::mat4 inverse_view_matrix = {};
         rnu::mat4 inverse_proj_matrix = {};
+        rnu::mat4 view_projections[max_views] = {};
+        std::uint32_t num_views = 1;
+        std::uint32_t padding[3] = {};
       } mat;
 
       vk::DescriptorSet descriptor;
@@ -52,5 +70,6 @@ namespace gev::game
       bool dirty = true;
     };
     per_frame_info _per_frame;
+    bool _custom_views = false;
   };
 }    // namespace gev::game
\ No newline at end of file
@@ -10,8 +10,10 @@ namespace gev::game
   class cascaded_shadow_mapping
   {
   public:
-    cascaded_shadow_mapping(vk::Extent2D size, std::size_t num_cascades = 3, float split_lambda = 0.7);
+    // Renders num_shadow_views cascades into the layers of one shadow map array.
+    cascaded_shadow_mapping(vk::Extent2D size, float split_lambda = 0.7);
 
+    // The mesh renderer has to be synced for the current frame already.
     void render(vk::CommandBuffer c, gev::game::camera const& cam, 
       gev::game::mesh_renderer& r, rnu::vec3 direction);
 
@@ -22,13 +24,14 @@ namespace gev::game
     struct cascade
     {
       std::shared_ptr<gev::game::camera> camera;
-      std::shared_ptr<gev::game::renderer> renderer;
       std::shared_ptr<gev::game::shadow_map_instance> instance;
       float split;
     };
 
     vk::Extent2D _size;
     std::vector<cascade> _cascades;
+    std::shared_ptr<gev::game::camera> _camera;
+    std::shared_ptr<gev::game::renderer> _renderer;
     std::unique_ptr<blur> _blur;
     std::unique_ptr<render_target_2d> _blur_tmp;
     float _split_lambda;
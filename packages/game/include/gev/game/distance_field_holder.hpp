@@ -2,6 +2,7 @@
 
 #include <gev/buffer.hpp>
 #include <gev/game/distance_field.hpp>
+#include <gev/game/slot_buffer.hpp>
 #include <memory>
 #include <rnu/math/math.hpp>
 
@@ -13,10 +14,11 @@ namespace gev::game
 
   public:
     void update_transform(rnu::mat4 const& transform);
+    void destroy();
 
   private:
     std::weak_ptr<distance_field_holder> _holder;
-    std::size_t _byte_offset = 0;
+    std::uint32_t _index = 0;
   };
 
   enum class field_id : std::size_t
@@ -36,17 +38,16 @@ namespace gev::game
 
     field_id register_field(std::shared_ptr<distance_field> field);
     std::shared_ptr<distance_field_instance> instantiate(field_id field, rnu::mat4 transform);
+    void destroy(distance_field_instance const& instance);
 
     vk::DescriptorSet descriptor() const;
     vk::DescriptorSetLayout layout() const;
 
-    void try_flush_buffer();
+    void sync(vk::CommandBuffer c);
 
-    void update_transform_internal(std::size_t offset, rnu::mat4 transform);
+    void update_transform_internal(std::uint32_t index, rnu::mat4 transform);
 
   private:
-    void include_update_region(std::size_t begin, std::size_t end);
-
     struct df_info
     {
       rnu::mat4 inverse_transform;
@@ -61,9 +62,7 @@ namespace gev::game
     vk::UniqueDescriptorSet _field_descriptor;
     std::vector<std::shared_ptr<distance_field>> _fields;
 
-    std::vector<df_info> _field_instances;
-    std::size_t _update_region_start = std::numeric_limits<std::size_t>::max();
-    std::size_t _update_region_end = std::numeric_limits<std::size_t>::lowest();
-    std::unique_ptr<gev::buffer> _instances_buffer;
+    // Destroyed instances leave a slot with a field_id of -1 behind until it is reused.
+    slot_buffer<df_info> _field_instances{vk::BufferUsageFlagBits::eStorageBuffer};
   };
 }    // namespace gev::game
\ No newline at end of file
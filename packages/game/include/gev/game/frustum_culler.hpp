@@ -0,0 +1,46 @@
+#pragma once
+
+#include <gev/buffer.hpp>
+#include <rnu/math/math.hpp>
+
+namespace gev::game
+{
+  // Tests instance bounds against the view frusta of a camera. Visible instances are counted into the indexed indirect
+  // command of their mesh and their infos are packed behind the first instance of that command. The commands with
+  // survivors are then compacted into a draw list for drawIndexedIndirectCount.
+  class frustum_culler
+  {
+  public:
+    constexpr static std::uint32_t group_size = 64;
+    constexpr static std::uint32_t no_command = ~0u;
+
+    // Records without a command are skipped, they belong to free slots or to meshes that cannot be drawn yet.
+    struct record
+    {
+      rnu::vec4 bounds_min;
+      rnu::vec4 bounds_max;
+      std::uint32_t command = no_command;
+      std::uint32_t instance = 0;
+      std::uint32_t padding[2] = {};
+    };
+
+    frustum_culler();
+
+    // The commands have to start out with an instance count of zero.
+    void dispatch(vk::CommandBuffer c, gev::buffer const& camera, std::uint32_t num_records,
+      gev::buffer const& instances, gev::buffer const& records, gev::buffer const& commands,
+      gev::buffer const& count, gev::buffer const& visible_instances) const;
+
+    // Has to run after dispatch, the draw count has to start out at zero.
+    void compact(vk::CommandBuffer c, std::uint32_t num_commands, gev::buffer const& commands, gev::buffer const& draws,
+      gev::buffer const& draw_count) const;
+
+  private:
+    vk::UniquePipeline _pipeline;
+    vk::UniquePipelineLayout _layout;
+    vk::UniqueDescriptorSetLayout _set_layout;
+    vk::UniquePipeline _compact_pipeline;
+    vk::UniquePipelineLayout _compact_layout;
+    vk::UniqueDescriptorSetLayout _compact_set_layout;
+  };
+}    // namespace gev::game
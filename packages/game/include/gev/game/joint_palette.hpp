@@ -0,0 +1,49 @@
+#pragma once
+
+#include <gev/buffer.hpp>
+#include <gev/game/mesh_arena.hpp>
+#include <memory>
+#include <rnu/math/math.hpp>
+#include <span>
+#include <vector>
+
+namespace gev::game
+{
+  // The joint matrices of all skins in one host visible buffer with a region per frame in flight. Skins keep their
+  // joint range over frames and only write to the region of the current frame, which the GPU is done with. New ranges
+  // start out with their initial joints in every region, freed ones are only reused once no frame in flight reads them.
+  // The region is selected with a dynamic offset, so one descriptor serves every skinned draw.
+  class joint_palette
+  {
+  public:
+    constexpr static std::uint32_t default_max_joints = 1u << 14;
+
+    joint_palette(std::uint32_t max_joints = default_max_joints);
+
+    // Returns the index of the first joint, instances store it to find their matrices.
+    std::uint32_t allocate(std::span<rnu::mat4 const> joints);
+    void free(std::uint32_t offset, std::uint32_t count);
+    void write(std::uint32_t offset, std::span<rnu::mat4 const> joints);
+
+    vk::DescriptorSet descriptor() const;
+    gev::buffer const& buffer() const;
+    // The dynamic offset of the current frame, in bytes.
+    std::uint32_t frame_offset() const;
+    std::uint32_t region_size() const;
+
+  private:
+    struct retired_range
+    {
+      std::uint32_t offset;
+      std::uint32_t count;
+      std::uint64_t reuse_frame;
+    };
+
+    std::uint32_t _num_frames;
+    std::uint32_t _region_size;
+    range_allocator _joints;
+    std::vector<retired_range> _retired;
+    std::unique_ptr<gev::buffer> _buffer;
+    vk::DescriptorSet _descriptor;
+  };
+}    // namespace gev::game
@@ -2,6 +2,7 @@
 #pragma once
 
 #include <gev/engine.hpp>
+#include <gev/game/material_table.hpp>
 #include <gev/game/texture.hpp>
 #include <rnu/math/math.hpp>
 #include <gev/res/serializer.hpp>
@@ -12,6 +13,11 @@ namespace gev::game
   class material : public serializable
   {
   public:
+    material() = default;
+    material(material const&) = delete;
+    material& operator=(material const&) = delete;
+    ~material();
+
     void load_diffuse(std::shared_ptr<texture> dt);
     void load_roughness(std::shared_ptr<texture> rt);
 
@@ -19,18 +25,23 @@ namespace gev::game
     void set_roughness(float r);
 
     void set_two_sided(bool enable);
-    void bind(vk::CommandBuffer c, vk::PipelineLayout layout, std::uint32_t binding);
+    bool two_sided() const;
+
+    std::uint32_t index();
 
     void serialize(serializer& base, std::ostream& out) override;
     void deserialize(serializer& base, std::istream& in) override;
 
   private:
-    void bind_or_unbind(std::shared_ptr<texture> const& t, std::uint32_t binding, std::uint32_t flags);
+    constexpr static std::uint32_t no_texture = ~0u;
+
+    void update_table(bool textures_changed);
+    void release_textures(material_table& table);
 
     struct material_info
     {
-      constexpr static std::uint32_t has_diffuse = 0x1;
-      constexpr static std::uint32_t has_roughness = 0x2;
+      constexpr static std::uint32_t has_diffuse = gpu_material::has_diffuse;
+      constexpr static std::uint32_t has_roughness = gpu_material::has_roughness;
 
       rnu::vec4ui8 diffuse = {255, 255, 255, 255};
       std::uint16_t roughness = rnu::to_half(0.2);
@@ -39,11 +50,12 @@ namespace gev::game
     } _data;
 
     bool _two_sided = false;
-    vk::DescriptorSet _texture_descriptor;
     std::shared_ptr<texture> _diffuse;
     std::shared_ptr<texture> _roughness;
 
-    bool _update_buffer = false;
-    std::shared_ptr<gev::buffer> _data_buffer;
+    std::weak_ptr<material_table> _table;
+    std::uint32_t _index = 0;
+    std::uint32_t _diffuse_slot = no_texture;
+    std::uint32_t _roughness_slot = no_texture;
   };
-}    // namespace gev::game
\ No newline at end of file
+}    // namespace gev::game
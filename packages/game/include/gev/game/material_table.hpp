@@ -0,0 +1,85 @@
+#pragma once
+
+#include <gev/game/sync_buffer.hpp>
+#include <gev/game/texture.hpp>
+#include <memory>
+#include <rnu/math/math.hpp>
+#include <unordered_map>
+#include <vector>
+
+namespace gev::game
+{
+  struct gpu_material
+  {
+    constexpr static std::uint32_t has_diffuse = 0x1;
+    constexpr static std::uint32_t has_roughness = 0x2;
+
+    rnu::vec4ui8 diffuse = {255, 255, 255, 255};
+    std::uint16_t roughness = rnu::to_half(0.2);
+    std::uint16_t metadata = 0;
+    std::uint32_t flags = 0x0;
+    std::uint32_t diffuse_texture = 0;
+    std::uint32_t roughness_texture = 0;
+  };
+
+  class material_table
+  {
+  public:
+    constexpr static std::uint32_t binding_materials = 0;
+    constexpr static std::uint32_t binding_textures = 1;
+
+    constexpr static std::uint32_t max_num_materials = 4096;
+    constexpr static std::uint32_t max_num_textures = 4096;
+
+    material_table();
+
+    std::uint32_t allocate_material();
+    void free_material(std::uint32_t index);
+    void update_material(std::uint32_t index, gpu_material const& data);
+
+    // The slot is only written to the descriptor once the texture is uploaded, until then materials referencing it are
+    // drawn as if they had no texture.
+    std::uint32_t acquire_texture(std::shared_ptr<texture> const& t);
+    void release_texture(std::uint32_t slot);
+
+    vk::DescriptorSet descriptor() const;
+
+    void sync(vk::CommandBuffer c);
+
+  private:
+    bool bind_uploaded_textures();
+    gpu_material visible_material(gpu_material material) const;
+
+    struct texture_slot
+    {
+      std::shared_ptr<texture> source;
+      std::uint32_t references = 0;
+      bool bound = false;
+    };
+
+    struct retired_slot
+    {
+      std::uint32_t index;
+      std::uint64_t reuse_frame;
+    };
+
+    std::uint32_t _num_frames = 1;
+    std::uint64_t _frame = 0;
+
+    vk::UniqueDescriptorPool _pool;
+    vk::UniqueDescriptorSet _descriptor;
+
+    std::vector<gpu_material> _materials;
+    std::vector<std::uint32_t> _free_materials;
+    std::vector<retired_slot> _retired_materials;
+    bool _materials_dirty = true;
+    std::unique_ptr<sync_buffer> _materials_buffer;
+    std::vector<gpu_material> _visible_materials;
+
+    std::vector<texture_slot> _textures;
+    std::unordered_map<texture const*, std::uint32_t> _texture_slots;
+    std::vector<std::uint32_t> _free_textures;
+    std::vector<retired_slot> _retired_textures;
+    std::vector<std::uint32_t> _pending_textures;
+  };
+}    // namespace gev::game
@@ -2,8 +2,11 @@
 
 #include <filesystem>
 #include <gev/buffer.hpp>
+#include <gev/engine.hpp>
+#include <gev/game/mesh_arena.hpp>
 #include <gev/scenery/gltf.hpp>
 #include <gev/res/serializer.hpp>
+#include <gev/upload_manager.hpp>
 #include <rnu/obj.hpp>
 
 namespace gev::game
@@ -12,21 +15,33 @@ namespace gev::game
   {
   public:
     mesh() = default;
-    mesh(std::filesystem::path const& path);
-    mesh(rnu::triangulated_object_t const& tri);
+    mesh(std::filesystem::path const& path, vertex_format format = vertex_format::standard);
+    mesh(rnu::triangulated_object_t const& tri, vertex_format format = vertex_format::standard);
+    mesh(mesh const&) = delete;
+    mesh& operator=(mesh const&) = delete;
+    ~mesh();
+
+    // Standard vertices that share the indices of a skinned source, written by the skinning pass instead of uploads.
+    static std::shared_ptr<mesh> make_skinning_target(std::shared_ptr<mesh> source);
 
     void draw(vk::CommandBuffer c, std::uint32_t instance_count = 1, std::uint32_t base_instance = 0);
 
     void make_skinned(std::span<scenery::joint const> joints);
-    void load(rnu::triangulated_object_t const& tri);
+    void load(rnu::triangulated_object_t const& tri, vertex_format format = vertex_format::standard);
 
     std::uint32_t num_indices() const;
+    mesh_range const& range() const;
+    bool is_skinned() const;
+    bool is_uploaded() const;
+    std::uint32_t version() const;
+    vertex_format format() const;
+
+    // Maps the stored positions back to mesh space: position = decode_offset + stored * decode_scale.
+    rnu::vec3 const& decode_offset() const;
+    rnu::vec3 const& decode_scale() const;
+
     gev::buffer const& index_buffer() const;
     gev::buffer const& vertex_buffer() const;
-    gev::buffer const& normal_buffer() const;
-    gev::buffer const& texcoords_buffer() const;
-
-    gev::buffer const* joints_buffer() const;
 
     rnu::box3f const& bounds() const;
     
@@ -34,18 +49,26 @@ namespace gev::game
     void deserialize(serializer& base, std::istream& in) override;
 
   private:
-    void init(rnu::triangulated_object_t const& obj);
+    void init(rnu::triangulated_object_t const& obj, vertex_format format);
     void init(rnu::box3f bounds, std::span<std::uint32_t const> indices,
       std::span<rnu::vec4 const> positions,
       std::span<rnu::vec3 const> normals,
-      std::span<rnu::vec2 const> texcoords);
+      std::span<rnu::vec2 const> texcoords,
+      vertex_format format);
+
+    void release();
 
     rnu::box3f _bounds;
     std::uint32_t _num_indices = 0;
-    std::unique_ptr<gev::buffer> _index_buffer;
-    std::unique_ptr<gev::buffer> _vertex_buffer;
-    std::unique_ptr<gev::buffer> _normal_buffer;
-    std::unique_ptr<gev::buffer> _texcoords_buffer;
-    std::unique_ptr<gev::buffer> _joints_buffer;
+    std::weak_ptr<mesh_arena> _arena;
+    mesh_range _range;
+    bool _skinned = false;
+    std::uint32_t _version = 0;
+    vertex_format _format = vertex_format::standard;
+    rnu::vec3 _decode_offset = rnu::vec3(0, 0, 0);
+    rnu::vec3 _decode_scale = rnu::vec3(1, 1, 1);
+    upload_ticket _upload;
+    service_proxy<upload_manager> _uploads;
+    std::shared_ptr<mesh> _index_source;
   };
 }    // namespace gev::game
\ No newline at end of file
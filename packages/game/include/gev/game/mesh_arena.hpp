@@ -0,0 +1,116 @@
+#pragma once
+
+#include <gev/buffer.hpp>
+#include <gev/scenery/gltf.hpp>
+#include <map>
+#include <memory>
+#include <optional>
+#include <rnu/math/math.hpp>
+#include <vector>
+
+namespace gev::game
+{
+  class range_allocator
+  {
+  public:
+    range_allocator(std::uint32_t capacity, std::uint32_t granularity);
+
+    std::optional<std::uint32_t> allocate(std::uint32_t count);
+    void free(std::uint32_t offset, std::uint32_t count);
+
+  private:
+    std::uint32_t round_up(std::uint32_t count) const;
+
+    std::uint32_t _granularity;
+    std::map<std::uint32_t, std::uint32_t> _free;
+  };
+
+  enum class vertex_format : std::uint32_t
+  {
+    // Separate fp32 position, normal and texcoord streams.
+    standard = 0,
+    // One interleaved stream of packed_vertex.
+    packed = 1,
+  };
+
+  // Positions are snorm16 relative to the mesh bounds, normals are octahedral snorm16 and texcoords are half floats.
+  struct packed_vertex
+  {
+    std::int16_t position[4];
+    std::int16_t normal[2];
+    std::uint16_t texcoord[2];
+  };
+
+  struct packed_joint
+  {
+    std::uint16_t indices[4];
+    std::uint8_t weights[4];
+  };
+
+  struct mesh_range
+  {
+    std::uint32_t first_index = 0;
+    std::uint32_t index_count = 0;
+    std::uint32_t first_vertex = 0;
+    std::uint32_t vertex_count = 0;
+    vertex_format format = vertex_format::standard;
+  };
+
+  // One set of vertex streams and one index buffer that all meshes suballocate from, so that every mesh can be drawn
+  // with the same bindings.
+  //
+  // The capacity is fixed, the streams are never reallocated because pending uploads and frames in flight reference
+  // them directly. The defaults hold 2M vertices per format and 8M indices in about 150 MiB, allocations beyond that
+  // throw. Applications that need more register the arena with their own limits before the first mesh is created:
+  // gev::register_service<gev::game::mesh_arena>(max_vertices, max_indices, max_packed_vertices).
+  class mesh_arena
+  {
+  public:
+    constexpr static std::uint32_t default_max_vertices = 1u << 21;
+    constexpr static std::uint32_t default_max_indices = 1u << 23;
+    constexpr static std::uint32_t default_max_packed_vertices = 1u << 21;
+
+    static std::shared_ptr<mesh_arena> defaults();
+
+    mesh_arena(std::uint32_t max_vertices = default_max_vertices, std::uint32_t max_indices = default_max_indices,
+      std::uint32_t max_packed_vertices = default_max_packed_vertices);
+
+    mesh_range allocate(
+      std::uint32_t vertex_count, std::uint32_t index_count, vertex_format format = vertex_format::standard);
+    void free(mesh_range const& range);
+
+    void bind(vk::CommandBuffer c, vertex_format format = vertex_format::standard) const;
+    void sync();
+
+    std::shared_ptr<gev::buffer> const& index_buffer() const;
+    std::shared_ptr<gev::buffer> const& position_buffer() const;
+    std::shared_ptr<gev::buffer> const& normal_buffer() const;
+    std::shared_ptr<gev::buffer> const& texcoords_buffer() const;
+    std::shared_ptr<gev::buffer> const& packed_buffer() const;
+    std::shared_ptr<gev::buffer> const& joints_buffer();
+
+  private:
+    struct retired_range
+    {
+      mesh_range range;
+      std::uint64_t reuse_frame;
+    };
+
+    std::uint32_t _max_vertices;
+    std::uint32_t _max_indices;
+    std::uint32_t _max_packed_vertices;
+    std::uint32_t _num_frames = 1;
+    std::uint64_t _frame = 0;
+    range_allocator _vertices;
+    range_allocator _packed_vertices;
+    range_allocator _indices;
+    std::vector<retired_range> _retired;
+
+    std::shared_ptr<gev::buffer> _index_buffer;
+    std::shared_ptr<gev::buffer> _position_buffer;
+    std::shared_ptr<gev::buffer> _normal_buffer;
+    std::shared_ptr<gev::buffer> _texcoords_buffer;
+    std::shared_ptr<gev::buffer> _packed_buffer;
+    std::shared_ptr<gev::buffer> _joints_buffer;
+  };
+}    // namespace gev::game
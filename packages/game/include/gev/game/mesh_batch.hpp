@@ -1,7 +1,11 @@
 #pragma once
 
+#include <array>
 #include <gev/engine.hpp>
+#include <gev/game/frustum_culler.hpp>
 #include <gev/game/mesh.hpp>
+#include <gev/game/mesh_arena.hpp>
+#include <gev/game/slot_buffer.hpp>
 #include <gev/game/sync_buffer.hpp>
 #include <memory>
 #include <rnu/math/math.hpp>
@@ -10,19 +14,29 @@
 
 namespace gev::game
 {
+  class camera;
   class mesh_batch;
+
+  struct cull_statistics
+  {
+    std::uint32_t instances = 0;
+    std::uint32_t visible = 0;
+  };
+
   class mesh_instance
   {
     friend class mesh_batch;
 
   public:
     void update_transform(rnu::mat4 const& transform);
+    // Index of the first joint matrix in the joint palette, only read by skinned shaders.
+    void update_joint_offset(std::uint32_t offset);
     void destroy();
 
   private:
     std::shared_ptr<mesh> _mesh;
     std::weak_ptr<mesh_batch> _holder;
-    std::size_t _byte_offset = 0;
+    std::uint32_t _slot = 0;
   };
 
   class mesh_batch : public std::enable_shared_from_this<mesh_batch>
@@ -30,40 +44,105 @@ namespace gev::game
   public:
     static constexpr std::uint32_t binding_instances = 0;
     static constexpr std::size_t min_reserved_elements = 32;
+    static constexpr std::uint32_t min_block_size = 4;
 
     mesh_batch();
-    std::shared_ptr<mesh_instance> instantiate(std::shared_ptr<mesh> const& id, rnu::mat4 transform);
+    std::shared_ptr<mesh_instance> instantiate(
+      std::shared_ptr<mesh> const& id, rnu::mat4 transform, std::uint32_t material_index = 0);
     void destroy(std::shared_ptr<mesh_instance> instance);
     void destroy(mesh_instance const& instance);
+    // Moves all instances using the material to the target batch, the instance handles stay valid and keep their state.
+    void transfer_material(std::uint32_t material_index, mesh_batch& target);
+    bool uses_material(std::uint32_t material_index) const;
     void try_flush_buffer(vk::CommandBuffer c);
 
     vk::DescriptorSet descriptor() const;
+    // Views culled this frame read the packed infos of their visible instances instead.
+    vk::DescriptorSet descriptor(camera const& cam) const;
 
-    void render(vk::CommandBuffer c);
+    void cull(vk::CommandBuffer c, frustum_culler const& culler, camera const& cam);
+    void render(vk::CommandBuffer c, camera const& cam);
+    cull_statistics statistics(camera const& cam) const;
 
-    void update_transform_internal(std::size_t offset, rnu::mat4 transform);
+    void update_transform_internal(std::uint32_t slot, rnu::mat4 transform);
+    void update_joint_offset_internal(std::uint32_t slot, std::uint32_t offset);
 
   private:
-    void include_update_region(std::size_t begin, std::size_t end);
+    struct mesh_ref;
+    struct cull_frame;
 
+    mesh_ref& insert(std::shared_ptr<mesh_instance> const& instance, std::shared_ptr<mesh> const& id);
+    void flush_commands(vk::CommandBuffer c);
+    void grow(mesh_ref& ref);
+    void compact(std::uint32_t extra_slots);
+    void move_slot(std::uint32_t from, std::uint32_t to);
+    void clear_slot(std::uint32_t slot);
+    frustum_culler::record make_record(mesh const& m, mesh_ref const& ref, std::uint32_t slot) const;
+    cull_frame const* culled_slot(camera const& cam) const;
+
+    // Only the rows of the affine transform are stored, shaders derive the normal matrix themselves.
     struct mesh_info
     {
-      rnu::mat4 transform;
-      rnu::mat4 inverse_transform;
+      std::array<rnu::vec4, 3> transform;
+      std::uint32_t material_index;
+      std::uint32_t joint_offset;
+      std::uint32_t padding[2];
     };
 
+    // Every mesh owns a block of slots, its instances are packed at the front of it so that they can be drawn with a
+    // single instanced command.
     struct mesh_ref
     {
-      std::size_t first_instance;
-      std::size_t instance_count;
+      std::uint32_t first_slot = 0;
+      std::uint32_t instance_count = 0;
+      std::uint32_t capacity = 0;
+      std::uint32_t mesh_version = ~0u;
+      std::uint32_t command = frustum_culler::no_command;
+      bool drawable = false;
+      rnu::vec3 decode_offset = rnu::vec3(0, 0, 0);
+      rnu::vec3 decode_scale = rnu::vec3(1, 1, 1);
     };
 
     std::unordered_map<std::shared_ptr<mesh>, mesh_ref> _instance_refs;
+    range_allocator _slots{0, 1};
+    std::uint32_t _num_instances = 0;
     std::vector<std::shared_ptr<mesh_instance>> _instances;
-    std::vector<mesh_info> _mesh_infos;
-    std::size_t _update_region_start = std::numeric_limits<std::size_t>::max();
-    std::size_t _update_region_end = std::numeric_limits<std::size_t>::lowest();
-    std::unique_ptr<gev::game::sync_buffer> _instances_buffer;
+    slot_buffer<mesh_info> _mesh_infos{vk::BufferUsageFlagBits::eStorageBuffer};
+
+    // One indexed draw per mesh, all sourced from the shared mesh arena. Unused slots keep an empty cull record.
+    // Culled views start from a copy of the commands without instances and count their survivors into them.
+    std::vector<vk::DrawIndexedIndirectCommand> _commands;
+    std::vector<vk::DrawIndexedIndirectCommand> _cull_commands;
+    std::unique_ptr<gev::game::sync_buffer> _commands_buffer;
+    std::unique_ptr<gev::game::sync_buffer> _cull_commands_buffer;
+    bool _commands_dirty = true;
+
+    // Every frame in flight culls into its own buffers and set, they are only grown once the fence of that frame has
+    // been waited on.
+    struct cull_frame
+    {
+      std::unique_ptr<gev::buffer> commands;
+      std::unique_ptr<gev::buffer> infos;
+      std::unique_ptr<gev::buffer> draws;
+      std::unique_ptr<gev::buffer> count;
+      std::unique_ptr<gev::buffer> draw_count;
+      std::unique_ptr<gev::buffer> readback;
+      vk::DescriptorSet descriptor;
+      std::uint32_t num_commands = 0;
+    };
+
+    struct cull_view
+    {
+      vk::UniqueDescriptorPool pool;
+      std::vector<cull_frame> frames;
+      std::uint64_t culled_frame = ~0ull;
+      std::uint32_t instances = 0;
+      std::uint32_t visible = 0;
+    };
+
+    slot_buffer<frustum_culler::record> _cull_records{vk::BufferUsageFlagBits::eStorageBuffer};
+    // Keyed by camera id, views that were not culled for longer than the frames in flight are dropped.
+    std::unordered_map<std::uint64_t, cull_view> _views;
 
     vk::UniqueDescriptorPool _mesh_pool;
     vk::UniqueDescriptorSet _mesh_descriptor;
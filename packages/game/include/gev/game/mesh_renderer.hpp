@@ -1,15 +1,21 @@
 #pragma once
 #pragma once
 
+#include <array>
 #include <gev/buffer.hpp>
 #include <gev/engine.hpp>
 #include <gev/game/distance_field_holder.hpp>
+#include <gev/game/frustum_culler.hpp>
+#include <gev/game/joint_palette.hpp>
 #include <gev/game/material.hpp>
+#include <gev/game/material_table.hpp>
 #include <gev/game/mesh.hpp>
+#include <gev/game/mesh_arena.hpp>
 #include <gev/game/mesh_batch.hpp>
 #include <gev/game/renderer.hpp>
 #include <gev/game/shader.hpp>
 #include <gev/game/shadow_map_holder.hpp>
+#include <gev/game/skinning_pass.hpp>
 #include <gev/per_frame.hpp>
 #include <rnu/math/math.hpp>
 #include <vector>
@@ -29,21 +35,47 @@ namespace gev::game
 
     mesh_renderer();
 
+    // Culls all batches against the camera. Renders for that camera later in the frame only draw the visible instances.
+    void cull(vk::CommandBuffer c, camera const& cam);
     void render(vk::CommandBuffer c, camera const& cam, std::int32_t x, std::int32_t y, std::uint32_t w,
       std::uint32_t h, pass_id pass, vk::SampleCountFlagBits samples);
+    cull_statistics statistics(camera const& cam) const;
 
     std::shared_ptr<mesh_batch> batch(std::shared_ptr<shader> const& shader, std::shared_ptr<material> const& material);
+    std::shared_ptr<mesh_instance> instantiate(std::shared_ptr<shader> const& shader,
+      std::shared_ptr<material> const& material, std::shared_ptr<mesh> const& mesh, rnu::mat4 const& transform);
+    std::shared_ptr<material_table> const& materials() const;
+    // Moves the instances of the material to the batches of the given cull mode, called when a material changes it.
+    void set_two_sided(std::uint32_t material_index, bool two_sided);
 
+    // Only the first call of a frame does anything, changes made after it are synced in the next frame. Also runs the
+    // skinning pass, after the batches decided which meshes are drawable this frame.
     void sync(vk::CommandBuffer c);
 
+    // Skinned meshes can be skinned once per frame by the skinning pass and drawn with the standard shader, instead of
+    // being skinned by the vertex shader of every pass. Only applies to instances created afterwards.
+    void set_compute_skinning(bool enabled);
+    bool compute_skinning() const;
+    skinning_pass& skinning();
+    // Shared by all skins, skinned shaders and the skinning pass read it.
+    std::shared_ptr<joint_palette> const& palette() const;
+
     void set_environment_map(vk::DescriptorSet set);
     void set_shadow_maps(vk::DescriptorSet set);
 
   protected:
-    using batch_map = std::unordered_map<std::shared_ptr<shader>,
-      std::unordered_map<std::shared_ptr<material>, std::shared_ptr<mesh_batch>>>;
+    // All materials share one descriptor set, so batches are only split by shader and by cull mode
+    // (index 1 holds the two-sided materials).
+    using batch_map = std::unordered_map<std::shared_ptr<shader>, std::array<std::shared_ptr<mesh_batch>, 2>>;
 
     std::shared_ptr<batch_map> _batches;
+    std::shared_ptr<material_table> _materials;
+    std::shared_ptr<mesh_arena> _arena;
+    std::unique_ptr<frustum_culler> _culler;
+    std::unique_ptr<skinning_pass> _skinning;
+    std::shared_ptr<joint_palette> _palette;
+    bool _compute_skinning = false;
+    std::uint64_t _synced_frame = ~0ull;
 
     vk::DescriptorSet _shadow_map_set;
     vk::DescriptorSet _environment_set;
@@ -8,15 +8,18 @@ namespace gev::game
   {
   public:
     render_target_2d(vk::Extent2D size, vk::Format format, vk::ImageUsageFlags usage,
-      vk::SampleCountFlagBits samples = vk::SampleCountFlagBits::e1);
+      vk::SampleCountFlagBits samples = vk::SampleCountFlagBits::e1, std::uint32_t layers = 1);
     render_target_2d(std::shared_ptr<gev::image> image);
     render_target_2d(std::shared_ptr<gev::image> image, vk::ImageView view);
     std::shared_ptr<gev::image> const& image() const;
     vk::ImageView view() const;
+    // A 2D array view over all layers, for passes that process every layer at once.
+    vk::ImageView array_view() const;
 
   private:
     std::shared_ptr<gev::image> _image;
     vk::UniqueImageView _owning_view;
     vk::ImageView _view;
+    mutable vk::UniqueImageView _array_view;
   };
 }
\ No newline at end of file
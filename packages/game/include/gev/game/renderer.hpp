@@ -23,6 +23,9 @@ namespace gev::game
     void set_render_size(vk::Extent2D size);
     void set_samples(vk::SampleCountFlagBits samples);
     vk::SampleCountFlagBits get_samples() const;
+    // Layered renderers render all layers at once, one multiview view per layer.
+    void set_layers(std::uint32_t layers);
+    std::uint32_t get_layers() const;
 
     void prepare_frame(vk::CommandBuffer c, bool use_depth = true, bool use_color = true);
     void begin_render(vk::CommandBuffer c, bool use_depth = true, bool use_color = true);
@@ -54,10 +57,12 @@ namespace gev::game
     vk::Extent2D _render_size;
     bool _used_depth = false;
     bool _used_color = false;
+    bool _used_view_mask = false;
     vk::RenderingAttachmentInfo _color_attachment;
     vk::RenderingAttachmentInfo _depth_attachment;
 
     vk::SampleCountFlagBits _samples = vk::SampleCountFlagBits::e1;
+    std::uint32_t _layers = 1;
 
     bool _rebuild_attachments = true;
   };
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <gev/game/mesh_arena.hpp>
 #include <gev/res/repo.hpp>
 #include <rnu/algorithm/hash.hpp>
 #include <vector>
@@ -13,21 +14,38 @@ namespace gev::game
     shadow = 1
   };
 
+  constexpr pass_id all_passes[] = {pass_id::forward, pass_id::shadow};
+
+  // Shadow passes render all cascades of a layered shadow map at once, one multiview view per layer.
+  constexpr std::uint32_t num_shadow_views = 4;
+
+  constexpr std::uint32_t view_mask(pass_id pass)
+  {
+    return pass == pass_id::shadow ? (1u << num_shadow_views) - 1 : 0u;
+  }
+
   class shader
   {
   public:
     static std::shared_ptr<shader> make_default();
     static std::shared_ptr<shader> make_skinned();
+    static std::shared_ptr<shader> make_packed();
 
     shader();
 
     void invalidate();
     void bind(vk::CommandBuffer c, pass_id pass);
     void attach(vk::CommandBuffer c, vk::DescriptorSet set, std::uint32_t index);
+    void attach(vk::CommandBuffer c, vk::DescriptorSet set, std::uint32_t index, std::uint32_t dynamic_offset);
     void attach_always(vk::DescriptorSet set, std::uint32_t index);
 
     vk::Pipeline pipeline(pass_id pass);
     vk::PipelineLayout layout() const;
+    virtual bool supports(pass_id pass) const;
+    // The layout of the vertices drawn with this shader, meshes have to match it.
+    virtual vertex_format format() const;
+    // Skinned shaders read the joint palette from the skin set.
+    virtual bool skinned() const;
 
   protected:
     virtual vk::UniquePipelineLayout rebuild_layout() = 0;
@@ -71,11 +89,16 @@ namespace gev::game
     shader_repo();
 
     void invalidate_all() const;
+
+    // Builds the pipelines of all shaders for every pass they support, one shader per worker thread.
+    // Blocks until all of them are done.
+    void prewarm() const;
   };
 
   namespace shaders
   {
     constexpr static resource_id standard = "DEFAULT";
     constexpr static resource_id skinned = "SKINNED";
+    constexpr static resource_id packed = "PACKED";
   }    // namespace shaders
 }    // namespace gev::game
\ No newline at end of file
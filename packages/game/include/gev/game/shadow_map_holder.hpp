@@ -2,10 +2,10 @@
 
 #include <gev/buffer.hpp>
 #include <gev/image.hpp>
-#include <gev/game/sync_buffer.hpp>
+#include <gev/game/slot_buffer.hpp>
+#include <map>
 #include <memory>
 #include <rnu/math/math.hpp>
-#include <unordered_map>
 
 namespace gev::game
 {
@@ -25,7 +25,8 @@ namespace gev::game
   private:
     std::weak_ptr<shadow_map_holder> _holder;
     std::shared_ptr<gev::image> _map;
-    std::size_t _byte_offset = 0;
+    std::uint32_t _layer = 0;
+    std::uint32_t _index = 0;
   };
 
   class shadow_map_holder : public std::enable_shared_from_this<shadow_map_holder>
@@ -39,20 +40,19 @@ namespace gev::game
 
     shadow_map_holder();
 
-    std::shared_ptr<shadow_map_instance> instantiate(std::shared_ptr<gev::image> map, rnu::mat4 matrix);
-    void destroy(std::shared_ptr<gev::image> map);
+    std::shared_ptr<shadow_map_instance> instantiate(
+      std::shared_ptr<gev::image> map, rnu::mat4 matrix, std::uint32_t layer = 0);
+    void destroy(std::shared_ptr<gev::image> map, std::uint32_t layer = 0);
 
     vk::DescriptorSet descriptor() const;
 
     void sync(vk::CommandBuffer c);
 
-    void update_matrix_internal(std::size_t offset, rnu::mat4 matrix);
-    void make_csm_root_internal(std::size_t offset, int num_cascades);
-    void set_cascade_split_internal(std::size_t offset, float depth);
+    void update_matrix_internal(std::uint32_t index, rnu::mat4 matrix);
+    void make_csm_root_internal(std::uint32_t index, int num_cascades);
+    void set_cascade_split_internal(std::uint32_t index, float depth);
 
   private:
-    void include_update_region(std::size_t begin, std::size_t end);
-
     struct sm_info
     {
       rnu::mat4 matrix;
@@ -72,12 +72,12 @@ namespace gev::game
     vk::UniqueDescriptorPool _map_pool;
     vk::UniqueDescriptorSet _map_descriptor;
 
-    std::unordered_map<std::shared_ptr<gev::image>, map_info> _instance_refs;
-    std::vector<sm_info> _map_instances;
+    // Every layer of a layered map is sampled as a separate shadow map.
+    std::map<std::pair<std::shared_ptr<gev::image>, std::uint32_t>, map_info> _instance_refs;
+    // Shaders walk the maps in order up to a terminating entry and expect cascades to be adjacent, so the records stay
+    // packed instead of reusing freed slots.
+    slot_buffer<sm_info> _map_instances{vk::BufferUsageFlagBits::eStorageBuffer};
     std::vector<std::shared_ptr<shadow_map_instance>> _instances;
-    std::size_t _update_region_start = std::numeric_limits<std::size_t>::max();
-    std::size_t _update_region_end = std::numeric_limits<std::size_t>::lowest();
-    std::unique_ptr<gev::game::sync_buffer> _instances_buffer;
 
     vk::UniqueSampler _sampler;
   };
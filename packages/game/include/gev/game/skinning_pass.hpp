@@ -0,0 +1,55 @@
+#pragma once
+
+#include <gev/buffer.hpp>
+#include <gev/game/joint_palette.hpp>
+#include <gev/game/mesh.hpp>
+#include <memory>
+#include <vector>
+
+namespace gev::game
+{
+  class skinning_pass;
+
+  class skinned_instance
+  {
+    friend class skinning_pass;
+
+  public:
+    constexpr static std::uint32_t no_palette = ~0u;
+
+    // A standard mesh holding the skinned vertices, it is drawn with the non-skinned shaders in every pass.
+    std::shared_ptr<mesh> const& target() const;
+    // Index of the first joint matrix of the skin in the joint palette. Without it the target keeps the rest pose.
+    void set_palette(std::uint32_t offset);
+
+  private:
+    std::shared_ptr<mesh> _source;
+    std::shared_ptr<mesh> _target;
+    std::uint32_t _palette_offset = no_palette;
+    bool _initialized = false;
+  };
+
+  // Skins meshes with a compute shader once per frame, instead of in the vertex shader of every pass that draws them.
+  // The results live in the standard streams of the mesh arena, so they can also be read like any static mesh.
+  class skinning_pass
+  {
+  public:
+    constexpr static std::uint32_t group_size = 64;
+
+    skinning_pass();
+
+    // The instance is skinned by every dispatch until it is released.
+    std::shared_ptr<skinned_instance> add(std::shared_ptr<mesh> const& source);
+    // Writes the skinned vertices of all instances, they are ready for vertex input and compute shaders afterwards.
+    void dispatch(vk::CommandBuffer c, joint_palette const& palette);
+
+  private:
+    void initialize(vk::CommandBuffer c, skinned_instance& instance) const;
+
+    std::vector<std::weak_ptr<skinned_instance>> _instances;
+
+    vk::UniquePipeline _pipeline;
+    vk::UniquePipelineLayout _layout;
+    vk::UniqueDescriptorSetLayout _set_layout;
+  };
+}    // namespace gev::game
@@ -0,0 +1,176 @@
+#pragma once
+
+#include <bit>
+#include <gev/game/sync_buffer.hpp>
+#include <map>
+#include <memory>
+#include <vector>
+
+namespace gev::game
+{
+  // A CPU-side array of GPU records mirrored into a storage buffer. Edits are tracked as disjoint dirty ranges so that
+  // a sync only copies the records that changed. Staging follows the frame slot of the sync_buffer, so syncing more
+  // than once per frame only uploads what changed in between.
+  template<typename T>
+  class slot_buffer
+  {
+  public:
+    constexpr static std::size_t min_reserved_elements = 32;
+    constexpr static std::size_t max_dirty_ranges = 1024;
+
+    explicit slot_buffer(vk::BufferUsageFlags usage)
+      : _usage(usage)
+    {
+    }
+
+    // Reuses a freed slot if there is one, otherwise appends.
+    std::uint32_t allocate(T const& value)
+    {
+      if (_free.empty())
+      {
+        push_back(value);
+        return std::uint32_t(_data.size() - 1);
+      }
+
+      auto const slot = _free.back();
+      _free.pop_back();
+      set(slot, value);
+      return slot;
+    }
+
+    void free(std::uint32_t slot, T const& empty = T{})
+    {
+      set(slot, empty);
+      _free.push_back(slot);
+    }
+
+    void push_back(T const& value)
+    {
+      _data.push_back(value);
+      mark_dirty(_data.size() - 1, _data.size());
+    }
+
+    // Removes a slot and shifts all following ones down, for holders that have to keep their records in order.
+    void erase(std::uint32_t slot)
+    {
+      _data.erase(std::next(_data.begin(), slot));
+      mark_dirty(slot, _data.size());
+    }
+
+    void resize(std::size_t size)
+    {
+      auto const old_size = _data.size();
+      _data.resize(size);
+      if (size > old_size)
+        mark_dirty(old_size, size);
+    }
+
+    void assign(std::vector<T> data)
+    {
+      _data = std::move(data);
+      _free.clear();
+      mark_dirty(0, _data.size());
+    }
+
+    void set(std::uint32_t slot, T const& value)
+    {
+      _data[slot] = value;
+      mark_dirty(slot, slot + 1);
+    }
+
+    T& edit(std::uint32_t slot)
+    {
+      mark_dirty(slot, slot + 1);
+      return _data[slot];
+    }
+
+    T const& operator[](std::uint32_t slot) const
+    {
+      return _data[slot];
+    }
+
+    std::vector<T> const& data() const
+    {
+      return _data;
+    }
+
+    std::size_t size() const
+    {
+      return _data.size();
+    }
+
+    bool empty() const
+    {
+      return _data.empty();
+    }
+
+    bool has_buffer() const
+    {
+      return _buffer != nullptr;
+    }
+
+    gev::buffer const& buffer() const
+    {
+      return _buffer->buffer();
+    }
+
+    // Returns true if the GPU buffer was recreated, descriptors referencing it have to be updated then.
+    bool sync(vk::CommandBuffer c)
+    {
+      auto recreated = false;
+      if (!_buffer || _data.size() * sizeof(T) > _buffer->size())
+      {
+        auto const capacity = std::bit_ceil(std::max(min_reserved_elements, _data.size()));
+        _buffer = std::make_unique<sync_buffer>(capacity * sizeof(T), _usage);
+        _dirty.clear();
+        mark_dirty(0, _data.size());
+        recreated = true;
+      }
+
+      for (auto const& [begin, end] : _dirty)
+      {
+        // Ranges past the end are left from slots that have been removed since.
+        if (begin >= _data.size())
+          continue;
+        auto const count = std::min(end, _data.size()) - begin;
+        _buffer->load_data(&_data[begin], std::uint32_t(count * sizeof(T)), std::uint32_t(begin * sizeof(T)));
+      }
+      _dirty.clear();
+      _buffer->sync(c);
+      return recreated;
+    }
+
+  private:
+    void mark_dirty(std::size_t begin, std::size_t end)
+    {
+      if (begin >= end)
+        return;
+
+      // Ranges are kept disjoint, touching or overlapping ones are merged.
+      auto iter = _dirty.upper_bound(begin);
+      if (iter != _dirty.begin() && std::prev(iter)->second >= begin)
+        --iter;
+      while (iter != _dirty.end() && iter->first <= end)
+      {
+        begin = std::min(begin, iter->first);
+        end = std::max(end, iter->second);
+        iter = _dirty.erase(iter);
+      }
+      _dirty.emplace(begin, end);
+
+      if (_dirty.size() > max_dirty_ranges)
+      {
+        auto const first = _dirty.begin()->first;
+        auto const last = _dirty.rbegin()->second;
+        _dirty.clear();
+        _dirty.emplace(first, last);
+      }
+    }
+
+    vk::BufferUsageFlags _usage;
+    std::vector<T> _data;
+    std::vector<std::uint32_t> _free;
+    std::map<std::size_t, std::size_t> _dirty;
+    std::unique_ptr<sync_buffer> _buffer;
+  };
+}    // namespace gev::game
@@ -1,15 +1,18 @@
 #pragma once
 
+#include <cstddef>
 #include <gev/buffer.hpp>
+#include <vector>
 
 namespace gev::game
 {
+  // A device local buffer that is written through a host visible staging ring with one slice per frame in flight.
+  // Loads are kept on the CPU until the next sync, which stages them into the slice of the current frame. That slice is
+  // only read by copies of this frame slot, whose fence has been waited on before the frame started.
   class sync_buffer
   {
   public:
-    sync_buffer(std::size_t size, vk::BufferUsageFlags usage, std::size_t num_frames = 1);
-
-    void next_frame();
+    sync_buffer(std::size_t size, vk::BufferUsageFlags usage);
 
     template<typename T>
     void load_data(vk::ArrayProxy<T const> data)
@@ -24,10 +27,18 @@ namespace gev::game
     std::size_t size() const;
 
   private:
+    struct pending_load
+    {
+      std::size_t data_offset;
+      std::uint32_t offset;
+      std::uint32_t size;
+    };
+
     gev::buffer _buffer;
     gev::buffer _staging_buffer;
-    std::size_t _current_frame = 0;
     std::size_t _num_frames = 0;
-    bool _dirty = false;
+    std::vector<std::byte> _pending_data;
+    std::vector<pending_load> _pending;
+    std::vector<vk::BufferCopy> _regions;
   };
-}
\ No newline at end of file
+}
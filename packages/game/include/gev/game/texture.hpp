@@ -3,6 +3,7 @@
 #include <filesystem>
 #include <gev/image.hpp>
 #include <gev/res/serializer.hpp>
+#include <gev/upload_manager.hpp>
 #include <optional>
 
 namespace gev::game
@@ -26,8 +27,9 @@ namespace gev::game
     gev::image const& image() const;
     vk::ImageView view() const;
     vk::Sampler sampler() const;
+    bool is_uploaded() const;
 
-    void bind(vk::DescriptorSet set, std::uint32_t binding);
+    void bind(vk::DescriptorSet set, std::uint32_t binding, std::uint32_t array_element = 0);
 
     void serialize(serializer& base, std::ostream& out) override;
     void deserialize(serializer& base, std::istream& in) override;
@@ -40,12 +42,14 @@ namespace gev::game
     };
 
     void create(vk::ImageViewType view_type, vk::ArrayProxy<std::filesystem::path> const& paths);
+    void upload(void const* data, std::size_t size, std::uint32_t num_levels);
 
-    std::unique_ptr<gev::image> _texture;
+    std::shared_ptr<gev::image> _texture;
     vk::UniqueImageView _texture_view;
     vk::Sampler _sampler;
 
     std::size_t _texel_size;
     sampler_type _sampler_type;
+    upload_ticket _upload;
   };
 }    // namespace gev::game
\ No newline at end of file
@@ -2,7 +2,6 @@
 
 layout(location = 2) in vec2 vertex_texcoord;
 
-layout(set = 1, binding = 0) uniform sampler2D diffuse_texture;
 layout(location = 0) out float color;
 
 mat4 thresholdMatrix =
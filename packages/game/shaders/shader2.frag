@@ -8,6 +8,7 @@ layout(location = 0) in vec3 vertex_position;
 layout(location = 1) in vec3 vertex_normal;
 layout(location = 2) in vec2 vertex_texcoord;
 layout(location = 3) in vec3 vertex_color;
+layout(location = 4) flat in uint vertex_material;
 
 layout(set = 0, binding = 0) uniform Camera
 {
@@ -20,28 +21,34 @@ layout(set = 0, binding = 0) uniform Camera
 const uint has_diffuse = 0x1;
 const uint has_roughness = 0x2;
 
-layout(set = 1, binding = 0) uniform sampler2D diffuse_texture;
-layout(set = 1, binding = 1) uniform sampler2D roughness_texture;
-layout(set = 1, binding = 2) restrict readonly buffer MaterialInfo
+struct material_info
 {
   uint diffuse;
   uint roughness_metadata;
   uint flags;
-} material;
+  uint diffuse_texture;
+  uint roughness_texture;
+};
+
+layout(set = 1, binding = 0, std430) restrict readonly buffer Materials
+{
+  material_info materials[];
+};
+layout(set = 1, binding = 1) uniform sampler2D material_textures[];
 
 layout(set = 4, binding = 0) uniform samplerCube environment_map;
 
-vec4 sample_diffuse(vec2 uv)
+vec4 sample_diffuse(material_info material, vec2 uv)
 {
   if((material.flags & has_diffuse) != 0)
-    return texture(diffuse_texture, uv);
+    return texture(material_textures[nonuniformEXT(material.diffuse_texture)], uv);
   return unpackUnorm4x8(material.diffuse);
 }
 
-float sample_roughness(vec2 uv)
+float sample_roughness(material_info material, vec2 uv)
 {
   if((material.flags & has_roughness) != 0)
-    return texture(roughness_texture, uv).r;
+    return texture(material_textures[nonuniformEXT(material.roughness_texture)], uv).r;
   return unpackHalf2x16(material.roughness_metadata).x;
 }
 
@@ -127,7 +134,8 @@ const vec3 light_color = 1.5 * vec3(1, 0.98, 0.96);
 
 void main()
 {
-  vec4 diffuse_texture_color = sample_diffuse(vertex_texcoord);
+  material_info material = materials[vertex_material];
+  vec4 diffuse_texture_color = sample_diffuse(material, vertex_texcoord);
   ivec2 px = ivec2(gl_FragCoord.xy);
 
   vec3 normal = normalize(vertex_normal);
@@ -140,7 +148,7 @@ void main()
   vec3 to_cam = normalize(cam_pos - vertex_position);
 
   vec3 tex_color = diffuse_texture_color.rgb;
-  float roughness = sample_roughness(vertex_texcoord);
+  float roughness = sample_roughness(material, vertex_texcoord);
 
   vec3 diffuse = vec3(0);
   vec3 specular = vec3(0);
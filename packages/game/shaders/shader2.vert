@@ -1,5 +1,10 @@
 #version 460 core
 
+#extension GL_EXT_multiview : require
+
+// 0 for the standard vertex format, 1 for the packed one with octahedral normals.
+layout(constant_id = 1) const int vertex_format = 0;
+
 layout(location = 0) in vec4 position;
 layout(location = 1) in vec3 normal;
 layout(location = 2) in vec2 texcoord;
@@ -10,12 +15,15 @@ layout(set = 0, binding = 0) uniform Camera
   mat4 proj_matrix;
   mat4 inverse_view_matrix;
   mat4 inverse_proj_matrix;
+  mat4 view_projections[4];
+  uint num_views;
 } camera;
 
 struct entity_info
 {
-  mat4 transform;
-  mat4 inverse_transform;
+  vec4 transform[3];
+  uint material_index;
+  uint joint_offset;
 };
 
 layout(std430, set = 2, binding = 0) restrict readonly buffer EntityInfos
@@ -23,10 +31,34 @@ layout(std430, set = 2, binding = 0) restrict readonly buffer EntityInfos
   entity_info entity_infos[];
 };
 
+// Instances store the rows of their affine transform.
+mat4 entity_transform(entity_info info)
+{
+  return transpose(mat4(info.transform[0], info.transform[1], info.transform[2], vec4(0, 0, 0, 1)));
+}
+
+// The cofactor matrix is the inverse transpose scaled by the determinant, the fragment shader normalizes it away.
+mat3 normal_matrix(mat3 m)
+{
+  return mat3(cross(m[1], m[2]), cross(m[2], m[0]), cross(m[0], m[1])) * sign(determinant(m));
+}
+
+vec3 decode_normal(vec3 n)
+{
+  if (vertex_format != 1)
+    return n;
+
+  vec3 d = vec3(n.xy, 1.0 - abs(n.x) - abs(n.y));
+  float t = max(-d.z, 0.0);
+  d.xy += mix(vec2(t), vec2(-t), greaterThanEqual(d.xy, vec2(0.0)));
+  return normalize(d);
+}
+
 layout(location = 0) out vec3 vertex_position;
 layout(location = 1) out vec3 vertex_normal;
 layout(location = 2) out vec2 vertex_texcoord;
 layout(location = 3) out vec3 vertex_color;
+layout(location = 4) flat out uint vertex_material;
 
 void main()
 {
@@ -34,13 +66,13 @@ void main()
   
   entity_info info = entity_infos[gl_InstanceIndex];
 
-  mat4 transform = info.transform;
-  mat4 inverse_transform = info.inverse_transform;
+  mat4 transform = entity_transform(info);
 
-  vertex_normal = (transpose(inverse_transform) * vec4(normal, 0)).xyz;
+  vertex_normal = normal_matrix(mat3(transform)) * decode_normal(normal);
   vertex_color = vec3(0.1, 0.6, 0.0);
   vec4 pos = transform * vec4(position.xyz, 1);
   vertex_position = pos.xyz;
   vertex_texcoord = texcoord;
-  gl_Position = camera.proj_matrix * camera.view_matrix * pos;
+  vertex_material = info.material_index;
+  gl_Position = camera.view_projections[gl_ViewIndex] * pos;
 }
\ No newline at end of file
@@ -18,7 +18,7 @@ namespace gev::game
     vk::PushConstantRange options_range;
     options_range.offset = 0;
     options_range.stageFlags = vk::ShaderStageFlagBits::eCompute;
-    options_range.size = sizeof(blur_dir) + sizeof(float);
+    options_range.size = sizeof(blur_dir) + 2 * sizeof(float);
     _layout = gev::create_pipeline_layout(_set_layout.get(), options_range);
 
     struct spec_info_struct
@@ -51,8 +51,8 @@ namespace gev::game
         .setMaxLod(1000));
   }
 
-  void blur::apply(
-    vk::CommandBuffer c, blur_dir dir, float step_size, render_target_2d const& src, render_target_2d const& dst)
+  void blur::apply(vk::CommandBuffer c, blur_dir dir, float step_size, render_target_2d const& src,
+    render_target_2d const& dst, float layer_falloff)
   {
     src.image()->layout(c, vk::ImageLayout::eShaderReadOnlyOptimal, vk::PipelineStageFlagBits2::eComputeShader,
       vk::AccessFlagBits2::eShaderSampledRead);
@@ -64,13 +64,16 @@ namespace gev::game
     {
       blur_dir dir;
       float size;
-    } options{dir, step_size};
+      float layer_falloff;
+    } options{dir, step_size, layer_falloff};
     c.pushConstants<decltype(options)>(_layout.get(), vk::ShaderStageFlagBits::eCompute, 0, options);
 
     vk::DescriptorImageInfo img0;
-    img0.setImageLayout(vk::ImageLayout::eShaderReadOnlyOptimal).setImageView(src.view()).setSampler(_sampler.get());
+    img0.setImageLayout(vk::ImageLayout::eShaderReadOnlyOptimal)
+      .setImageView(src.array_view())
+      .setSampler(_sampler.get());
     vk::DescriptorImageInfo img1;
-    img1.setImageLayout(vk::ImageLayout::eGeneral).setImageView(dst.view());
+    img1.setImageLayout(vk::ImageLayout::eGeneral).setImageView(dst.array_view());
 
     vk::WriteDescriptorSet const set0 =
       vk::WriteDescriptorSet()
@@ -85,6 +88,7 @@ namespace gev::game
         .setDescriptorType(vk::DescriptorType::eStorageImage)
         .setImageInfo(img1);
     c.pushDescriptorSetKHR(vk::PipelineBindPoint::eCompute, _layout.get(), 0, {set0, set1});
-    c.dispatch((src.image()->extent().width + 7) / 8, (src.image()->extent().height + 7) / 8, 1);
+    c.dispatch(
+      (src.image()->extent().width + 7) / 8, (src.image()->extent().height + 7) / 8, src.image()->array_layers());
   }
 }    // namespace gev::game
\ No newline at end of file
@@ -1,3 +1,5 @@
+#include <algorithm>
+#include <atomic>
 #include <gev/game/camera.hpp>
 #include <gev/game/layouts.hpp>
 
@@ -43,16 +45,24 @@ namespace gev::game
     }
   }
 
+  static std::atomic<std::uint64_t> next_camera_id = 0;
+
   camera::camera()
+    : _id(next_camera_id++)
   {
     _per_frame.descriptor =
       gev::engine::get().get_descriptor_allocator().allocate(layouts::defaults().camera_set_layout());
     _per_frame.uniform_buffer = std::make_unique<gev::game::sync_buffer>(
-      sizeof(per_frame_info::matrices), vk::BufferUsageFlagBits::eUniformBuffer, 3);
+      sizeof(per_frame_info::matrices), vk::BufferUsageFlagBits::eUniformBuffer);
     gev::update_descriptor(
       _per_frame.descriptor, 0, _per_frame.uniform_buffer->buffer(), vk::DescriptorType::eUniformBuffer);
   }
 
+  std::uint64_t camera::id() const
+  {
+    return _id;
+  }
+
   void camera::set_transform(rnu::mat4 transform)
   {
     set_view(inverse(transform));
@@ -63,6 +73,7 @@ namespace gev::game
     _view_matrix = view_matrix;
     _per_frame.mat.view_matrix = _view_matrix;
     _per_frame.mat.inverse_view_matrix = inverse(_view_matrix);
+    update_views();
     _per_frame.uniform_buffer->load_data<per_frame_info::matrices>(_per_frame.mat);
   }
 
@@ -72,9 +83,36 @@ namespace gev::game
     _proj_matrix = rnu::projection_matrix(_proj);
     _per_frame.mat.proj_matrix = _proj_matrix;
     _per_frame.mat.inverse_proj_matrix = inverse(_proj_matrix);
+    update_views();
+    _per_frame.uniform_buffer->load_data<per_frame_info::matrices>(_per_frame.mat);
+  }
+
+  void camera::set_views(std::span<rnu::mat4 const> view_projections)
+  {
+    _custom_views = !view_projections.empty();
+    if (_custom_views)
+    {
+      _per_frame.mat.num_views = std::uint32_t(std::min<std::size_t>(view_projections.size(), max_views));
+      std::copy_n(view_projections.begin(), _per_frame.mat.num_views, _per_frame.mat.view_projections);
+    }
+    update_views();
     _per_frame.uniform_buffer->load_data<per_frame_info::matrices>(_per_frame.mat);
   }
 
+  std::uint32_t camera::num_views() const
+  {
+    return _per_frame.mat.num_views;
+  }
+
+  void camera::update_views()
+  {
+    if (_custom_views)
+      return;
+
+    _per_frame.mat.num_views = 1;
+    _per_frame.mat.view_projections[0] = _proj_matrix * _view_matrix;
+  }
+
   rnu::mat4 camera::view() const
   {
     return _view_matrix;
@@ -100,6 +138,11 @@ namespace gev::game
     return _per_frame.descriptor;
   }
 
+  gev::buffer const& camera::uniform_buffer() const
+  {
+    return _per_frame.uniform_buffer->buffer();
+  }
+
   void camera::bind(vk::CommandBuffer c, vk::PipelineLayout layout, std::uint32_t binding)
   {
     c.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, layout, binding, descriptor(), {});
@@ -1,5 +1,7 @@
+#include <array>
 #include <gev/game/cascaded_shadow_mapping.hpp>
 #include <gev/game/formats.hpp>
+#include <gev/gpu_profiler.hpp>
 
 namespace gev::game
 {
@@ -83,37 +85,36 @@ namespace gev::game
     dst.set_projection(gev::game::ortho(e_min.x, e_max.x, e_min.y, e_max.y, 0.0f, maxZ - minZ));
   }
 
-  cascaded_shadow_mapping::cascaded_shadow_mapping(vk::Extent2D size, std::size_t num_cascades, float split_lambda)
+  cascaded_shadow_mapping::cascaded_shadow_mapping(vk::Extent2D size, float split_lambda)
     : _size(size), _split_lambda(split_lambda)
   {
-    _cascades.resize(num_cascades);
-
-    for (std::size_t i = 0; i < num_cascades; ++i)
-    {
-      auto& c = _cascades[i];
+    static_assert(num_shadow_views <= camera::max_views);
 
+    _cascades.resize(num_shadow_views);
+    for (auto& c : _cascades)
       c.camera = std::make_shared<gev::game::camera>();
-      c.renderer = std::make_shared<gev::game::renderer>(_size, vk::SampleCountFlagBits::e1);
-      c.renderer->set_color_format(gev::game::formats::shadow_pass);
-      c.renderer->add_color_usage(vk::ImageUsageFlagBits::eStorage);
-      c.renderer->set_clear_color({1.0f, 1.0f, 0.0f, 0.0f});
-    }
+
+    _camera = std::make_shared<gev::game::camera>();
+    _renderer = std::make_shared<gev::game::renderer>(_size, vk::SampleCountFlagBits::e1);
+    _renderer->set_layers(num_shadow_views);
+    _renderer->set_color_format(gev::game::formats::shadow_pass);
+    _renderer->add_color_usage(vk::ImageUsageFlagBits::eStorage);
+    _renderer->set_clear_color({1.0f, 1.0f, 0.0f, 0.0f});
 
     _blur_tmp = std::make_unique<render_target_2d>(_size, formats::shadow_pass,
-      vk::ImageUsageFlagBits::eStorage | vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eTransferSrc);
+      vk::ImageUsageFlagBits::eStorage | vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eTransferSrc,
+      vk::SampleCountFlagBits::e1, num_shadow_views);
     _blur = std::make_unique<blur>();
   }
 
   void cascaded_shadow_mapping::enable(shadow_map_holder& src)
   {
-    for (auto& c : _cascades)
+    auto const& img = _renderer->color_target().image();
+    for (std::uint32_t i = 0; i < _cascades.size(); ++i)
     {
+      auto& c = _cascades[i];
       if (!c.instance)
-      {
-        auto const& img = c.renderer->color_target().image();
-        auto view = c.renderer->color_target().view();
-        c.instance = src.instantiate(img, c.camera->projection_matrix() * c.camera->view());
-      }
+        c.instance = src.instantiate(img, c.camera->projection_matrix() * c.camera->view(), i);
     }
 
     _cascades[0].instance->make_csm_root(_cascades.size());
@@ -158,37 +159,40 @@ namespace gev::game
     }
 
     float last_split = 0.0;
-    for (auto const& c : _cascades)
+    std::array<rnu::mat4, num_shadow_views> view_projections;
+    for (std::size_t i = 0; i < _cascades.size(); ++i)
     {
+      auto const& c = _cascades[i];
       auto const this_split = c.split;
       apply_cascade(*c.camera, main_camera.view(), main_camera.projection_matrix(), direction, last_split, this_split);
-      c.camera->sync(cmd);
+      view_projections[i] = c.camera->projection_matrix() * c.camera->view();
       auto const split_depth = (nearClip + last_split * clipRange) * -1.0f;
       c.instance->set_cascade_split(split_depth);
-      c.instance->update_transform(c.camera->projection_matrix() * c.camera->view());
+      c.instance->update_transform(view_projections[i]);
       last_split = this_split;
     }
-    r.sync(cmd);
-    gev::engine::get().device().waitIdle();
 
-    int num = 0;
-    for (auto const& c : _cascades)
-    {
-      auto& src = c.renderer->color_target();
+    // One camera carries the matrices of all cascades, the vertex shader picks one per multiview view.
+    _camera->set_view(_cascades[0].camera->view());
+    _camera->set_projection(_cascades[0].camera->projection());
+    _camera->set_views(view_projections);
+    _camera->sync(cmd);
 
-      c.renderer->prepare_frame(cmd);
-      c.renderer->begin_render(cmd);
-      r.render(
-        cmd, *c.camera, 0, 0, _size.width, _size.height, gev::game::pass_id::shadow, vk::SampleCountFlagBits::e1);
-      c.renderer->end_render(cmd);
+    r.cull(cmd, *_camera);
 
-      _blur->apply(cmd, gev::game::blur_dir::horizontal, 1.4f / (num + 1), src, *_blur_tmp);
-      _blur->apply(cmd, gev::game::blur_dir::vertical, 1.4f / (num + 1), *_blur_tmp, src);
+    auto const scope = profile_gpu(cmd, "CSM");
+    auto& src = _renderer->color_target();
 
-      src.image()->layout(cmd, vk::ImageLayout::eShaderReadOnlyOptimal, vk::PipelineStageFlagBits2::eFragmentShader,
-        vk::AccessFlagBits2::eShaderSampledRead);
+    _renderer->prepare_frame(cmd);
+    _renderer->begin_render(cmd);
+    r.render(
+      cmd, *_camera, 0, 0, _size.width, _size.height, gev::game::pass_id::shadow, vk::SampleCountFlagBits::e1);
+    _renderer->end_render(cmd);
 
-      ++num;
-    }
+    _blur->apply(cmd, gev::game::blur_dir::horizontal, 1.4f, src, *_blur_tmp, 1.0f);
+    _blur->apply(cmd, gev::game::blur_dir::vertical, 1.4f, *_blur_tmp, src, 1.0f);
+
+    src.image()->layout(cmd, vk::ImageLayout::eShaderReadOnlyOptimal, vk::PipelineStageFlagBits2::eFragmentShader,
+      vk::AccessFlagBits2::eShaderSampledRead);
   }
 }    // namespace gev::game
\ No newline at end of file
@@ -1,6 +1,7 @@
 #include <gev/game/distance_field_generator.hpp>
 #include <gev/pipeline.hpp>
 #include <gev_game_shaders_files.hpp>
+#include <stdexcept>
 
 namespace gev::game
 {
@@ -55,6 +56,9 @@ namespace gev::game
 
   void distance_field_generator::generate(distance_field& into, mesh const& obj)
   {
+    if (obj.format() != vertex_format::standard)
+      throw std::runtime_error("Distance fields can only be generated from meshes with the standard vertex format.");
+
     auto const result_view = into.image()->create_view(vk::ImageViewType::e3D);
 
     gev::update_descriptor(_descriptor, 1,
@@ -63,14 +67,14 @@ namespace gev::game
     gev::update_descriptor(_descriptor, 2,
       vk::DescriptorBufferInfo()
         .setBuffer(obj.vertex_buffer().get_buffer())
-        .setOffset(0)
-        .setRange(obj.vertex_buffer().size()),
+        .setOffset(obj.range().first_vertex * sizeof(rnu::vec4))
+        .setRange(obj.range().vertex_count * sizeof(rnu::vec4)),
       vk::DescriptorType::eStorageBuffer);
     gev::update_descriptor(_descriptor, 3,
       vk::DescriptorBufferInfo()
         .setBuffer(obj.index_buffer().get_buffer())
-        .setOffset(0)
-        .setRange(obj.index_buffer().size()),
+        .setOffset(obj.range().first_index * sizeof(std::uint32_t))
+        .setRange(obj.range().index_count * sizeof(std::uint32_t)),
       vk::DescriptorType::eStorageBuffer);
 
     gev::engine::get().execute_once([&](auto c) { generate(c, into, result_view.get(), obj); },
@@ -96,7 +100,8 @@ namespace gev::game
         .setDstAccessMask(vk::AccessFlagBits2::eShaderStorageRead)
         .setDstStageMask(vk::PipelineStageFlagBits2::eComputeShader)
         .setDstQueueFamilyIndex(gev::engine::get().queues().compute_family)
-        .setSize(obj.vertex_buffer().size())
+        .setOffset(obj.range().first_vertex * sizeof(rnu::vec4))
+        .setSize(obj.range().vertex_count * sizeof(rnu::vec4))
         .setSrcStageMask(vk::PipelineStageFlagBits2::eAllCommands)
         .setSrcAccessMask({})
         .setSrcQueueFamilyIndex(VK_QUEUE_FAMILY_EXTERNAL);
@@ -106,7 +111,8 @@ namespace gev::game
         .setDstAccessMask(vk::AccessFlagBits2::eShaderStorageRead)
         .setDstStageMask(vk::PipelineStageFlagBits2::eComputeShader)
         .setDstQueueFamilyIndex(gev::engine::get().queues().compute_family)
-        .setSize(obj.index_buffer().size())
+        .setOffset(obj.range().first_index * sizeof(std::uint32_t))
+        .setSize(obj.range().index_count * sizeof(std::uint32_t))
         .setSrcStageMask(vk::PipelineStageFlagBits2::eAllCommands)
         .setSrcAccessMask({})
         .setSrcQueueFamilyIndex(VK_QUEUE_FAMILY_EXTERNAL);
@@ -129,7 +135,8 @@ namespace gev::game
         .setSrcAccessMask(vk::AccessFlagBits2::eShaderStorageRead)
         .setSrcStageMask(vk::PipelineStageFlagBits2::eComputeShader)
         .setSrcQueueFamilyIndex(gev::engine::get().queues().compute_family)
-        .setSize(obj.vertex_buffer().size())
+        .setOffset(obj.range().first_vertex * sizeof(rnu::vec4))
+        .setSize(obj.range().vertex_count * sizeof(rnu::vec4))
         .setDstStageMask(vk::PipelineStageFlagBits2::eVertexAttributeInput)
         .setDstAccessMask(vk::AccessFlagBits2::eVertexAttributeRead)
         .setDstQueueFamilyIndex(gev::engine::get().queues().graphics_family);
@@ -139,7 +146,8 @@ namespace gev::game
         .setSrcAccessMask(vk::AccessFlagBits2::eShaderStorageRead)
         .setSrcStageMask(vk::PipelineStageFlagBits2::eComputeShader)
         .setSrcQueueFamilyIndex(gev::engine::get().queues().compute_family)
-        .setSize(obj.index_buffer().size())
+        .setOffset(obj.range().first_index * sizeof(std::uint32_t))
+        .setSize(obj.range().index_count * sizeof(std::uint32_t))
         .setDstStageMask(vk::PipelineStageFlagBits2::eVertexAttributeInput)
         .setDstAccessMask(vk::AccessFlagBits2::eVertexAttributeRead)
         .setDstQueueFamilyIndex(gev::engine::get().queues().graphics_family);
@@ -7,24 +7,26 @@ namespace gev::game
   void distance_field_instance::update_transform(rnu::mat4 const& transform)
   {
     if (!_holder.expired())
-      _holder.lock()->update_transform_internal(_byte_offset, transform);
+      _holder.lock()->update_transform_internal(_index, transform);
   }
 
-  void distance_field_holder::update_transform_internal(std::size_t offset, rnu::mat4 transform)
+  void distance_field_instance::destroy()
   {
-    transform = inverse(transform);
-
-    df_info info;
-    std::byte* begin = reinterpret_cast<std::byte*>(_field_instances.data()) + offset;
-    std::memcpy(&info, begin, sizeof(df_info));
-
-    if ((transform != info.inverse_transform).any())
+    if (!_holder.expired())
     {
-      std::memcpy(begin, transform.data(), sizeof(rnu::mat4));
-      include_update_region(offset, offset + sizeof(rnu::mat4));
+      _holder.lock()->destroy(*this);
+      _holder.reset();
+      _index = 0;
     }
   }
 
+  void distance_field_holder::update_transform_internal(std::uint32_t index, rnu::mat4 transform)
+  {
+    transform = inverse(transform);
+    if ((transform != _field_instances[index].inverse_transform).any())
+      _field_instances.edit(index).inverse_transform = transform;
+  }
+
   distance_field_holder::distance_field_holder()
   {
     vk::DescriptorPoolSize sizes[] = {
@@ -42,10 +44,6 @@ namespace gev::game
         .build();
     _field_descriptor = std::move(gev::engine::get().device().allocateDescriptorSetsUnique(
       vk::DescriptorSetAllocateInfo().setDescriptorPool(*_field_pool).setSetLayouts(*_field_layout))[0]);
-
-    _field_instances.push_back({.field_id = -1});
-    _update_region_start = 0;
-    _update_region_end = sizeof(df_info);
   }
 
   field_id distance_field_holder::register_field(std::shared_ptr<distance_field> field)
@@ -75,61 +73,29 @@ namespace gev::game
     auto const id = std::size_t(field);
     auto const& f = _fields[id];
 
-    auto& info = _field_instances[_field_instances.size() - 1];
-    info.inverse_transform = inverse(transform);
-    info.bmin = f->bounds().lower();
-    info.field_id = id;
-    info.bmax = f->bounds().upper();
-    info.metadata = 0;
-    _field_instances.push_back({.field_id = -1});
-
-    auto const begin = (_field_instances.size() - 2) * sizeof(df_info);
-    include_update_region(begin, _field_instances.size() * sizeof(df_info));
-
     auto instance = std::make_shared<distance_field_instance>();
-    instance->_byte_offset = begin;
+    instance->_index = _field_instances.allocate(df_info{
+      .inverse_transform = inverse(transform),
+      .bmin = f->bounds().lower(),
+      .field_id = int(id),
+      .bmax = f->bounds().upper(),
+      .metadata = 0,
+    });
     instance->_holder = shared_from_this();
     return instance;
   }
 
-  void distance_field_holder::include_update_region(std::size_t begin, std::size_t end)
+  void distance_field_holder::destroy(distance_field_instance const& instance)
   {
-    _update_region_start = std::min(_update_region_start, begin);
-    _update_region_end = std::max(_update_region_end, end);
+    _field_instances.free(instance._index, df_info{.field_id = -1});
   }
 
-  void distance_field_holder::try_flush_buffer()
+  void distance_field_holder::sync(vk::CommandBuffer c)
   {
-    if (_instances_buffer && _update_region_end <= _update_region_start)
-      return;
-
-    if (!_instances_buffer || _update_region_end > _instances_buffer->size())
+    if (_field_instances.sync(c))
     {
-      auto v = std::max(min_reserved_elements * sizeof(df_info), _update_region_end);
-      v--;
-      v |= v >> 1;
-      v |= v >> 2;
-      v |= v >> 4;
-      v |= v >> 8;
-      v |= v >> 16;
-      v |= v >> 32;
-      v++;
-
-      _instances_buffer.reset();
-
-      _instances_buffer = gev::buffer::host_accessible(v, vk::BufferUsageFlagBits::eStorageBuffer);
-      gev::update_descriptor(_field_descriptor.get(), binding_instances,
-        vk::DescriptorBufferInfo().setBuffer(_instances_buffer->get_buffer()).setOffset(0).setRange(v),
+      gev::update_descriptor(_field_descriptor.get(), binding_instances, _field_instances.buffer(),
         vk::DescriptorType::eStorageBuffer);
     }
-
-    if (_update_region_end > _update_region_start)
-    {
-      std::byte const* begin = reinterpret_cast<std::byte const*>(_field_instances.data()) + _update_region_start;
-      _instances_buffer->load_data(begin, _update_region_end - _update_region_start, _update_region_start);
-    }
-
-    _update_region_start = std::numeric_limits<std::size_t>::max();
-    _update_region_end = std::numeric_limits<std::size_t>::lowest();
   }
 }    // namespace gev::game
\ No newline at end of file
@@ -0,0 +1,88 @@
+#include <array>
+#include <gev/descriptors.hpp>
+#include <gev/engine.hpp>
+#include <gev/game/frustum_culler.hpp>
+#include <gev/pipeline.hpp>
+#include <gev_game_shaders_files.hpp>
+
+namespace gev::game
+{
+  frustum_culler::frustum_culler()
+  {
+    _set_layout = gev::descriptor_layout_creator::get()
+                    .flags(vk::DescriptorSetLayoutCreateFlagBits::ePushDescriptorKHR)
+                    .bind(0, vk::DescriptorType::eStorageBuffer, vk::ShaderStageFlagBits::eCompute)
+                    .bind(1, vk::DescriptorType::eStorageBuffer, vk::ShaderStageFlagBits::eCompute)
+                    .bind(2, vk::DescriptorType::eStorageBuffer, vk::ShaderStageFlagBits::eCompute)
+                    .bind(3, vk::DescriptorType::eStorageBuffer, vk::ShaderStageFlagBits::eCompute)
+                    .bind(4, vk::DescriptorType::eUniformBuffer, vk::ShaderStageFlagBits::eCompute)
+                    .bind(5, vk::DescriptorType::eStorageBuffer, vk::ShaderStageFlagBits::eCompute)
+                    .build();
+
+    vk::PushConstantRange options_range;
+    options_range.offset = 0;
+    options_range.stageFlags = vk::ShaderStageFlagBits::eCompute;
+    options_range.size = sizeof(std::uint32_t);
+    _layout = gev::create_pipeline_layout(_set_layout.get(), options_range);
+
+    auto const shader = gev::create_shader(gev::load_spv(gev_game_shaders::shaders::cull_comp));
+    _pipeline = gev::build_compute_pipeline(_layout.get(), shader.get());
+
+    _compact_set_layout = gev::descriptor_layout_creator::get()
+                            .flags(vk::DescriptorSetLayoutCreateFlagBits::ePushDescriptorKHR)
+                            .bind(0, vk::DescriptorType::eStorageBuffer, vk::ShaderStageFlagBits::eCompute)
+                            .bind(1, vk::DescriptorType::eStorageBuffer, vk::ShaderStageFlagBits::eCompute)
+                            .bind(2, vk::DescriptorType::eStorageBuffer, vk::ShaderStageFlagBits::eCompute)
+                            .build();
+    _compact_layout = gev::create_pipeline_layout(_compact_set_layout.get(), options_range);
+
+    auto const compact_shader = gev::create_shader(gev::load_spv(gev_game_shaders::shaders::compact_draws_comp));
+    _compact_pipeline = gev::build_compute_pipeline(_compact_layout.get(), compact_shader.get());
+  }
+
+  void frustum_culler::dispatch(vk::CommandBuffer c, gev::buffer const& camera, std::uint32_t num_records,
+    gev::buffer const& instances, gev::buffer const& records, gev::buffer const& commands,
+    gev::buffer const& count, gev::buffer const& visible_instances) const
+  {
+    c.bindPipeline(vk::PipelineBindPoint::eCompute, _pipeline.get());
+    c.pushConstants<std::uint32_t>(_layout.get(), vk::ShaderStageFlagBits::eCompute, 0, num_records);
+
+    vk::DescriptorBufferInfo const infos[] = {
+      vk::DescriptorBufferInfo(instances.get_buffer(), 0, VK_WHOLE_SIZE),
+      vk::DescriptorBufferInfo(records.get_buffer(), 0, VK_WHOLE_SIZE),
+      vk::DescriptorBufferInfo(commands.get_buffer(), 0, VK_WHOLE_SIZE),
+      vk::DescriptorBufferInfo(count.get_buffer(), 0, VK_WHOLE_SIZE),
+      vk::DescriptorBufferInfo(camera.get_buffer(), 0, VK_WHOLE_SIZE),
+      vk::DescriptorBufferInfo(visible_instances.get_buffer(), 0, VK_WHOLE_SIZE),
+    };
+    std::array<vk::WriteDescriptorSet, std::size(infos)> writes;
+    for (std::uint32_t i = 0; i < writes.size(); ++i)
+    {
+      auto const type = i == 4 ? vk::DescriptorType::eUniformBuffer : vk::DescriptorType::eStorageBuffer;
+      writes[i] = vk::WriteDescriptorSet().setDstBinding(i).setDescriptorType(type).setBufferInfo(infos[i]);
+    }
+    c.pushDescriptorSetKHR(vk::PipelineBindPoint::eCompute, _layout.get(), 0, writes);
+    c.dispatch((num_records + group_size - 1) / group_size, 1, 1);
+  }
+
+  void frustum_culler::compact(vk::CommandBuffer c, std::uint32_t num_commands, gev::buffer const& commands,
+    gev::buffer const& draws, gev::buffer const& draw_count) const
+  {
+    c.bindPipeline(vk::PipelineBindPoint::eCompute, _compact_pipeline.get());
+    c.pushConstants<std::uint32_t>(_compact_layout.get(), vk::ShaderStageFlagBits::eCompute, 0, num_commands);
+
+    vk::DescriptorBufferInfo const infos[] = {
+      vk::DescriptorBufferInfo(commands.get_buffer(), 0, VK_WHOLE_SIZE),
+      vk::DescriptorBufferInfo(draws.get_buffer(), 0, VK_WHOLE_SIZE),
+      vk::DescriptorBufferInfo(draw_count.get_buffer(), 0, VK_WHOLE_SIZE),
+    };
+    std::array<vk::WriteDescriptorSet, std::size(infos)> writes;
+    for (std::uint32_t i = 0; i < writes.size(); ++i)
+    {
+      writes[i] = vk::WriteDescriptorSet().setDstBinding(i).setDescriptorType(vk::DescriptorType::eStorageBuffer);
+      writes[i].setBufferInfo(infos[i]);
+    }
+    c.pushDescriptorSetKHR(vk::PipelineBindPoint::eCompute, _compact_layout.get(), 0, writes);
+    c.dispatch((num_commands + group_size - 1) / group_size, 1, 1);
+  }
+}    // namespace gev::game
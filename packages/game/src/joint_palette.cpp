@@ -0,0 +1,85 @@
+#include <gev/descriptors.hpp>
+#include <gev/engine.hpp>
+#include <gev/game/joint_palette.hpp>
+#include <gev/game/layouts.hpp>
+#include <stdexcept>
+
+namespace gev::game
+{
+  static std::uint32_t aligned_region_size(std::uint32_t max_joints)
+  {
+    auto const alignment =
+      std::uint32_t(gev::engine::get().physical_device().getProperties().limits.minStorageBufferOffsetAlignment);
+    auto const size = max_joints * std::uint32_t(sizeof(rnu::mat4));
+    return (size + alignment - 1) / alignment * alignment;
+  }
+
+  joint_palette::joint_palette(std::uint32_t max_joints)
+    : _num_frames(gev::engine::get().num_images()),
+      _region_size(aligned_region_size(max_joints)),
+      _joints(max_joints, 1)
+  {
+    _buffer = gev::buffer::host_local(_num_frames * _region_size, vk::BufferUsageFlagBits::eStorageBuffer);
+    _descriptor =
+      gev::engine::get().get_descriptor_allocator().allocate(layouts::defaults().skinning_set_layout());
+    gev::update_descriptor(_descriptor, 0, vk::DescriptorBufferInfo(_buffer->get_buffer(), 0, _region_size),
+      vk::DescriptorType::eStorageBufferDynamic);
+  }
+
+  std::uint32_t joint_palette::allocate(std::span<rnu::mat4 const> joints)
+  {
+    auto const frame = gev::current_frame().frame_number;
+    std::erase_if(_retired,
+      [&](retired_range const& r)
+      {
+        if (r.reuse_frame > frame)
+          return false;
+        _joints.free(r.offset, r.count);
+        return true;
+      });
+
+    auto const offset = _joints.allocate(std::uint32_t(joints.size()));
+    if (!offset)
+      throw std::runtime_error("Joint palette is out of space.");
+
+    // Owners only write the region of the current frame, the following frames would otherwise read garbage first.
+    for (std::uint32_t i = 0; i < _num_frames; ++i)
+    {
+      _buffer->load_data(joints.data(), std::uint32_t(joints.size_bytes()),
+        i * _region_size + *offset * std::uint32_t(sizeof(rnu::mat4)));
+    }
+    return *offset;
+  }
+
+  void joint_palette::free(std::uint32_t offset, std::uint32_t count)
+  {
+    // Frames in flight may still read the range.
+    _retired.push_back(retired_range{offset, count, gev::current_frame().frame_number + _num_frames});
+  }
+
+  void joint_palette::write(std::uint32_t offset, std::span<rnu::mat4 const> joints)
+  {
+    _buffer->load_data(joints.data(), std::uint32_t(joints.size_bytes()),
+      frame_offset() + offset * std::uint32_t(sizeof(rnu::mat4)));
+  }
+
+  vk::DescriptorSet joint_palette::descriptor() const
+  {
+    return _descriptor;
+  }
+
+  gev::buffer const& joint_palette::buffer() const
+  {
+    return *_buffer;
+  }
+
+  std::uint32_t joint_palette::frame_offset() const
+  {
+    return (gev::current_frame().frame_index % _num_frames) * _region_size;
+  }
+
+  std::uint32_t joint_palette::region_size() const
+  {
+    return _region_size;
+  }
+}    // namespace gev::game
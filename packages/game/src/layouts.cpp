@@ -1,6 +1,7 @@
 #include <gev/descriptors.hpp>
 #include <gev/engine.hpp>
 #include <gev/game/layouts.hpp>
+#include <gev/game/material_table.hpp>
 #include <gev/game/shadow_map_holder.hpp>
 
 namespace gev::game
@@ -18,11 +19,13 @@ namespace gev::game
                            .build();
     _material_set_layout =
       gev::descriptor_layout_creator::get()
-        .bind(0, vk::DescriptorType::eCombinedImageSampler, 1, vk::ShaderStageFlagBits::eAllGraphics,
-          vk::DescriptorBindingFlagBits::ePartiallyBound)
-        .bind(1, vk::DescriptorType::eCombinedImageSampler, 1, vk::ShaderStageFlagBits::eAllGraphics,
-          vk::DescriptorBindingFlagBits::ePartiallyBound)
-        .bind(2, vk::DescriptorType::eStorageBuffer, 1, vk::ShaderStageFlagBits::eAllGraphics)
+        .flags(vk::DescriptorSetLayoutCreateFlagBits::eUpdateAfterBindPool)
+        .bind(material_table::binding_materials, vk::DescriptorType::eStorageBuffer, 1,
+          vk::ShaderStageFlagBits::eAllGraphics)
+        .bind(material_table::binding_textures, vk::DescriptorType::eCombinedImageSampler,
+          material_table::max_num_textures, vk::ShaderStageFlagBits::eAllGraphics,
+          vk::DescriptorBindingFlagBits::ePartiallyBound | vk::DescriptorBindingFlagBits::eUpdateAfterBind |
+            vk::DescriptorBindingFlagBits::eUpdateUnusedWhilePending)
         .build();
     _object_set_layout = gev::descriptor_layout_creator::get()
                            .bind(0, vk::DescriptorType::eStorageBuffer, 1, vk::ShaderStageFlagBits::eAllGraphics)
@@ -37,7 +40,7 @@ namespace gev::game
         .build();
     _skinning_set_layout =
       gev::descriptor_layout_creator::get()
-        .bind(0, vk::DescriptorType::eStorageBuffer, 1, vk::ShaderStageFlagBits::eAllGraphics)
+        .bind(0, vk::DescriptorType::eStorageBufferDynamic, 1, vk::ShaderStageFlagBits::eAllGraphics)
         .build();
 
     _environment_set_layout =
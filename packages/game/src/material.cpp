@@ -4,71 +4,109 @@
 
 namespace gev::game
 {
+  material::~material()
+  {
+    if (auto const table = _table.lock())
+    {
+      release_textures(*table);
+      table->free_material(_index);
+    }
+  }
+
   void material::load_diffuse(std::shared_ptr<texture> dt)
   {
     _diffuse = std::move(dt);
-    if (_texture_descriptor)
-      bind_or_unbind(_diffuse, 0, material_info::has_diffuse);
+    if (_diffuse)
+      _data.flags |= material_info::has_diffuse;
+    else
+      _data.flags &= ~material_info::has_diffuse;
+    update_table(true);
   }
 
   void material::load_roughness(std::shared_ptr<texture> rt)
   {
     _roughness = std::move(rt);
-    if (_texture_descriptor)
-      bind_or_unbind(_roughness, 1, material_info::has_roughness);
+    if (_roughness)
+      _data.flags |= material_info::has_roughness;
+    else
+      _data.flags &= ~material_info::has_roughness;
+    update_table(true);
   }
 
   void material::set_diffuse(rnu::vec4 color)
   {
     _data.diffuse = rnu::vec4ui8(rnu::clamp(color, 0.0, 1.0) * 255);
-    _update_buffer = true;
+    update_table(false);
   }
 
   void material::set_roughness(float r)
   {
     _data.roughness = std::clamp(r, 0.f, 1.f);
-    _update_buffer = true;
+    update_table(false);
   }
 
   void material::set_two_sided(bool enable)
   {
+    if (_two_sided == enable)
+      return;
+
+    // Batches are split by cull mode, instances created with the old mode have to move.
     _two_sided = enable;
+    if (!_table.expired())
+      gev::service<mesh_renderer>()->set_two_sided(_index, enable);
   }
 
-  void material::bind_or_unbind(std::shared_ptr<texture> const& t, std::uint32_t binding, std::uint32_t flags)
+  bool material::two_sided() const
   {
-    if (t)
-    {
-      t->bind(_texture_descriptor, binding);
-      _data.flags |= flags;
-    }
-    else
+    return _two_sided;
+  }
+
+  std::uint32_t material::index()
+  {
+    if (_table.expired())
     {
-      _data.flags &= ~flags;
+      auto const table = gev::service<mesh_renderer>()->materials();
+      _table = table;
+      _index = table->allocate_material();
+      _diffuse_slot = no_texture;
+      _roughness_slot = no_texture;
+      update_table(true);
     }
-    _update_buffer = true;
+    return _index;
   }
 
-  void material::bind(vk::CommandBuffer c, vk::PipelineLayout layout, std::uint32_t binding)
+  void material::release_textures(material_table& table)
   {
-    if (!_texture_descriptor)
-    {
-      _texture_descriptor =
-        gev::engine::get().get_descriptor_allocator().allocate(layouts::defaults().material_set_layout());
-      bind_or_unbind(_diffuse, 0, material_info::has_diffuse);
-      bind_or_unbind(_roughness, 1, material_info::has_roughness);
+    if (_diffuse_slot != no_texture)
+      table.release_texture(std::exchange(_diffuse_slot, no_texture));
+    if (_roughness_slot != no_texture)
+      table.release_texture(std::exchange(_roughness_slot, no_texture));
+  }
 
-      _data_buffer = gev::buffer::host_accessible(sizeof(_data), vk::BufferUsageFlagBits::eStorageBuffer);
+  void material::update_table(bool textures_changed)
+  {
+    auto const table = _table.lock();
+    if (!table)
+      return;
 
-      gev::update_descriptor(_texture_descriptor, 2, *_data_buffer, vk::DescriptorType::eStorageBuffer);
-      _update_buffer = true;
+    if (textures_changed)
+    {
+      release_textures(*table);
+      if (_diffuse)
+        _diffuse_slot = table->acquire_texture(_diffuse);
+      if (_roughness)
+        _roughness_slot = table->acquire_texture(_roughness);
     }
 
-    if (_update_buffer)
-      _data_buffer->load_data<material_info>(_data);
-
-    c.setCullMode(_two_sided ? vk::CullModeFlagBits::eNone : vk::CullModeFlagBits::eBack);
-    c.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, layout, binding, _texture_descriptor, nullptr);
+    table->update_material(_index,
+      gpu_material{
+        .diffuse = _data.diffuse,
+        .roughness = _data.roughness,
+        .metadata = _data.metadata,
+        .flags = _data.flags,
+        .diffuse_texture = _diffuse_slot == no_texture ? 0 : _diffuse_slot,
+        .roughness_texture = _roughness_slot == no_texture ? 0 : _roughness_slot,
+      });
   }
 
   void material::serialize(serializer& base, std::ostream& out)
@@ -90,7 +128,9 @@ namespace gev::game
       load_roughness(as<texture>(rough));
 
     read_typed(_data, in);
-    read_typed(_two_sided, in);
-    _update_buffer = true;
+    bool two_sided = false;
+    read_typed(two_sided, in);
+    set_two_sided(two_sided);
+    update_table(false);
   }
-}    // namespace gev::game
\ No newline at end of file
+}    // namespace gev::game
@@ -0,0 +1,179 @@
+#include <algorithm>
+#include <gev/descriptors.hpp>
+#include <gev/engine.hpp>
+#include <gev/game/layouts.hpp>
+#include <gev/game/material_table.hpp>
+#include <stdexcept>
+
+namespace gev::game
+{
+  material_table::material_table()
+  {
+    auto const& e = gev::engine::get();
+    _num_frames = e.num_images();
+
+    vk::DescriptorPoolSize sizes[] = {
+      {vk::DescriptorType::eStorageBuffer, 1},
+      {vk::DescriptorType::eCombinedImageSampler, max_num_textures},
+    };
+    _pool = e.device().createDescriptorPoolUnique(
+      vk::DescriptorPoolCreateInfo().setMaxSets(1).setPoolSizes(sizes).setFlags(
+        vk::DescriptorPoolCreateFlagBits::eFreeDescriptorSet | vk::DescriptorPoolCreateFlagBits::eUpdateAfterBind));
+    auto const layout = layouts::defaults().material_set_layout();
+    _descriptor = std::move(e.device().allocateDescriptorSetsUnique(
+      vk::DescriptorSetAllocateInfo().setDescriptorPool(*_pool).setSetLayouts(layout))[0]);
+
+    _materials_buffer = std::make_unique<sync_buffer>(
+      max_num_materials * sizeof(gpu_material), vk::BufferUsageFlagBits::eStorageBuffer);
+    gev::update_descriptor(
+      _descriptor.get(), binding_materials, _materials_buffer->buffer(), vk::DescriptorType::eStorageBuffer);
+
+    // Slot 0 is the fallback material used by instances that do not reference one.
+    _materials.push_back(gpu_material{});
+  }
+
+  std::uint32_t material_table::allocate_material()
+  {
+    std::uint32_t index = 0;
+    if (!_free_materials.empty())
+    {
+      index = _free_materials.back();
+      _free_materials.pop_back();
+      _materials[index] = gpu_material{};
+    }
+    else
+    {
+      if (_materials.size() >= max_num_materials)
+        throw std::runtime_error("Too many materials.");
+      index = std::uint32_t(_materials.size());
+      _materials.push_back(gpu_material{});
+    }
+    _materials_dirty = true;
+    return index;
+  }
+
+  void material_table::free_material(std::uint32_t index)
+  {
+    if (index == 0 || index >= _materials.size())
+      return;
+    _retired_materials.push_back(retired_slot{index, _frame + _num_frames});
+  }
+
+  void material_table::update_material(std::uint32_t index, gpu_material const& data)
+  {
+    if (index >= _materials.size())
+      return;
+    _materials[index] = data;
+    _materials_dirty = true;
+  }
+
+  std::uint32_t material_table::acquire_texture(std::shared_ptr<texture> const& t)
+  {
+    if (auto const iter = _texture_slots.find(t.get()); iter != _texture_slots.end())
+    {
+      ++_textures[iter->second].references;
+      return iter->second;
+    }
+
+    std::uint32_t slot = 0;
+    if (!_free_textures.empty())
+    {
+      slot = _free_textures.back();
+      _free_textures.pop_back();
+    }
+    else
+    {
+      if (_textures.size() >= max_num_textures)
+        throw std::runtime_error("Too many material textures.");
+      slot = std::uint32_t(_textures.size());
+      _textures.emplace_back();
+    }
+
+    _textures[slot] = texture_slot{t, 1};
+    _texture_slots.emplace(t.get(), slot);
+    _pending_textures.push_back(slot);
+    _materials_dirty |= bind_uploaded_textures();
+    return slot;
+  }
+
+  void material_table::release_texture(std::uint32_t slot)
+  {
+    if (slot >= _textures.size() || _textures[slot].references == 0)
+      return;
+
+    if (--_textures[slot].references == 0)
+    {
+      _texture_slots.erase(_textures[slot].source.get());
+      _retired_textures.push_back(retired_slot{slot, _frame + _num_frames});
+    }
+  }
+
+  bool material_table::bind_uploaded_textures()
+  {
+    // Until then the image may still be in its transfer layout, so it must not be reachable from any descriptor.
+    auto bound = false;
+    std::erase_if(_pending_textures,
+      [&](std::uint32_t slot)
+      {
+        auto& t = _textures[slot];
+        if (!t.source || !t.source->is_uploaded())
+          return !t.source;
+        t.source->bind(_descriptor.get(), binding_textures, slot);
+        t.bound = true;
+        bound = true;
+        return true;
+      });
+    return bound;
+  }
+
+  gpu_material material_table::visible_material(gpu_material material) const
+  {
+    auto const bound = [&](std::uint32_t slot) { return slot < _textures.size() && _textures[slot].bound; };
+    if ((material.flags & gpu_material::has_diffuse) && !bound(material.diffuse_texture))
+      material.flags &= ~gpu_material::has_diffuse;
+    if ((material.flags & gpu_material::has_roughness) && !bound(material.roughness_texture))
+      material.flags &= ~gpu_material::has_roughness;
+    return material;
+  }
+
+  vk::DescriptorSet material_table::descriptor() const
+  {
+    return _descriptor.get();
+  }
+
+  void material_table::sync(vk::CommandBuffer c)
+  {
+    // Slots are only reused once every frame that might still reference them has retired.
+    _frame = gev::current_frame().frame_number;
+    auto const recycle = [&](std::vector<retired_slot>& retired, auto&& release)
+    {
+      std::erase_if(retired,
+        [&](retired_slot const& r)
+        {
+          if (r.reuse_frame > _frame)
+            return false;
+          release(r.index);
+          return true;
+        });
+    };
+    recycle(_retired_materials, [&](std::uint32_t i) { _free_materials.push_back(i); });
+    recycle(_retired_textures,
+      [&](std::uint32_t i)
+      {
+        _textures[i].source.reset();
+        _textures[i].bound = false;
+        _free_textures.push_back(i);
+      });
+    if (!_pending_textures.empty())
+      _materials_dirty |= bind_uploaded_textures();
+
+    if (!_materials_dirty)
+      return;
+
+    _visible_materials.resize(_materials.size());
+    std::ranges::transform(_materials, _visible_materials.begin(), [&](auto const& m) { return visible_material(m); });
+    _materials_buffer->load_data<gpu_material>(_visible_materials);
+    _materials_buffer->sync(c);
+    _materials_dirty = false;
+  }
+}    // namespace gev::game
@@ -1,11 +1,65 @@
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstring>
 #include <gev/engine.hpp>
 #include <gev/game/mesh.hpp>
+#include <gev/upload_manager.hpp>
 #include <ranges>
 #include <rnu/obj.hpp>
+#include <stdexcept>
 
 namespace gev::game
 {
-  mesh::mesh(std::filesystem::path const& path)
+  // Precedes the vertex format, older assets end after the joints and may be followed by the next object.
+  constexpr static std::size_t vertex_format_tag = ~0ull;
+
+  static std::int16_t to_snorm16(float value)
+  {
+    return std::int16_t(std::round(std::clamp(value, -1.0f, 1.0f) * 32767.0f));
+  }
+
+  static float from_snorm16(std::int16_t value)
+  {
+    return std::max(float(value) / 32767.0f, -1.0f);
+  }
+
+  static float from_half(std::uint16_t value)
+  {
+    auto const sign = std::uint32_t(value & 0x8000) << 16;
+    auto const exponent = std::uint32_t(value >> 10) & 0x1f;
+    auto const mantissa = std::uint32_t(value & 0x3ff);
+    if (exponent == 0)
+      return (sign ? -1.0f : 1.0f) * std::ldexp(float(mantissa), -24);
+    if (exponent == 0x1f)
+      return std::bit_cast<float>(sign | 0x7f800000u | (mantissa << 13));
+    return std::bit_cast<float>(sign | ((exponent + 112) << 23) | (mantissa << 13));
+  }
+
+  static rnu::vec2 octahedral_encode(rnu::vec3 n)
+  {
+    auto const l1 = std::abs(n.x) + std::abs(n.y) + std::abs(n.z);
+    if (l1 == 0.0f)
+      return rnu::vec2(0, 0);
+
+    auto const x = n.x / l1;
+    auto const y = n.y / l1;
+    if (n.z >= 0.0f)
+      return rnu::vec2(x, y);
+    return rnu::vec2(
+      (1.0f - std::abs(y)) * (x >= 0.0f ? 1.0f : -1.0f), (1.0f - std::abs(x)) * (y >= 0.0f ? 1.0f : -1.0f));
+  }
+
+  static rnu::vec3 octahedral_decode(rnu::vec2 e)
+  {
+    rnu::vec3 n(e.x, e.y, 1.0f - std::abs(e.x) - std::abs(e.y));
+    auto const t = std::max(-n.z, 0.0f);
+    n.x += n.x >= 0.0f ? -t : t;
+    n.y += n.y >= 0.0f ? -t : t;
+    return rnu::normalize(n);
+  }
+
+  mesh::mesh(std::filesystem::path const& path, vertex_format format)
   {
     auto const data = rnu::load_obj(path);
 
@@ -19,32 +73,99 @@ namespace gev::game
         for (auto const& t : rnu::triangulate(d))
           rnu::join_into(tri, t);
       }
-      init(tri);
+      init(tri, format);
     }
   }
 
-  mesh::mesh(rnu::triangulated_object_t const& tri)
+  mesh::mesh(rnu::triangulated_object_t const& tri, vertex_format format)
   {
-    init(tri);
+    init(tri, format);
   }
 
-  void mesh::load(rnu::triangulated_object_t const& tri)
+  void mesh::load(rnu::triangulated_object_t const& tri, vertex_format format)
   {
-    init(tri);
+    init(tri, format);
   }
 
-  void mesh::make_skinned(std::span<scenery::joint const> joints)
+  mesh::~mesh()
+  {
+    release();
+  }
+
+  std::shared_ptr<mesh> mesh::make_skinning_target(std::shared_ptr<mesh> source)
   {
-    _joints_buffer = gev::buffer::device_local(joints.size() * sizeof(scenery::joint),
-      vk::BufferUsageFlagBits::eTransferSrc | vk::BufferUsageFlagBits::eTransferDst |
-        vk::BufferUsageFlagBits::eVertexBuffer);
-    _joints_buffer->load_data<scenery::joint>(joints);
+    auto const arena = source->_arena.lock();
+    if (!arena || !source->is_skinned())
+      throw std::runtime_error("Only skinned meshes of an arena can have skinning targets.");
+
+    auto target = std::make_shared<mesh>();
+    target->_bounds = source->_bounds;
+    target->_arena = arena;
+    target->_range = arena->allocate(source->_range.vertex_count, 0);
+    target->_range.first_index = source->_range.first_index;
+    target->_range.index_count = source->_range.index_count;
+    target->_num_indices = source->_num_indices;
+    // Targets are initialized from the source vertices, so they cannot be drawn before those arrived.
+    target->_upload = source->_upload;
+    ++target->_version;
+    target->_index_source = std::move(source);
+    return target;
   }
 
-  void mesh::init(rnu::triangulated_object_t const& tri)
+  void mesh::release()
   {
+    if (auto const arena = _arena.lock(); arena && _num_indices != 0)
+    {
+      auto range = _range;
+      if (_index_source)
+        range.index_count = 0;
+      arena->free(range);
+    }
+    _arena.reset();
+    _range = {};
     _num_indices = 0;
-    _joints_buffer.reset();
+    _skinned = false;
+    _index_source.reset();
+  }
+
+  void mesh::make_skinned(std::span<scenery::joint const> joints)
+  {
+    auto const arena = _arena.lock();
+    if (!arena || joints.size() != _range.vertex_count)
+      return;
+    // Packed positions are relative to the mesh bounds, which the joint matrices do not account for.
+    if (_format != vertex_format::standard)
+      throw std::runtime_error("Only meshes with the standard vertex format can be skinned.");
+
+    // Weights are stored as unorm8, the rounding error goes to the largest one so that they still sum up to one.
+    std::vector<packed_joint> packed(joints.size());
+    for (std::size_t i = 0; i < joints.size(); ++i)
+    {
+      std::memcpy(packed[i].indices, &joints[i].indices, sizeof(packed[i].indices));
+      auto const* weights = joints[i].weights.data();
+      auto const sum = std::max(weights[0] + weights[1] + weights[2] + weights[3], 1e-6f);
+
+      int total = 0;
+      int largest = 0;
+      for (int w = 0; w < 4; ++w)
+      {
+        packed[i].weights[w] = std::uint8_t(std::round(std::clamp(weights[w] / sum, 0.0f, 1.0f) * 255.0f));
+        total += packed[i].weights[w];
+        if (weights[w] > weights[largest])
+          largest = w;
+      }
+      packed[i].weights[largest] = std::uint8_t(std::clamp(packed[i].weights[largest] + 255 - total, 0, 255));
+    }
+
+    _skinned = true;
+    _upload = _uploads->upload<packed_joint>(
+      arena->joints_buffer(), packed, _range.first_vertex * sizeof(packed_joint));
+    ++_version;
+  }
+
+  void mesh::init(rnu::triangulated_object_t const& tri, vertex_format format)
+  {
+    release();
 
     if (tri.indices.empty() || tri.positions.empty())
       return;
@@ -63,108 +184,172 @@ namespace gev::game
     bounds.position = min;
     bounds.size = max - min;
 
-    init(bounds, tri.indices, vec4_positions, tri.normals, tri.texcoords);
+    init(bounds, tri.indices, vec4_positions, tri.normals, tri.texcoords, format);
   }
 
   void mesh::init(rnu::box3f bounds, std::span<std::uint32_t const> indices, std::span<rnu::vec4 const> positions,
-    std::span<rnu::vec3 const> normals, std::span<rnu::vec2 const> texcoords)
+    std::span<rnu::vec3 const> normals, std::span<rnu::vec2 const> texcoords, vertex_format format)
   {
-    gev::engine::get().device().waitIdle();
+    // The previous range is only recycled by the arena once frames in flight are done with it.
+    release();
+    ++_version;
 
-    if (!_index_buffer || indices.size() * sizeof(std::uint32_t) > _index_buffer->size())
-    {
-      _index_buffer = gev::buffer::device_local(indices.size() * sizeof(std::uint32_t),
-        vk::BufferUsageFlagBits::eIndexBuffer | vk::BufferUsageFlagBits::eStorageBuffer |
-          vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eTransferSrc);
-    }
-    if (!_vertex_buffer || positions.size() * sizeof(rnu::vec4) > _vertex_buffer->size())
+    _bounds = bounds;
+    _format = format;
+    _decode_offset = rnu::vec3(0, 0, 0);
+    _decode_scale = rnu::vec3(1, 1, 1);
+    if (indices.empty() || positions.empty())
+      return;
+
+    auto const arena = mesh_arena::defaults();
+    _arena = arena;
+    _range = arena->allocate(std::uint32_t(positions.size()), std::uint32_t(indices.size()), format);
+    _num_indices = _range.index_count;
+    _uploads->upload(arena->index_buffer(), indices, _range.first_index * sizeof(std::uint32_t));
+
+    if (format == vertex_format::packed)
     {
-      _vertex_buffer = gev::buffer::device_local(positions.size() * sizeof(rnu::vec4),
-        vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eStorageBuffer |
-          vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eTransferSrc);
+      auto const lower = bounds.lower();
+      auto const upper = bounds.upper();
+      _decode_offset = (lower + upper) * 0.5f;
+      _decode_scale = rnu::max((upper - lower) * 0.5f, rnu::vec3(1e-6f));
+
+      // Normals are scaled like the positions, so that the normal matrix of the decoded transform restores them.
+      std::vector<packed_vertex> vertices(positions.size());
+      for (std::size_t i = 0; i < vertices.size(); ++i)
+      {
+        auto const& p = positions[i];
+        auto& v = vertices[i];
+        v.position[0] = to_snorm16((p.x - _decode_offset.x) / _decode_scale.x);
+        v.position[1] = to_snorm16((p.y - _decode_offset.y) / _decode_scale.y);
+        v.position[2] = to_snorm16((p.z - _decode_offset.z) / _decode_scale.z);
+        v.position[3] = to_snorm16(1.0f);
+
+        auto const n = i < normals.size() ? normals[i] : rnu::vec3(0, 0, 1);
+        auto const e = octahedral_encode(
+          rnu::vec3(n.x * _decode_scale.x, n.y * _decode_scale.y, n.z * _decode_scale.z));
+        v.normal[0] = to_snorm16(e.x);
+        v.normal[1] = to_snorm16(e.y);
+
+        auto const t = i < texcoords.size() ? texcoords[i] : rnu::vec2(0, 0);
+        v.texcoord[0] = rnu::to_half(t.x);
+        v.texcoord[1] = rnu::to_half(t.y);
+      }
+      _upload = _uploads->upload<packed_vertex>(
+        arena->packed_buffer(), vertices, _range.first_vertex * sizeof(packed_vertex));
+      return;
     }
-    if (!_normal_buffer || normals.size() * sizeof(rnu::vec3) > _normal_buffer->size())
+
+    // Every stream spans the allocated vertex range, missing attributes are padded like in the packed format.
+    std::vector<rnu::vec3> padded_normals;
+    if (normals.size() < positions.size())
     {
-      _normal_buffer = gev::buffer::device_local(normals.size() * sizeof(rnu::vec3),
-        vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eTransferDst |
-          vk::BufferUsageFlagBits::eTransferSrc);
+      padded_normals.assign(normals.begin(), normals.end());
+      padded_normals.resize(positions.size(), rnu::vec3(0, 0, 1));
+      normals = padded_normals;
     }
-    if (!_texcoords_buffer || texcoords.size() * sizeof(rnu::vec2) > _texcoords_buffer->size())
+    std::vector<rnu::vec2> padded_texcoords;
+    if (texcoords.size() < positions.size())
     {
-      _texcoords_buffer = gev::buffer::device_local(texcoords.size() * sizeof(rnu::vec2),
-        vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eTransferDst |
-          vk::BufferUsageFlagBits::eTransferSrc);
+      padded_texcoords.assign(texcoords.begin(), texcoords.end());
+      padded_texcoords.resize(positions.size(), rnu::vec2(0, 0));
+      texcoords = padded_texcoords;
     }
 
-    _bounds = bounds;
-
-    _num_indices = indices.size();
-    _index_buffer->load_data<std::uint32_t>(indices);
-    _vertex_buffer->load_data<rnu::vec4>(positions);
-    _normal_buffer->load_data<rnu::vec3>(normals);
-    _texcoords_buffer->load_data<rnu::vec2>(texcoords);
+    _uploads->upload(arena->position_buffer(), positions, _range.first_vertex * sizeof(rnu::vec4));
+    _uploads->upload(
+      arena->normal_buffer(), normals.subspan(0, positions.size()), _range.first_vertex * sizeof(rnu::vec3));
+    _upload = _uploads->upload(
+      arena->texcoords_buffer(), texcoords.subspan(0, positions.size()), _range.first_vertex * sizeof(rnu::vec2));
   }
 
   void mesh::draw(vk::CommandBuffer c, std::uint32_t instance_count, std::uint32_t base_instance)
   {
-    if (_num_indices == 0)
+    auto const arena = _arena.lock();
+    if (!arena || _num_indices == 0 || !_uploads->is_complete(_upload))
       return;
 
-    if (_joints_buffer)
+    arena->bind(c, _format);
+    c.drawIndexed(_num_indices, instance_count, _range.first_index, std::int32_t(_range.first_vertex), base_instance);
+  }
+
+  void mesh::serialize(serializer& base, std::ostream& out)
+  {
+    _uploads->wait(_upload);
+    write_typed(_bounds, out);
+
+    auto const arena = _arena.lock();
+    auto const read_back = [&]<typename T>(gev::buffer& buffer, std::uint32_t first, std::uint32_t count)
     {
-      vk::VertexInputAttributeDescription2EXT const attributes[] = {
-        {0u, 0u, vk::Format::eR32G32B32Sfloat, 0},
-        {1u, 1u, vk::Format::eR32G32B32Sfloat, 0},
-        {2u, 2u, vk::Format::eR32G32Sfloat, 0},
-        {3u, 3u, vk::Format::eR16G16B16A16Uint, 0},
-        {4u, 3u, vk::Format::eR32G32B32A32Sfloat, sizeof(rnu::vec4ui16)},
-      };
-      vk::VertexInputBindingDescription2EXT const bindings[] = {
-        {0u, sizeof(rnu::vec4), vk::VertexInputRate::eVertex, 1},
-        {1u, sizeof(rnu::vec3), vk::VertexInputRate::eVertex, 1},
-        {2u, sizeof(rnu::vec2), vk::VertexInputRate::eVertex, 1},
-        {3u, sizeof(scenery::joint), vk::VertexInputRate::eVertex, 1},
-      };
-      c.setVertexInputEXT(bindings, attributes);
-      c.bindVertexBuffers(0,
-        {_vertex_buffer->get_buffer(), _normal_buffer->get_buffer(), _texcoords_buffer->get_buffer(),
-          _joints_buffer->get_buffer()},
-        {0ull, 0ull, 0ull, 0ull});
+      std::vector<T> data(count);
+      buffer.get_data(data.data(), std::uint32_t(data.size() * sizeof(T)), std::uint32_t(first * sizeof(T)));
+      write_vector(data, out);
+    };
+
+    if (!arena || _num_indices == 0)
+    {
+      for (int i = 0; i < 5; ++i)
+        write_size(0ull, out);
+      write_typed(_format, out);
+      return;
+    }
+
+    auto const first_vertex = _range.first_vertex;
+    auto const vertex_count = _range.vertex_count;
+    read_back.operator()<std::uint32_t>(*arena->index_buffer(), _range.first_index, _range.index_count);
+
+    // Assets always store full precision vertices, the format only decides how they are packed when loaded.
+    if (_format == vertex_format::packed)
+    {
+      std::vector<packed_vertex> vertices(vertex_count);
+      arena->packed_buffer()->get_data(vertices.data(), std::uint32_t(vertices.size() * sizeof(packed_vertex)),
+        std::uint32_t(first_vertex * sizeof(packed_vertex)));
+
+      std::vector<rnu::vec4> positions(vertex_count);
+      std::vector<rnu::vec3> normals(vertex_count);
+      std::vector<rnu::vec2> texcoords(vertex_count);
+      for (std::size_t i = 0; i < vertices.size(); ++i)
+      {
+        auto const& v = vertices[i];
+        positions[i] = rnu::vec4(_decode_offset.x + from_snorm16(v.position[0]) * _decode_scale.x,
+          _decode_offset.y + from_snorm16(v.position[1]) * _decode_scale.y,
+          _decode_offset.z + from_snorm16(v.position[2]) * _decode_scale.z, 1.0f);
+        auto const n = octahedral_decode(rnu::vec2(from_snorm16(v.normal[0]), from_snorm16(v.normal[1])));
+        normals[i] = rnu::normalize(rnu::vec3(n.x / _decode_scale.x, n.y / _decode_scale.y, n.z / _decode_scale.z));
+        texcoords[i] = rnu::vec2(from_half(v.texcoord[0]), from_half(v.texcoord[1]));
+      }
+      write_vector(positions, out);
+      write_vector(normals, out);
+      write_vector(texcoords, out);
     }
     else
     {
-      vk::VertexInputAttributeDescription2EXT const attributes[] = {
-        {0u, 0u, vk::Format::eR32G32B32Sfloat, 0},
-        {1u, 1u, vk::Format::eR32G32B32Sfloat, 0},
-        {2u, 2u, vk::Format::eR32G32Sfloat, 0},
-      };
-      vk::VertexInputBindingDescription2EXT const bindings[] = {
-        {0u, sizeof(rnu::vec4), vk::VertexInputRate::eVertex, 1},
-        {1u, sizeof(rnu::vec3), vk::VertexInputRate::eVertex, 1},
-        {2u, sizeof(rnu::vec2), vk::VertexInputRate::eVertex, 1},
-      };
-      c.setVertexInputEXT(bindings, attributes);
-      c.bindVertexBuffers(0,
-        {_vertex_buffer->get_buffer(), _normal_buffer->get_buffer(), _texcoords_buffer->get_buffer()},
-        {0ull, 0ull, 0ull});
+      read_back.operator()<rnu::vec4>(*arena->position_buffer(), first_vertex, vertex_count);
+      read_back.operator()<rnu::vec3>(*arena->normal_buffer(), first_vertex, vertex_count);
+      read_back.operator()<rnu::vec2>(*arena->texcoords_buffer(), first_vertex, vertex_count);
     }
 
-    c.bindIndexBuffer(_index_buffer->get_buffer(), 0, vk::IndexType::eUint32);
-    c.drawIndexed(_num_indices, instance_count, 0, 0, base_instance);
-  }
-
-  void mesh::serialize(serializer& base, std::ostream& out)
-  {
-    write_typed(_bounds, out);
-    write_vector(_index_buffer->get_data<std::uint32_t>(), out);
-    write_vector(_vertex_buffer->get_data<rnu::vec4>(), out);
-    write_vector(_normal_buffer->get_data<rnu::vec3>(), out);
-    write_vector(_texcoords_buffer->get_data<rnu::vec2>(), out);
+    if (_skinned)
+    {
+      std::vector<packed_joint> packed(vertex_count);
+      arena->joints_buffer()->get_data(packed.data(), std::uint32_t(packed.size() * sizeof(packed_joint)),
+        std::uint32_t(first_vertex * sizeof(packed_joint)));
 
-    if (_joints_buffer)
-      write_vector(_joints_buffer->get_data<scenery::joint>(), out);
+      std::vector<scenery::joint> joints(vertex_count);
+      for (std::size_t i = 0; i < joints.size(); ++i)
+      {
+        std::memcpy(&joints[i].indices, packed[i].indices, sizeof(packed[i].indices));
+        joints[i].weights = rnu::vec4(packed[i].weights[0] / 255.0f, packed[i].weights[1] / 255.0f,
+          packed[i].weights[2] / 255.0f, packed[i].weights[3] / 255.0f);
+      }
+      write_vector(joints, out);
+    }
     else
+    {
       write_size(0ull, out);
+    }
+    write_size(vertex_format_tag, out);
+    write_typed(_format, out);
   }
 
   void mesh::deserialize(serializer& base, std::istream& in)
@@ -182,7 +367,19 @@ namespace gev::game
     read_vector(texcoords, in);
 
     read_vector(joints, in);
-    init(_bounds, indices, positions, normals, texcoords);
+    // Older assets have no format and read back as the standard one.
+    auto format = vertex_format::standard;
+    auto const start = in.tellg();
+    std::size_t tag = 0;
+    read_size(tag, in);
+    if (in && tag == vertex_format_tag)
+      read_typed(format, in);
+    else
+    {
+      in.clear();
+      in.seekg(start);
+    }
+    init(_bounds, indices, positions, normals, texcoords, format);
 
     if (!joints.empty())
       make_skinned(joints);
@@ -198,28 +395,48 @@ namespace gev::game
     return _num_indices;
   }
 
-  gev::buffer const& mesh::index_buffer() const
+  mesh_range const& mesh::range() const
   {
-    return *_index_buffer;
+    return _range;
   }
 
-  gev::buffer const& mesh::vertex_buffer() const
+  bool mesh::is_skinned() const
   {
-    return *_vertex_buffer;
+    return _skinned;
   }
 
-  gev::buffer const& mesh::normal_buffer() const
+  bool mesh::is_uploaded() const
   {
-    return *_normal_buffer;
+    return _num_indices != 0 && _uploads->is_complete(_upload);
   }
 
-  gev::buffer const& mesh::texcoords_buffer() const
+  std::uint32_t mesh::version() const
   {
-    return *_texcoords_buffer;
+    return _version;
   }
 
-  gev::buffer const* mesh::joints_buffer() const
+  vertex_format mesh::format() const
+  {
+    return _format;
+  }
+
+  rnu::vec3 const& mesh::decode_offset() const
+  {
+    return _decode_offset;
+  }
+
+  rnu::vec3 const& mesh::decode_scale() const
+  {
+    return _decode_scale;
+  }
+
+  gev::buffer const& mesh::index_buffer() const
+  {
+    return *_arena.lock()->index_buffer();
+  }
+
+  gev::buffer const& mesh::vertex_buffer() const
   {
-    return _joints_buffer.get();
+    return *_arena.lock()->position_buffer();
   }
 }    // namespace gev::game
\ No newline at end of file
@@ -0,0 +1,238 @@
+#include <cstddef>
+#include <format>
+#include <gev/engine.hpp>
+#include <gev/game/mesh_arena.hpp>
+#include <stdexcept>
+
+namespace gev::game
+{
+  static std::uint32_t storage_alignment()
+  {
+    return std::uint32_t(gev::engine::get().physical_device().getProperties().limits.minStorageBufferOffsetAlignment);
+  }
+
+  range_allocator::range_allocator(std::uint32_t capacity, std::uint32_t granularity) : _granularity(granularity)
+  {
+    _free.emplace(0, capacity - capacity % _granularity);
+  }
+
+  std::uint32_t range_allocator::round_up(std::uint32_t count) const
+  {
+    return (count + _granularity - 1) / _granularity * _granularity;
+  }
+
+  std::optional<std::uint32_t> range_allocator::allocate(std::uint32_t count)
+  {
+    count = round_up(count);
+    for (auto iter = _free.begin(); iter != _free.end(); ++iter)
+    {
+      if (iter->second < count)
+        continue;
+
+      auto const [offset, size] = *iter;
+      _free.erase(iter);
+      if (size > count)
+        _free.emplace(offset + count, size - count);
+      return offset;
+    }
+    return std::nullopt;
+  }
+
+  void range_allocator::free(std::uint32_t offset, std::uint32_t count)
+  {
+    count = round_up(count);
+    auto iter = _free.emplace(offset, count).first;
+
+    if (auto const next = std::next(iter); next != _free.end() && iter->first + iter->second == next->first)
+    {
+      iter->second += next->second;
+      _free.erase(next);
+    }
+
+    if (iter != _free.begin())
+    {
+      auto const prev = std::prev(iter);
+      if (prev->first + prev->second == iter->first)
+      {
+        prev->second += iter->second;
+        _free.erase(iter);
+      }
+    }
+  }
+
+  std::shared_ptr<mesh_arena> mesh_arena::defaults()
+  {
+    auto arena = gev::service<mesh_arena>();
+    if (!arena)
+      arena = gev::register_service<mesh_arena>();
+    return arena;
+  }
+
+  mesh_arena::mesh_arena(std::uint32_t max_vertices, std::uint32_t max_indices, std::uint32_t max_packed_vertices)
+    : _max_vertices(max_vertices),
+      _max_indices(max_indices),
+      _max_packed_vertices(max_packed_vertices),
+      _num_frames(gev::engine::get().num_images()),
+      _vertices(max_vertices, std::max(1u, storage_alignment() / std::uint32_t(sizeof(rnu::vec4)))),
+      _packed_vertices(max_packed_vertices, 1),
+      _indices(max_indices, std::max(1u, storage_alignment() / std::uint32_t(sizeof(std::uint32_t))))
+  {
+    auto const usage = vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eTransferSrc;
+    _index_buffer = gev::buffer::device_local(max_indices * sizeof(std::uint32_t),
+      usage | vk::BufferUsageFlagBits::eIndexBuffer | vk::BufferUsageFlagBits::eStorageBuffer);
+    _position_buffer = gev::buffer::device_local(max_vertices * sizeof(rnu::vec4),
+      usage | vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eStorageBuffer);
+    _normal_buffer = gev::buffer::device_local(max_vertices * sizeof(rnu::vec3),
+      usage | vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eStorageBuffer);
+    _texcoords_buffer =
+      gev::buffer::device_local(max_vertices * sizeof(rnu::vec2), usage | vk::BufferUsageFlagBits::eVertexBuffer);
+    _packed_buffer = gev::buffer::device_local(
+      max_packed_vertices * sizeof(packed_vertex), usage | vk::BufferUsageFlagBits::eVertexBuffer);
+  }
+
+  mesh_range mesh_arena::allocate(std::uint32_t vertex_count, std::uint32_t index_count, vertex_format format)
+  {
+    // Both formats index from their own streams, so their vertex ranges may overlap.
+    auto& vertices = format == vertex_format::packed ? _packed_vertices : _vertices;
+    auto const first_vertex = vertices.allocate(vertex_count);
+    if (!first_vertex)
+    {
+      throw std::runtime_error(std::format("Mesh arena is out of vertex space for {} vertices, it holds at most {}. "
+                                           "Register a mesh_arena with a larger capacity before creating meshes.",
+        vertex_count, format == vertex_format::packed ? _max_packed_vertices : _max_vertices));
+    }
+
+    // Ranges without indices draw with the ones of another mesh.
+    auto const first_index = index_count == 0 ? std::optional<std::uint32_t>(0) : _indices.allocate(index_count);
+    if (!first_index)
+    {
+      vertices.free(*first_vertex, vertex_count);
+      throw std::runtime_error(std::format("Mesh arena is out of index space for {} indices, it holds at most {}. "
+                                           "Register a mesh_arena with a larger capacity before creating meshes.",
+        index_count, _max_indices));
+    }
+
+    return mesh_range{
+      .first_index = *first_index,
+      .index_count = index_count,
+      .first_vertex = *first_vertex,
+      .vertex_count = vertex_count,
+      .format = format,
+    };
+  }
+
+  void mesh_arena::free(mesh_range const& range)
+  {
+    // Frames in flight may still draw from the range.
+    _retired.push_back(retired_range{range, _frame + _num_frames});
+  }
+
+  void mesh_arena::sync()
+  {
+    _frame = gev::current_frame().frame_number;
+    std::erase_if(_retired,
+      [&](retired_range const& r)
+      {
+        if (r.reuse_frame > _frame)
+          return false;
+        auto& vertices = r.range.format == vertex_format::packed ? _packed_vertices : _vertices;
+        vertices.free(r.range.first_vertex, r.range.vertex_count);
+        if (r.range.index_count != 0)
+          _indices.free(r.range.first_index, r.range.index_count);
+        return true;
+      });
+  }
+
+  void mesh_arena::bind(vk::CommandBuffer c, vertex_format format) const
+  {
+    if (format == vertex_format::packed)
+    {
+      vk::VertexInputAttributeDescription2EXT const attributes[] = {
+        {0u, 0u, vk::Format::eR16G16B16A16Snorm, offsetof(packed_vertex, position)},
+        {1u, 0u, vk::Format::eR16G16Snorm, offsetof(packed_vertex, normal)},
+        {2u, 0u, vk::Format::eR16G16Sfloat, offsetof(packed_vertex, texcoord)},
+      };
+      vk::VertexInputBindingDescription2EXT const bindings[] = {
+        {0u, sizeof(packed_vertex), vk::VertexInputRate::eVertex, 1},
+      };
+      c.setVertexInputEXT(bindings, attributes);
+      c.bindVertexBuffers(0, {_packed_buffer->get_buffer()}, {0ull});
+    }
+    else if (_joints_buffer)
+    {
+      vk::VertexInputAttributeDescription2EXT const attributes[] = {
+        {0u, 0u, vk::Format::eR32G32B32Sfloat, 0},
+        {1u, 1u, vk::Format::eR32G32B32Sfloat, 0},
+        {2u, 2u, vk::Format::eR32G32Sfloat, 0},
+        {3u, 3u, vk::Format::eR16G16B16A16Uint, offsetof(packed_joint, indices)},
+        {4u, 3u, vk::Format::eR8G8B8A8Unorm, offsetof(packed_joint, weights)},
+      };
+      vk::VertexInputBindingDescription2EXT const bindings[] = {
+        {0u, sizeof(rnu::vec4), vk::VertexInputRate::eVertex, 1},
+        {1u, sizeof(rnu::vec3), vk::VertexInputRate::eVertex, 1},
+        {2u, sizeof(rnu::vec2), vk::VertexInputRate::eVertex, 1},
+        {3u, sizeof(packed_joint), vk::VertexInputRate::eVertex, 1},
+      };
+      c.setVertexInputEXT(bindings, attributes);
+      c.bindVertexBuffers(0,
+        {_position_buffer->get_buffer(), _normal_buffer->get_buffer(), _texcoords_buffer->get_buffer(),
+          _joints_buffer->get_buffer()},
+        {0ull, 0ull, 0ull, 0ull});
+    }
+    else
+    {
+      vk::VertexInputAttributeDescription2EXT const attributes[] = {
+        {0u, 0u, vk::Format::eR32G32B32Sfloat, 0},
+        {1u, 1u, vk::Format::eR32G32B32Sfloat, 0},
+        {2u, 2u, vk::Format::eR32G32Sfloat, 0},
+      };
+      vk::VertexInputBindingDescription2EXT const bindings[] = {
+        {0u, sizeof(rnu::vec4), vk::VertexInputRate::eVertex, 1},
+        {1u, sizeof(rnu::vec3), vk::VertexInputRate::eVertex, 1},
+        {2u, sizeof(rnu::vec2), vk::VertexInputRate::eVertex, 1},
+      };
+      c.setVertexInputEXT(bindings, attributes);
+      c.bindVertexBuffers(0,
+        {_position_buffer->get_buffer(), _normal_buffer->get_buffer(), _texcoords_buffer->get_buffer()},
+        {0ull, 0ull, 0ull});
+    }
+    c.bindIndexBuffer(_index_buffer->get_buffer(), 0, vk::IndexType::eUint32);
+  }
+
+  std::shared_ptr<gev::buffer> const& mesh_arena::index_buffer() const
+  {
+    return _index_buffer;
+  }
+
+  std::shared_ptr<gev::buffer> const& mesh_arena::position_buffer() const
+  {
+    return _position_buffer;
+  }
+
+  std::shared_ptr<gev::buffer> const& mesh_arena::normal_buffer() const
+  {
+    return _normal_buffer;
+  }
+
+  std::shared_ptr<gev::buffer> const& mesh_arena::texcoords_buffer() const
+  {
+    return _texcoords_buffer;
+  }
+
+  std::shared_ptr<gev::buffer> const& mesh_arena::packed_buffer() const
+  {
+    return _packed_buffer;
+  }
+
+  std::shared_ptr<gev::buffer> const& mesh_arena::joints_buffer()
+  {
+    // Only skinned meshes need joints, so the stream is created with the first one of them.
+    if (!_joints_buffer)
+    {
+      _joints_buffer = gev::buffer::device_local(_max_vertices * sizeof(packed_joint),
+        vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eTransferSrc |
+          vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eStorageBuffer);
+    }
+    return _joints_buffer;
+  }
+}    // namespace gev::game
@@ -1,9 +1,66 @@
+#include <algorithm>
+#include <bit>
+#include <cstring>
 #include <gev/descriptors.hpp>
+#include <gev/game/camera.hpp>
 #include <gev/game/layouts.hpp>
 #include <gev/game/mesh_batch.hpp>
 
 namespace gev::game
 {
+  static void memory_barrier(vk::CommandBuffer c, vk::PipelineStageFlags2 src_stage, vk::AccessFlags2 src_access,
+    vk::PipelineStageFlags2 dst_stage, vk::AccessFlags2 dst_access)
+  {
+    vk::MemoryBarrier2 const barrier(src_stage, src_access, dst_stage, dst_access);
+    vk::DependencyInfo dep;
+    dep.setMemoryBarriers(barrier);
+    c.pipelineBarrier2(dep);
+  }
+
+  // The mapping from stored to mesh space positions is folded into the rows, so packed meshes decode for free.
+  static std::array<rnu::vec4, 3> affine_rows(
+    rnu::mat4 const& transform, rnu::vec3 const& decode_offset, rnu::vec3 const& decode_scale)
+  {
+    // Matrices are stored column-major, the last row of an affine transform is implied.
+    float m[16];
+    std::memcpy(m, transform.data(), sizeof(m));
+
+    std::array<rnu::vec4, 3> rows;
+    for (int i = 0; i < 3; ++i)
+    {
+      rows[i] = rnu::vec4(m[i] * decode_scale.x, m[4 + i] * decode_scale.y, m[8 + i] * decode_scale.z,
+        m[i] * decode_offset.x + m[4 + i] * decode_offset.y + m[8 + i] * decode_offset.z + m[12 + i]);
+    }
+    return rows;
+  }
+
+  static std::array<rnu::vec4, 3> rebase_rows(std::array<rnu::vec4, 3> const& rows, rnu::vec3 const& from_offset,
+    rnu::vec3 const& from_scale, rnu::vec3 const& to_offset, rnu::vec3 const& to_scale)
+  {
+    std::array<rnu::vec4, 3> result;
+    for (int i = 0; i < 3; ++i)
+    {
+      auto const x = rows[i].x / from_scale.x;
+      auto const y = rows[i].y / from_scale.y;
+      auto const z = rows[i].z / from_scale.z;
+      auto const w = rows[i].w - (x * from_offset.x + y * from_offset.y + z * from_offset.z);
+      result[i] = rnu::vec4(x * to_scale.x, y * to_scale.y, z * to_scale.z,
+        x * to_offset.x + y * to_offset.y + z * to_offset.z + w);
+    }
+    return result;
+  }
+
+  // Batches and culled views each own a pool for their single object set.
+  static vk::UniqueDescriptorPool create_object_pool(std::uint32_t num_sets = 1)
+  {
+    vk::DescriptorPoolSize sizes[] = {
+      {vk::DescriptorType::eStorageBuffer, num_sets},
+    };
+    return gev::engine::get().device().createDescriptorPoolUnique(
+      vk::DescriptorPoolCreateInfo().setMaxSets(num_sets).setPoolSizes(sizes).setFlags(
+        vk::DescriptorPoolCreateFlagBits::eFreeDescriptorSet));
+  }
+
   void mesh_instance::destroy()
   {
     if (!_holder.expired())
@@ -11,84 +68,109 @@ namespace gev::game
       _holder.lock()->destroy(*this);
       _mesh.reset();
       _holder.reset();
-      _byte_offset = 0;
+      _slot = 0;
     }
   }
 
   void mesh_instance::update_transform(rnu::mat4 const& transform)
   {
     if (!_holder.expired())
-      _holder.lock()->update_transform_internal(_byte_offset, transform);
+      _holder.lock()->update_transform_internal(_slot, transform);
+  }
+
+  void mesh_instance::update_joint_offset(std::uint32_t offset)
+  {
+    if (!_holder.expired())
+      _holder.lock()->update_joint_offset_internal(_slot, offset);
   }
 
   mesh_batch::mesh_batch()
   {
-    vk::DescriptorPoolSize sizes[] = {
-      {vk::DescriptorType::eStorageBuffer, 1},
-    };
-    _mesh_pool = gev::engine::get().device().createDescriptorPoolUnique(
-      vk::DescriptorPoolCreateInfo().setMaxSets(1).setPoolSizes(sizes).setFlags(
-        vk::DescriptorPoolCreateFlagBits::eFreeDescriptorSet));
+    _mesh_pool = create_object_pool();
     auto const layout = layouts::defaults().object_set_layout();
     _mesh_descriptor = std::move(gev::engine::get().device().allocateDescriptorSetsUnique(
       vk::DescriptorSetAllocateInfo().setDescriptorPool(*_mesh_pool).setSetLayouts(layout))[0]);
   }
 
-  void mesh_batch::update_transform_internal(std::size_t offset, rnu::mat4 transform)
+  void mesh_batch::update_transform_internal(std::uint32_t slot, rnu::mat4 transform)
   {
-    auto const inv = inverse(transform);
+    auto const& ref = _instance_refs.find(_instances[slot]->_mesh)->second;
+    auto const rows = affine_rows(transform, ref.decode_offset, ref.decode_scale);
+    auto const& current = _mesh_infos[slot].transform;
+    if ((current[0] != rows[0]).any() || (current[1] != rows[1]).any() || (current[2] != rows[2]).any())
+      _mesh_infos.edit(slot).transform = rows;
+  }
 
-    auto const& index = offset / sizeof(mesh_info);
+  void mesh_batch::update_joint_offset_internal(std::uint32_t slot, std::uint32_t offset)
+  {
+    if (_mesh_infos[slot].joint_offset != offset)
+      _mesh_infos.edit(slot).joint_offset = offset;
+  }
 
-    if ((_mesh_infos[index].transform != transform).any())
-    {
-      _mesh_infos[index].transform = transform;
-      _mesh_infos[index].inverse_transform = inv;
-      include_update_region(offset, offset + sizeof(mesh_info));
-    }
+  std::shared_ptr<mesh_instance> mesh_batch::instantiate(
+    std::shared_ptr<mesh> const& id, rnu::mat4 transform, std::uint32_t material_index)
+  {
+    auto const instance = std::make_shared<mesh_instance>();
+    auto const& ref = insert(instance, id);
+    auto const rows = affine_rows(transform, ref.decode_offset, ref.decode_scale);
+    _mesh_infos.set(instance->_slot, mesh_info{.transform = rows, .material_index = material_index});
+    return instance;
   }
 
-  std::shared_ptr<mesh_instance> mesh_batch::instantiate(std::shared_ptr<mesh> const& id, rnu::mat4 transform)
+  mesh_batch::mesh_ref& mesh_batch::insert(
+    std::shared_ptr<mesh_instance> const& instance, std::shared_ptr<mesh> const& id)
   {
-    auto iter = _instance_refs.find(id);
-    if (iter == _instance_refs.end())
+    auto& ref = _instance_refs[id];
+    if (ref.instance_count == 0)
     {
-      iter = _instance_refs.emplace_hint(
-        iter, id, mesh_ref{.first_instance = _instances.size() * sizeof(mesh_info), .instance_count = 0});
+      ref.decode_offset = id->decode_offset();
+      ref.decode_scale = id->decode_scale();
     }
+    if (ref.instance_count == ref.capacity)
+      grow(ref);
 
-    auto& fi = iter->second;
-    for (auto& i : _instance_refs)
-    {
-      if (i.first != id && i.second.first_instance >= fi.first_instance)
-        i.second.first_instance += sizeof(mesh_info);
-    }
+    auto const slot = ref.first_slot + ref.instance_count++;
+    ++_num_instances;
 
-    auto const increase_from = fi.first_instance + fi.instance_count * sizeof(mesh_info);
+    instance->_slot = slot;
+    instance->_holder = shared_from_this();
+    instance->_mesh = id;
+    _instances[slot] = instance;
+    _cull_records.set(slot, make_record(*id, ref, slot));
+    _commands_dirty = true;
+    return ref;
+  }
 
-    for (auto iter = _instances.cbegin(); iter != _instances.cend(); ++iter)
+  void mesh_batch::transfer_material(std::uint32_t material_index, mesh_batch& target)
+  {
+    std::vector<std::shared_ptr<mesh_instance>> moved;
+    for (auto const& instance : _instances)
     {
-      if (iter->get()->_byte_offset < increase_from)
-        break;
-
-      iter->get()->_byte_offset += sizeof(mesh_info);
+      if (instance && _mesh_infos[instance->_slot].material_index == material_index)
+        moved.push_back(instance);
     }
 
-    auto const insert_byte = fi.first_instance + fi.instance_count * sizeof(mesh_info);
-    fi.instance_count += 1;
-
-    auto const instance = std::make_shared<mesh_instance>();
-    instance->_byte_offset = insert_byte;
-    instance->_holder = shared_from_this();
-    instance->_mesh = id;
-    auto const insert_index = insert_byte / sizeof(mesh_info);
-    _instances.insert(std::next(begin(_instances), insert_index), instance);
-    _mesh_infos.insert(std::next(begin(_mesh_infos), insert_index),
-      mesh_info{.transform = transform, .inverse_transform = inverse(transform)});
-
-    include_update_region(insert_byte, _instances.size() * sizeof(mesh_info));
+    for (auto const& instance : moved)
+    {
+      auto const& from = _instance_refs.find(instance->_mesh)->second;
+      auto const from_offset = from.decode_offset;
+      auto const from_scale = from.decode_scale;
+      auto info = _mesh_infos[instance->_slot];
+      auto const id = instance->_mesh;
+      destroy(*instance);
+
+      // The target may already hold the mesh with the decode mapping of an older version.
+      auto const& to = target.insert(instance, id);
+      if ((to.decode_offset != from_offset).any() || (to.decode_scale != from_scale).any())
+        info.transform = rebase_rows(info.transform, from_offset, from_scale, to.decode_offset, to.decode_scale);
+      target._mesh_infos.set(instance->_slot, info);
+    }
+  }
 
-    return instance;
+  bool mesh_batch::uses_material(std::uint32_t material_index) const
+  {
+    return std::ranges::any_of(_instances,
+      [&](auto const& instance) { return instance && _mesh_infos[instance->_slot].material_index == material_index; });
   }
 
   void mesh_batch::destroy(std::shared_ptr<mesh_instance> instance)
@@ -102,30 +184,126 @@ namespace gev::game
     if (iter == _instance_refs.end())
       return;
 
-    auto const& m = instance._mesh;
-    auto const byte_offset = instance._byte_offset;
+    auto& ref = iter->second;
+    auto const slot = instance._slot;
+    if (slot >= _instances.size() || _instances[slot].get() != &instance)
+      return;
 
-    for (auto& i : _instance_refs)
+    // The instance may be owned by this batch alone, it has to outlive the slot it is removed from.
+    auto const keep_alive = _instances[slot];
+    auto const last = ref.first_slot + --ref.instance_count;
+    if (slot != last)
+      move_slot(last, slot);
+    clear_slot(last);
+    --_num_instances;
+
+    if (ref.instance_count == 0)
     {
-      if (i.first != m && i.second.first_instance >= byte_offset)
-        i.second.first_instance -= sizeof(mesh_info);
+      _slots.free(ref.first_slot, ref.capacity);
+      _instance_refs.erase(iter);
     }
+    _commands_dirty = true;
+  }
 
-    for (auto iter = _instances.cbegin(); iter != _instances.cend(); ++iter)
+  void mesh_batch::grow(mesh_ref& ref)
+  {
+    auto const capacity = std::max(min_block_size, ref.capacity * 2);
+    auto first = _slots.allocate(capacity);
+    if (!first)
     {
-      if (iter->get()->_byte_offset < byte_offset)
-        break;
+      compact(capacity);
+      first = _slots.allocate(capacity);
+    }
 
-      iter->get()->_byte_offset -= sizeof(mesh_info);
+    for (std::uint32_t i = 0; i < ref.instance_count; ++i)
+    {
+      move_slot(ref.first_slot + i, *first + i);
+      clear_slot(ref.first_slot + i);
     }
+    if (ref.capacity != 0)
+      _slots.free(ref.first_slot, ref.capacity);
 
-    iter->second.instance_count -= 1;
-    if (iter->second.instance_count == 0)
-      _instance_refs.erase(iter);
+    ref.first_slot = *first;
+    ref.capacity = capacity;
+  }
+
+  void mesh_batch::compact(std::uint32_t extra_slots)
+  {
+    // Only runs once the slot space is exhausted, the doubled capacity amortizes it over the insertions that filled it.
+    auto required = extra_slots;
+    for (auto const& [m, ref] : _instance_refs)
+      required += ref.capacity;
+    auto const capacity = std::bit_ceil(std::max(std::uint32_t(min_reserved_elements), 2 * required));
+
+    std::vector<std::shared_ptr<mesh_instance>> instances(capacity);
+    std::vector<mesh_info> mesh_infos(capacity);
+    std::vector<frustum_culler::record> records(capacity);
+    _slots = range_allocator(capacity, 1);
+    for (auto& [m, ref] : _instance_refs)
+    {
+      if (ref.capacity == 0)
+        continue;
+
+      auto const first = *_slots.allocate(ref.capacity);
+      for (std::uint32_t i = 0; i < ref.instance_count; ++i)
+      {
+        auto const from = ref.first_slot + i;
+        instances[first + i] = std::move(_instances[from]);
+        instances[first + i]->_slot = first + i;
+        mesh_infos[first + i] = _mesh_infos[from];
+        records[first + i] = _cull_records[from];
+        records[first + i].instance = first + i;
+      }
+      ref.first_slot = first;
+    }
+
+    _instances = std::move(instances);
+    _mesh_infos.assign(std::move(mesh_infos));
+    _cull_records.assign(std::move(records));
+    _commands_dirty = true;
+  }
+
+  void mesh_batch::move_slot(std::uint32_t from, std::uint32_t to)
+  {
+    _instances[to] = std::move(_instances[from]);
+    _instances[to]->_slot = to;
+    _mesh_infos.set(to, _mesh_infos[from]);
+    auto record = _cull_records[from];
+    record.instance = to;
+    _cull_records.set(to, record);
+  }
+
+  void mesh_batch::clear_slot(std::uint32_t slot)
+  {
+    _instances[slot].reset();
+    _cull_records.set(slot, frustum_culler::record{});
+  }
 
-    auto const remove_index = byte_offset / sizeof(mesh_info);
-    _instances.erase(next(begin(_instances), remove_index));
-    _mesh_infos.erase(next(begin(_mesh_infos), remove_index));
+  frustum_culler::record mesh_batch::make_record(mesh const& m, mesh_ref const& ref, std::uint32_t slot) const
+  {
+    // Meshes are left out until their upload has landed, an empty record is skipped by the culler.
+    if (!ref.drawable)
+      return frustum_culler::record{.instance = slot};
+
+    // Bounds are tested in the space of the stored positions, which the instance rows map to the world.
+    auto const lower = m.bounds().lower() - ref.decode_offset;
+    auto const upper = m.bounds().upper() - ref.decode_offset;
+    auto const& scale = ref.decode_scale;
+    return frustum_culler::record{
+      .bounds_min = rnu::vec4(lower.x / scale.x, lower.y / scale.y, lower.z / scale.z, 1),
+      .bounds_max = rnu::vec4(upper.x / scale.x, upper.y / scale.y, upper.z / scale.z, 1),
+      .command = ref.command,
+      .instance = slot,
+    };
+  }
+
+  mesh_batch::cull_frame const* mesh_batch::culled_slot(camera const& cam) const
+  {
+    auto const& frame = gev::current_frame();
+    auto const view = _views.find(cam.id());
+    if (view == _views.end() || view->second.culled_frame != frame.frame_number)
+      return nullptr;
+    return &view->second.frames[frame.frame_index % view->second.frames.size()];
   }
 
   vk::DescriptorSet mesh_batch::descriptor() const
@@ -133,53 +311,234 @@ namespace gev::game
     return _mesh_descriptor.get();
   }
 
-  void mesh_batch::render(vk::CommandBuffer c)
+  vk::DescriptorSet mesh_batch::descriptor(camera const& cam) const
+  {
+    if (auto const culled = culled_slot(cam))
+      return culled->descriptor;
+    return _mesh_descriptor.get();
+  }
+
+  void mesh_batch::render(vk::CommandBuffer c, camera const& cam)
   {
-    for (auto const& ref : _instance_refs)
+    if (_num_instances == 0)
+      return;
+
+    // Views culled this frame draw the meshes with survivors from the compacted list, all others draw every instance.
+    if (auto const culled = culled_slot(cam))
     {
-      auto const first_index = ref.second.first_instance / sizeof(mesh_info);
-      ref.first->draw(c, ref.second.instance_count, first_index);
+      c.drawIndexedIndirectCount(culled->draws->get_buffer(), 0, culled->draw_count->get_buffer(), 0,
+        culled->num_commands, sizeof(vk::DrawIndexedIndirectCommand));
+      return;
     }
+
+    if (!_commands_buffer || _commands.empty())
+      return;
+
+    c.drawIndexedIndirect(_commands_buffer->buffer().get_buffer(), 0, std::uint32_t(_commands.size()),
+      sizeof(vk::DrawIndexedIndirectCommand));
   }
 
-  void mesh_batch::try_flush_buffer(vk::CommandBuffer c)
+  void mesh_batch::cull(vk::CommandBuffer c, frustum_culler const& culler, camera const& cam)
   {
-    if (_instances_buffer && _update_region_end <= _update_region_start)
+    auto& view = _views[cam.id()];
+    view.instances = _num_instances;
+    if (!_mesh_infos.has_buffer() || !_cull_records.has_buffer() || _cull_commands.empty())
+    {
+      view.visible = 0;
       return;
+    }
 
-    if (!_instances_buffer || _update_region_end > _instances_buffer->size())
+    auto const& frame = gev::current_frame();
+    if (!view.pool)
     {
-      auto v = std::max(min_reserved_elements * sizeof(mesh_info), _update_region_end);
-      v--;
-      v |= v >> 1;
-      v |= v >> 2;
-      v |= v >> 4;
-      v |= v >> 8;
-      v |= v >> 16;
-      v |= v >> 32;
-      v++;
+      auto const num_frames = gev::engine::get().num_images();
+      view.pool = create_object_pool(num_frames);
+      std::vector<vk::DescriptorSetLayout> const set_layouts(num_frames, layouts::defaults().object_set_layout());
+      auto const sets = gev::engine::get().device().allocateDescriptorSets(
+        vk::DescriptorSetAllocateInfo().setDescriptorPool(*view.pool).setSetLayouts(set_layouts));
+      view.frames.resize(num_frames);
+      for (std::uint32_t i = 0; i < num_frames; ++i)
+        view.frames[i].descriptor = sets[i];
+    }
 
-      _instances_buffer.reset();
-      _instances_buffer = std::make_unique<gev::game::sync_buffer>(v, vk::BufferUsageFlagBits::eStorageBuffer, 3);
+    // This frame slot was last used num_frames ago, its fence has been waited on already.
+    auto& slot = view.frames[frame.frame_index % view.frames.size()];
+    if (!slot.count)
+    {
+      slot.count = gev::buffer::device_local(sizeof(std::uint32_t),
+        vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst |
+          vk::BufferUsageFlagBits::eTransferSrc);
+      slot.draw_count = gev::buffer::device_local(sizeof(std::uint32_t),
+        vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eIndirectBuffer |
+          vk::BufferUsageFlagBits::eTransferDst);
+      slot.readback = std::make_unique<gev::buffer>(VMA_MEMORY_USAGE_AUTO_PREFER_HOST,
+        VMA_ALLOCATION_CREATE_HOST_ACCESS_RANDOM_BIT,
+        vk::BufferCreateInfo()
+          .setSharingMode(vk::SharingMode::eExclusive)
+          .setUsage(vk::BufferUsageFlagBits::eTransferDst)
+          .setSize(sizeof(std::uint32_t)));
+      std::uint32_t const zero = 0;
+      slot.readback->load_data(&zero, sizeof(zero));
+    }
 
-      gev::update_descriptor(
-          _mesh_descriptor.get(), binding_instances, _instances_buffer->buffer(), vk::DescriptorType::eStorageBuffer);
+    if (!slot.commands || slot.commands->size() < _cull_commands.size() * sizeof(vk::DrawIndexedIndirectCommand))
+    {
+      auto const size =
+        std::bit_ceil(std::max(min_reserved_elements, _cull_commands.size())) * sizeof(vk::DrawIndexedIndirectCommand);
+      slot.commands = gev::buffer::device_local(
+        size, vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst);
+      slot.draws = gev::buffer::device_local(
+        size, vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eIndirectBuffer);
+    }
+
+    // Survivors are packed into the slot block of their mesh, so the infos need as many slots as the batch.
+    if (!slot.infos || slot.infos->size() < _cull_records.size() * sizeof(mesh_info))
+    {
+      slot.infos = gev::buffer::device_local(
+        std::bit_ceil(std::max(min_reserved_elements, _cull_records.size())) * sizeof(mesh_info),
+        vk::BufferUsageFlagBits::eStorageBuffer);
+      gev::update_descriptor(slot.descriptor, binding_instances, *slot.infos, vk::DescriptorType::eStorageBuffer);
+    }
+
+    slot.readback->get_data(&view.visible, sizeof(std::uint32_t), 0);
+
+    memory_barrier(c,
+      vk::PipelineStageFlagBits2::eDrawIndirect | vk::PipelineStageFlagBits2::eVertexShader |
+        vk::PipelineStageFlagBits2::eTransfer,
+      vk::AccessFlagBits2::eIndirectCommandRead | vk::AccessFlagBits2::eShaderStorageRead |
+        vk::AccessFlagBits2::eTransferRead,
+      vk::PipelineStageFlagBits2::eTransfer | vk::PipelineStageFlagBits2::eComputeShader,
+      vk::AccessFlagBits2::eTransferWrite | vk::AccessFlagBits2::eShaderStorageWrite);
+    c.fillBuffer(slot.count->get_buffer(), 0, sizeof(std::uint32_t), 0);
+    c.fillBuffer(slot.draw_count->get_buffer(), 0, sizeof(std::uint32_t), 0);
+    slot.num_commands = std::uint32_t(_cull_commands.size());
+    c.copyBuffer(_cull_commands_buffer->buffer().get_buffer(), slot.commands->get_buffer(),
+      vk::BufferCopy(0, 0, slot.num_commands * sizeof(vk::DrawIndexedIndirectCommand)));
+    memory_barrier(c, vk::PipelineStageFlagBits2::eTransfer, vk::AccessFlagBits2::eTransferWrite,
+      vk::PipelineStageFlagBits2::eComputeShader,
+      vk::AccessFlagBits2::eShaderStorageRead | vk::AccessFlagBits2::eShaderStorageWrite |
+        vk::AccessFlagBits2::eUniformRead);
+
+    culler.dispatch(c, cam.uniform_buffer(), std::uint32_t(_cull_records.size()), _mesh_infos.buffer(),
+      _cull_records.buffer(), *slot.commands, *slot.count, *slot.infos);
+
+    memory_barrier(c, vk::PipelineStageFlagBits2::eComputeShader, vk::AccessFlagBits2::eShaderStorageWrite,
+      vk::PipelineStageFlagBits2::eComputeShader, vk::AccessFlagBits2::eShaderStorageRead);
+    culler.compact(c, slot.num_commands, *slot.commands, *slot.draws, *slot.draw_count);
+
+    memory_barrier(c, vk::PipelineStageFlagBits2::eComputeShader, vk::AccessFlagBits2::eShaderStorageWrite,
+      vk::PipelineStageFlagBits2::eDrawIndirect | vk::PipelineStageFlagBits2::eVertexShader |
+        vk::PipelineStageFlagBits2::eTransfer,
+      vk::AccessFlagBits2::eIndirectCommandRead | vk::AccessFlagBits2::eShaderStorageRead |
+        vk::AccessFlagBits2::eTransferRead);
+    slot.count->copy_to(c, *slot.readback, sizeof(std::uint32_t), 0, 0);
+    memory_barrier(c, vk::PipelineStageFlagBits2::eTransfer, vk::AccessFlagBits2::eTransferWrite,
+      vk::PipelineStageFlagBits2::eHost, vk::AccessFlagBits2::eHostRead);
+    view.culled_frame = frame.frame_number;
+  }
+
+  cull_statistics mesh_batch::statistics(camera const& cam) const
+  {
+    auto const view = _views.find(cam.id());
+    if (view == _views.end())
+      return cull_statistics{.instances = _num_instances, .visible = 0};
+    return cull_statistics{.instances = view->second.instances, .visible = view->second.visible};
+  }
+
+  void mesh_batch::flush_commands(vk::CommandBuffer c)
+  {
+    // Meshes are picked up once their upload has landed and again whenever they are reloaded.
+    for (auto& [m, ref] : _instance_refs)
+    {
+      auto const drawable = m->is_uploaded();
+      if (ref.mesh_version != m->version() || ref.drawable != drawable)
+      {
+        ref.mesh_version = m->version();
+        ref.drawable = drawable;
+
+        // A reload may have changed how positions are stored, the instances follow the new mapping.
+        if ((ref.decode_offset != m->decode_offset()).any() || (ref.decode_scale != m->decode_scale()).any())
+        {
+          for (auto slot = ref.first_slot; slot < ref.first_slot + ref.instance_count; ++slot)
+          {
+            _mesh_infos.edit(slot).transform = rebase_rows(_mesh_infos[slot].transform, ref.decode_offset,
+              ref.decode_scale, m->decode_offset(), m->decode_scale());
+          }
+          ref.decode_offset = m->decode_offset();
+          ref.decode_scale = m->decode_scale();
+        }
+        for (auto slot = ref.first_slot; slot < ref.first_slot + ref.instance_count; ++slot)
+          _cull_records.set(slot, make_record(*m, ref, slot));
+        _commands_dirty = true;
+      }
+    }
+
+    if (!_commands_dirty)
+      return;
+    _commands_dirty = false;
+
+    _commands.clear();
+    _cull_commands.clear();
+    for (auto& [m, ref] : _instance_refs)
+    {
+      // Cull records find the command of their mesh by index, they only change when it moves.
+      auto const command = ref.drawable ? std::uint32_t(_commands.size()) : frustum_culler::no_command;
+      if (ref.command != command)
+      {
+        ref.command = command;
+        for (auto slot = ref.first_slot; slot < ref.first_slot + ref.instance_count; ++slot)
+          _cull_records.edit(slot).command = command;
+      }
+      if (!ref.drawable)
+        continue;
+
+      auto const& range = m->range();
+      _commands.push_back(vk::DrawIndexedIndirectCommand(
+        range.index_count, ref.instance_count, range.first_index, std::int32_t(range.first_vertex), ref.first_slot));
+      _cull_commands.push_back(vk::DrawIndexedIndirectCommand(_commands.back()).setInstanceCount(0));
     }
 
-    /*if (_update_region_end > _update_region_start)
+    if (!_commands_buffer || _commands.size() * sizeof(vk::DrawIndexedIndirectCommand) > _commands_buffer->size())
     {
-      std::byte const* begin = reinterpret_cast<std::byte const*>(_mesh_infos.data()) + _update_region_start;*/
-    _instances_buffer->load_data<mesh_info>(_mesh_infos);
-    //}
-    _instances_buffer->sync(c);
+      _commands_buffer = std::make_unique<gev::game::sync_buffer>(
+        std::bit_ceil(std::max(min_reserved_elements, _commands.size())) * sizeof(vk::DrawIndexedIndirectCommand),
+        vk::BufferUsageFlagBits::eIndirectBuffer);
+    }
 
-    _update_region_start = std::numeric_limits<std::size_t>::max();
-    _update_region_end = std::numeric_limits<std::size_t>::lowest();
+    if (!_cull_commands_buffer || _commands_buffer->size() > _cull_commands_buffer->size())
+    {
+      _cull_commands_buffer = std::make_unique<gev::game::sync_buffer>(
+        _commands_buffer->size(), vk::BufferUsageFlagBits::eTransferSrc);
+    }
+
+    _commands_buffer->load_data<vk::DrawIndexedIndirectCommand>(_commands);
+    _commands_buffer->sync(c);
+    gev::buffer_barrier(c, _commands_buffer->buffer(), vk::PipelineStageFlagBits::eTransfer,
+      vk::AccessFlagBits::eTransferWrite, vk::PipelineStageFlagBits::eDrawIndirect,
+      vk::AccessFlagBits::eIndirectCommandRead);
+    _cull_commands_buffer->load_data<vk::DrawIndexedIndirectCommand>(_cull_commands);
+    _cull_commands_buffer->sync(c);
+    gev::buffer_barrier(c, _cull_commands_buffer->buffer(), vk::PipelineStageFlagBits::eTransfer,
+      vk::AccessFlagBits::eTransferWrite, vk::PipelineStageFlagBits::eTransfer, vk::AccessFlagBits::eTransferRead);
   }
 
-  void mesh_batch::include_update_region(std::size_t begin, std::size_t end)
+  void mesh_batch::try_flush_buffer(vk::CommandBuffer c)
   {
-    _update_region_start = std::min(_update_region_start, begin);
-    _update_region_end = std::max(_update_region_end, end);
+    // Cameras may have been destroyed, their buffers are released once no frame in flight can draw with them.
+    auto const frame = gev::current_frame().frame_number;
+    auto const num_frames = gev::engine::get().num_images();
+    std::erase_if(_views,
+      [&](auto const& view)
+      { return view.second.culled_frame == ~0ull || view.second.culled_frame + num_frames < frame; });
+
+    flush_commands(c);
+
+    // Only the slots touched since the last flush are uploaded.
+    _cull_records.sync(c);
+    if (_mesh_infos.sync(c))
+    {
+      gev::update_descriptor(
+        _mesh_descriptor.get(), binding_instances, _mesh_infos.buffer(), vk::DescriptorType::eStorageBuffer);
+    }
   }
-}    // namespace gev::game
\ No newline at end of file
+}    // namespace gev::game
@@ -1,26 +1,61 @@
 #include <gev/game/camera.hpp>
 #include <gev/game/layouts.hpp>
 #include <gev/game/mesh_renderer.hpp>
+#include <gev/gpu_profiler.hpp>
 #include <gev/pipeline.hpp>
 #include <gev_game_shaders_files.hpp>
 #include <gev/game/samplers.hpp>
+#include <stdexcept>
 
 namespace gev::game
 {
   mesh_renderer::mesh_renderer()
   {
     _batches = std::make_shared<batch_map>();
+    _materials = std::make_shared<material_table>();
+    _arena = mesh_arena::defaults();
+    _culler = std::make_unique<frustum_culler>();
+    _skinning = std::make_unique<skinning_pass>();
+    _palette = std::make_shared<joint_palette>();
   }
 
   std::shared_ptr<mesh_batch> mesh_renderer::batch(
     std::shared_ptr<shader> const& shader, std::shared_ptr<material> const& material)
   {
-    auto& b = (*_batches)[shader][material];
+    auto& b = (*_batches)[shader][material->two_sided() ? 1 : 0];
     if (!b)
       b = std::make_shared<mesh_batch>();
     return b;
   }
 
+  std::shared_ptr<mesh_instance> mesh_renderer::instantiate(std::shared_ptr<shader> const& shader,
+    std::shared_ptr<material> const& material, std::shared_ptr<mesh> const& mesh, rnu::mat4 const& transform)
+  {
+    if (mesh->format() != shader->format())
+      throw std::runtime_error("The vertex format of the mesh does not match the shader.");
+    return batch(shader, material)->instantiate(mesh, transform, material->index());
+  }
+
+  std::shared_ptr<material_table> const& mesh_renderer::materials() const
+  {
+    return _materials;
+  }
+
+  void mesh_renderer::set_two_sided(std::uint32_t material_index, bool two_sided)
+  {
+    for (auto& [shader, batches] : *_batches)
+    {
+      auto const& from = batches[two_sided ? 0 : 1];
+      if (!from || !from->uses_material(material_index))
+        continue;
+
+      auto& to = batches[two_sided ? 1 : 0];
+      if (!to)
+        to = std::make_shared<mesh_batch>();
+      from->transfer_material(material_index, *to);
+    }
+  }
+
   void mesh_renderer::set_environment_map(vk::DescriptorSet set)
   {
     _environment_set = set;
@@ -33,17 +68,79 @@ namespace gev::game
 
   void mesh_renderer::sync(vk::CommandBuffer c)
   {
+    auto const frame = gev::current_frame().frame_number;
+    if (frame == _synced_frame)
+      return;
+    _synced_frame = frame;
+
+    _arena->sync();
+    _materials->sync(c);
+    for (auto const& b : *_batches)
+    {
+      for (auto const& m : b.second)
+      {
+        if (m)
+          m->try_flush_buffer(c);
+      }
+    }
+    _skinning->dispatch(c, *_palette);
+  }
+
+  void mesh_renderer::set_compute_skinning(bool enabled)
+  {
+    _compute_skinning = enabled;
+  }
+
+  bool mesh_renderer::compute_skinning() const
+  {
+    return _compute_skinning;
+  }
+
+  skinning_pass& mesh_renderer::skinning()
+  {
+    return *_skinning;
+  }
+
+  std::shared_ptr<joint_palette> const& mesh_renderer::palette() const
+  {
+    return _palette;
+  }
+
+  void mesh_renderer::cull(vk::CommandBuffer c, camera const& cam)
+  {
+    auto const scope = profile_gpu(c, "mesh_renderer::cull");
     for (auto const& b : *_batches)
     {
       for (auto const& m : b.second)
-        m.second->try_flush_buffer(c);
+      {
+        if (m)
+          m->cull(c, *_culler, cam);
+      }
     }
   }
 
+  cull_statistics mesh_renderer::statistics(camera const& cam) const
+  {
+    cull_statistics result;
+    for (auto const& b : *_batches)
+    {
+      for (auto const& m : b.second)
+      {
+        if (!m)
+          continue;
+        auto const s = m->statistics(cam);
+        result.instances += s.instances;
+        result.visible += s.visible;
+      }
+    }
+    return result;
+  }
+
   void mesh_renderer::render(vk::CommandBuffer c, camera const& cam, std::int32_t x, std::int32_t y, std::uint32_t w,
     std::uint32_t h,
     pass_id pass, vk::SampleCountFlagBits samples)
   {
+    auto const scope = profile_gpu(c, "mesh_renderer::render");
     for (auto const& [shader, batch] : *_batches)
     {
       shader->bind(c, pass);
@@ -54,13 +151,19 @@ namespace gev::game
       shader->attach(c, cam.descriptor(), camera_set);
       shader->attach(c, _shadow_map_set, shadow_maps_set);
       shader->attach(c, _environment_set, environment_set);
+      shader->attach(c, _materials->descriptor(), material_set);
+      if (shader->skinned())
+        shader->attach(c, _palette->descriptor(), skin_set, _palette->frame_offset());
+      _arena->bind(c, shader->format());
 
-      int draw_calls = 0;
-      for (auto const& b : batch)
+      for (std::size_t i = 0; i < batch.size(); ++i)
       {
-        b.first->bind(c, shader->layout(), material_set);
-        shader->attach(c, b.second->descriptor(), object_info_set);
-        b.second->render(c);
+        if (!batch[i])
+          continue;
+
+        c.setCullMode(i == 1 ? vk::CullModeFlagBits::eNone : vk::CullModeFlagBits::eBack);
+        shader->attach(c, batch[i]->descriptor(cam), object_info_set);
+        batch[i]->render(c, cam);
       }
     }
   }
@@ -2,18 +2,19 @@
 
 namespace gev::game
 {
-  render_target_2d::render_target_2d(
-    vk::Extent2D size, vk::Format format, vk::ImageUsageFlags usage, vk::SampleCountFlagBits samples)
+  render_target_2d::render_target_2d(vk::Extent2D size, vk::Format format, vk::ImageUsageFlags usage,
+    vk::SampleCountFlagBits samples, std::uint32_t layers)
   {
     _image =
       gev::image_creator::get()
         .size(size.width, size.height)
         .type(vk::ImageType::e2D)
+        .layers(layers)
         .samples(samples)
         .usage(usage)
         .format(format)
         .build();
-    _owning_view = _image->create_view(vk::ImageViewType::e2D);
+    _owning_view = _image->create_view(layers == 1 ? vk::ImageViewType::e2D : vk::ImageViewType::e2DArray);
     _view = _owning_view.get();
   }
 
@@ -39,4 +40,11 @@ namespace gev::game
   {
     return _view;
   }
+
+  vk::ImageView render_target_2d::array_view() const
+  {
+    if (!_array_view)
+      _array_view = _image->create_view(vk::ImageViewType::e2DArray);
+    return _array_view.get();
+  }
 }    // namespace gev::game
\ No newline at end of file
@@ -1,6 +1,7 @@
 #include <gev/engine.hpp>
 #include <gev/game/formats.hpp>
 #include <gev/game/renderer.hpp>
+#include <gev/gpu_profiler.hpp>
 
 namespace gev::game
 {
@@ -22,15 +23,15 @@ namespace gev::game
     _depth_target = std::make_unique<render_target_2d>(size, _depth_format,
       vk::ImageUsageFlagBits::eDepthStencilAttachment | vk::ImageUsageFlagBits::eSampled |
         vk::ImageUsageFlagBits::eTransferSrc,
-      _samples);
+      _samples, _layers);
  
-    _color_target = std::make_unique<render_target_2d>(size, _color_format, _color_usage_flags, _samples);
+    _color_target = std::make_unique<render_target_2d>(size, _color_format, _color_usage_flags, _samples, _layers);
 
     _resolve_target.reset();
     if (_samples != vk::SampleCountFlagBits::e1)
     {
-      _resolve_target = std::make_unique<render_target_2d>(
-        size, _color_format, _color_usage_flags | vk::ImageUsageFlagBits::eTransferDst);
+      _resolve_target = std::make_unique<render_target_2d>(size, _color_format,
+        _color_usage_flags | vk::ImageUsageFlagBits::eTransferDst, vk::SampleCountFlagBits::e1, _layers);
     }
   }
 
@@ -57,6 +58,20 @@ namespace gev::game
     return _samples;
   }
 
+  void renderer::set_layers(std::uint32_t layers)
+  {
+    if (_layers != layers)
+    {
+      _layers = layers;
+      rebuild_attachments();
+    }
+  }
+
+  std::uint32_t renderer::get_layers() const
+  {
+    return _layers;
+  }
+
   renderer::renderer(vk::Extent2D size, vk::SampleCountFlagBits samples)
   {
     set_render_size(size);
@@ -175,6 +190,13 @@ namespace gev::game
     auto const& size = _render_size;
     vk::RenderingInfo info{};
     info.setLayerCount(1).setRenderArea(vk::Rect2D({0, 0}, {size.width, size.height}));
+    _used_view_mask = _layers > 1;
+    if (_used_view_mask)
+    {
+      info.setViewMask((1u << _layers) - 1);
+      if (auto const profiler = gev::service<gev::gpu_profiler>())
+        profiler->begin_multiview();
+    }
 
     if (use_color)
       info.setColorAttachments(_color_attachment);
@@ -201,6 +223,11 @@ namespace gev::game
     if (_used_depth)
       _depth_attachment.setLoadOp(vk::AttachmentLoadOp::eLoad);
     c.endRendering();
+    if (_used_view_mask)
+    {
+      if (auto const profiler = gev::service<gev::gpu_profiler>())
+        profiler->end_multiview();
+    }
   }
 
   void renderer::resolve(vk::CommandBuffer c)
@@ -43,6 +43,21 @@ namespace gev::game
     return _layout.get();
   }
 
+  bool shader::supports(pass_id pass) const
+  {
+    return pass == pass_id::forward;
+  }
+
+  vertex_format shader::format() const
+  {
+    return vertex_format::standard;
+  }
+
+  bool shader::skinned() const
+  {
+    return false;
+  }
+
   void shader::attach_always(vk::DescriptorSet set, std::uint32_t index)
   {
     _global_bindings[index] = set;
@@ -53,10 +68,34 @@ namespace gev::game
     c.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, _layout.get(), index, set, nullptr);
   }
 
+  void shader::attach(vk::CommandBuffer c, vk::DescriptorSet set, std::uint32_t index, std::uint32_t dynamic_offset)
+  {
+    c.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, _layout.get(), index, set, dynamic_offset);
+  }
+
   class default_shader : public shader
   {
   public:
-    default_shader(bool is_skinned) : _skinned(is_skinned) {}
+    default_shader(bool is_skinned, vertex_format format = vertex_format::standard)
+      : _skinned(is_skinned),
+        _format(format)
+    {
+    }
+
+    bool supports(pass_id pass) const override
+    {
+      return true;
+    }
+
+    vertex_format format() const override
+    {
+      return _format;
+    }
+
+    bool skinned() const override
+    {
+      return _skinned;
+    }
 
   protected:
     vk::UniquePipelineLayout rebuild_layout() override
@@ -87,8 +126,9 @@ namespace gev::game
         create_shader(load_spv(gev_game_shaders::shaders::shader2_frag));
 
       vk::SpecializationMapEntry pass_id(0, 0, sizeof(int));
-      vk::SpecializationMapEntry const entries[] = {pass_id};
-      int const pass_values[] = {int(std::size_t(pass))};
+      vk::SpecializationMapEntry format_id(1, sizeof(int), sizeof(int));
+      vk::SpecializationMapEntry const entries[] = {pass_id, format_id};
+      int const pass_values[] = {int(std::size_t(pass)), int(_format)};
       vk::SpecializationInfo info;
       info.setMapEntries(entries);
       info.setData<int>(pass_values);
@@ -100,7 +140,8 @@ namespace gev::game
           .depth_attachment(gev::engine::get().depth_format())
           .stencil_attachment(gev::engine::get().depth_format())
           .dynamic_states({vk::DynamicState::eCullMode, vk::DynamicState::eRasterizationSamplesEXT,
-            vk::DynamicState::eVertexInputEXT});
+            vk::DynamicState::eVertexInputEXT})
+          .view_mask(view_mask(pass));
 
       if (pass == pass_id::forward)
         builder.color_attachment(formats::forward_pass);
@@ -111,6 +152,7 @@ namespace gev::game
 
   private:
     bool _skinned = false;
+    vertex_format _format = vertex_format::standard;
   };
 
   std::shared_ptr<shader> shader::make_default()
@@ -123,10 +165,16 @@ namespace gev::game
     return std::make_shared<default_shader>(true);
   }
 
+  std::shared_ptr<shader> shader::make_packed()
+  {
+    return std::make_shared<default_shader>(false, vertex_format::packed);
+  }
+
   shader_repo::shader_repo()
   {
     emplace(shaders::standard, gev::game::shader::make_default());
     emplace(shaders::skinned, gev::game::shader::make_skinned());
+    emplace(shaders::packed, gev::game::shader::make_packed());
   }
 
   void shader_repo::invalidate_all() const
@@ -134,4 +182,26 @@ namespace gev::game
     for (auto const& [id, sh] : _resources)
       sh->invalidate();
   }
+
+  void shader_repo::prewarm() const
+  {
+    // Make sure the shared layouts exist before the workers race for them.
+    layouts::defaults();
+
+    std::vector<std::function<void()>> builders;
+    builders.reserve(_resources.size());
+    for (auto const& [id, sh] : _resources)
+    {
+      builders.push_back(
+        [sh]
+        {
+          for (auto const pass : all_passes)
+          {
+            if (sh->supports(pass))
+              sh->pipeline(pass);
+          }
+        });
+    }
+    gev::engine::get().pipelines().prewarm(std::move(builders)).get();
+  }
 }    // namespace gev::game
\ No newline at end of file
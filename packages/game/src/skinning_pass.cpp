@@ -0,0 +1,155 @@
+#include <array>
+#include <gev/descriptors.hpp>
+#include <gev/engine.hpp>
+#include <gev/game/skinning_pass.hpp>
+#include <gev/gpu_profiler.hpp>
+#include <gev/pipeline.hpp>
+#include <gev_game_shaders_files.hpp>
+
+namespace gev::game
+{
+  static void memory_barrier(vk::CommandBuffer c, vk::PipelineStageFlags2 src_stage, vk::AccessFlags2 src_access,
+    vk::PipelineStageFlags2 dst_stage, vk::AccessFlags2 dst_access)
+  {
+    vk::MemoryBarrier2 const barrier(src_stage, src_access, dst_stage, dst_access);
+    vk::DependencyInfo dep;
+    dep.setMemoryBarriers(barrier);
+    c.pipelineBarrier2(dep);
+  }
+
+  struct skinning_options
+  {
+    std::uint32_t source_first_vertex;
+    std::uint32_t target_first_vertex;
+    std::uint32_t vertex_count;
+    std::uint32_t joint_offset;
+  };
+
+  std::shared_ptr<mesh> const& skinned_instance::target() const
+  {
+    return _target;
+  }
+
+  void skinned_instance::set_palette(std::uint32_t offset)
+  {
+    _palette_offset = offset;
+  }
+
+  skinning_pass::skinning_pass()
+  {
+    _set_layout = gev::descriptor_layout_creator::get()
+                    .flags(vk::DescriptorSetLayoutCreateFlagBits::ePushDescriptorKHR)
+                    .bind(0, vk::DescriptorType::eStorageBuffer, vk::ShaderStageFlagBits::eCompute)
+                    .bind(1, vk::DescriptorType::eStorageBuffer, vk::ShaderStageFlagBits::eCompute)
+                    .bind(2, vk::DescriptorType::eStorageBuffer, vk::ShaderStageFlagBits::eCompute)
+                    .bind(3, vk::DescriptorType::eStorageBuffer, vk::ShaderStageFlagBits::eCompute)
+                    .build();
+
+    vk::PushConstantRange options_range;
+    options_range.offset = 0;
+    options_range.stageFlags = vk::ShaderStageFlagBits::eCompute;
+    options_range.size = sizeof(skinning_options);
+    _layout = gev::create_pipeline_layout(_set_layout.get(), options_range);
+
+    auto const shader = gev::create_shader(gev::load_spv(gev_game_shaders::shaders::skin_comp));
+    _pipeline = gev::build_compute_pipeline(_layout.get(), shader.get());
+  }
+
+  std::shared_ptr<skinned_instance> skinning_pass::add(std::shared_ptr<mesh> const& source)
+  {
+    auto instance = std::make_shared<skinned_instance>();
+    instance->_source = source;
+    instance->_target = mesh::make_skinning_target(source);
+    _instances.push_back(instance);
+    return instance;
+  }
+
+  void skinning_pass::initialize(vk::CommandBuffer c, skinned_instance& instance) const
+  {
+    // Texcoords are never skinned, positions and normals start out in the rest pose until a palette is set.
+    auto const arena = mesh_arena::defaults();
+    auto const& source = instance._source->range();
+    auto const& target = instance._target->range();
+    auto const copy = [&](gev::buffer const& buffer, std::size_t stride)
+    {
+      c.copyBuffer(buffer.get_buffer(), buffer.get_buffer(),
+        vk::BufferCopy(source.first_vertex * stride, target.first_vertex * stride, source.vertex_count * stride));
+    };
+    copy(*arena->position_buffer(), sizeof(rnu::vec4));
+    copy(*arena->normal_buffer(), sizeof(rnu::vec3));
+    copy(*arena->texcoords_buffer(), sizeof(rnu::vec2));
+    instance._initialized = true;
+  }
+
+  void skinning_pass::dispatch(vk::CommandBuffer c, joint_palette const& palette)
+  {
+    std::erase_if(_instances, [](std::weak_ptr<skinned_instance> const& i) { return i.expired(); });
+
+    // Sources become drawable once their upload completed, their targets follow in the same frame.
+    std::vector<std::shared_ptr<skinned_instance>> ready;
+    auto needs_init = false;
+    for (auto const& i : _instances)
+    {
+      auto instance = i.lock();
+      if (!instance->_source->is_uploaded())
+        continue;
+      needs_init |= !instance->_initialized;
+      ready.push_back(std::move(instance));
+    }
+    if (ready.empty())
+      return;
+
+    auto const scope = profile_gpu(c, "skinning_pass::dispatch");
+    auto const arena = mesh_arena::defaults();
+
+    // Earlier frames may still draw the previous results.
+    memory_barrier(c, vk::PipelineStageFlagBits2::eVertexAttributeInput | vk::PipelineStageFlagBits2::eComputeShader,
+      vk::AccessFlagBits2::eNone, vk::PipelineStageFlagBits2::eTransfer | vk::PipelineStageFlagBits2::eComputeShader,
+      vk::AccessFlagBits2::eNone);
+
+    if (needs_init)
+    {
+      for (auto const& instance : ready)
+      {
+        if (!instance->_initialized)
+          initialize(c, *instance);
+      }
+      memory_barrier(c, vk::PipelineStageFlagBits2::eTransfer, vk::AccessFlagBits2::eTransferWrite,
+        vk::PipelineStageFlagBits2::eComputeShader,
+        vk::AccessFlagBits2::eShaderStorageRead | vk::AccessFlagBits2::eShaderStorageWrite);
+    }
+
+    c.bindPipeline(vk::PipelineBindPoint::eCompute, _pipeline.get());
+    for (auto const& instance : ready)
+    {
+      if (instance->_palette_offset == skinned_instance::no_palette)
+        continue;
+
+      auto const& source = instance->_source->range();
+      auto const& target = instance->_target->range();
+      c.pushConstants<skinning_options>(_layout.get(), vk::ShaderStageFlagBits::eCompute, 0,
+        skinning_options{source.first_vertex, target.first_vertex, source.vertex_count, instance->_palette_offset});
+
+      vk::DescriptorBufferInfo const infos[] = {
+        vk::DescriptorBufferInfo(arena->position_buffer()->get_buffer(), 0, VK_WHOLE_SIZE),
+        vk::DescriptorBufferInfo(arena->normal_buffer()->get_buffer(), 0, VK_WHOLE_SIZE),
+        vk::DescriptorBufferInfo(arena->joints_buffer()->get_buffer(), 0, VK_WHOLE_SIZE),
+        vk::DescriptorBufferInfo(palette.buffer().get_buffer(), palette.frame_offset(), palette.region_size()),
+      };
+      std::array<vk::WriteDescriptorSet, std::size(infos)> writes;
+      for (std::uint32_t i = 0; i < writes.size(); ++i)
+      {
+        writes[i] =
+          vk::WriteDescriptorSet().setDstBinding(i).setDescriptorType(vk::DescriptorType::eStorageBuffer).setBufferInfo(
+            infos[i]);
+      }
+      c.pushDescriptorSetKHR(vk::PipelineBindPoint::eCompute, _layout.get(), 0, writes);
+      c.dispatch((source.vertex_count + group_size - 1) / group_size, 1, 1);
+    }
+
+    memory_barrier(c, vk::PipelineStageFlagBits2::eTransfer | vk::PipelineStageFlagBits2::eComputeShader,
+      vk::AccessFlagBits2::eTransferWrite | vk::AccessFlagBits2::eShaderStorageWrite,
+      vk::PipelineStageFlagBits2::eVertexAttributeInput | vk::PipelineStageFlagBits2::eComputeShader,
+      vk::AccessFlagBits2::eVertexAttributeRead | vk::AccessFlagBits2::eShaderStorageRead);
+  }
+}    // namespace gev::game
@@ -1,8 +1,10 @@
+#include <cstring>
+#include <gev/engine.hpp>
 #include <gev/game/sync_buffer.hpp>
 
 namespace gev::game
 {
-  sync_buffer::sync_buffer(std::size_t size, vk::BufferUsageFlags usage, std::size_t num_frames)
+  sync_buffer::sync_buffer(std::size_t size, vk::BufferUsageFlags usage)
     : _buffer(VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE, 0,
         vk::BufferCreateInfo()
           .setSharingMode(vk::SharingMode::eExclusive)
@@ -13,24 +15,32 @@ namespace gev::game
         vk::BufferCreateInfo()
           .setSharingMode(vk::SharingMode::eExclusive)
           .setUsage(vk::BufferUsageFlagBits::eTransferSrc)
-          .setSize(num_frames * size)),
-      _num_frames(num_frames)
+          .setSize(gev::engine::get().num_images() * size)),
+      _num_frames(gev::engine::get().num_images())
   {
   }
 
-  void sync_buffer::next_frame()
-  {
-    _current_frame = (_current_frame + 1) % _num_frames;
-  }
-
   void sync_buffer::sync(vk::CommandBuffer c)
   {
-    if (_dirty)
+    // Only the ranges loaded since the last sync are copied, the rest of the buffer keeps its contents.
+    if (_pending.empty())
+      return;
+
+    // Later loads of overlapping ranges overwrite earlier ones in the slice, so all copies see the latest data.
+    auto const slice = (gev::current_frame().frame_index % _num_frames) * _buffer.size();
+    _regions.clear();
+    for (auto const& p : _pending)
     {
-      _staging_buffer.copy_to(c, _buffer, _buffer.size(), _current_frame * _buffer.size(), 0u);
-      _dirty = false;
-      next_frame();
+      _staging_buffer.load_data(&_pending_data[p.data_offset], p.size, std::uint32_t(slice + p.offset));
+      _regions.push_back(vk::BufferCopy(slice + p.offset, p.offset, p.size));
     }
+    _pending.clear();
+    _pending_data.clear();
+
+    c.pipelineBarrier(vk::PipelineStageFlagBits::eHost, vk::PipelineStageFlagBits::eTransfer,
+      vk::DependencyFlagBits::eByRegion,
+      vk::MemoryBarrier(vk::AccessFlagBits::eHostWrite, vk::AccessFlagBits::eTransferRead), nullptr, nullptr);
+    c.copyBuffer(_staging_buffer.get_buffer(), _buffer.get_buffer(), _regions);
   }
 
   gev::buffer const& sync_buffer::buffer() const
@@ -50,7 +60,19 @@ namespace gev::game
 
   void sync_buffer::load_data(void const* data, std::uint32_t size, std::uint32_t offset)
   {
-    _staging_buffer.load_data(data, size, offset + _current_frame * _buffer.size());
-    _dirty = true;
+    if (size == 0)
+      return;
+
+    // Buffers that are loaded repeatedly without a sync, like whole uniform blocks, replace their last load.
+    if (!_pending.empty() && _pending.back().offset == offset && _pending.back().size == size)
+    {
+      std::memcpy(&_pending_data[_pending.back().data_offset], data, size);
+      return;
+    }
+
+    auto const data_offset = _pending_data.size();
+    _pending_data.resize(data_offset + size);
+    std::memcpy(&_pending_data[data_offset], data, size);
+    _pending.push_back(pending_load{data_offset, offset, size});
   }
-}    // namespace gev::game
\ No newline at end of file
+}    // namespace gev::game
@@ -4,6 +4,7 @@
 
 #define STB_IMAGE_IMPLEMENTATION
 #include <gev/engine.hpp>
+#include <gev/upload_manager.hpp>
 #include <ranges>
 #include <rnu/math/packing.hpp>
 #include <stb_image.h>
@@ -44,26 +45,7 @@ namespace gev::game
         .build();
     _texture_view = _texture->create_view(vk::ImageViewType::e2D);
 
-    auto const staging_buffer =
-      gev::buffer::host_local(width * height * components, vk::BufferUsageFlagBits::eTransferSrc);
-
-    staging_buffer->load_data<float const>(data);
-
-    gev::engine::get().execute_once([&](auto c)
-      { staging_buffer->copy_to(c, *_texture, vk::ImageAspectFlagBits::eColor); },
-      gev::engine::get().queues().graphics_command_pool.get(), true);
-
-    if (levels > 1)
-    {
-      gev::engine::get().execute_once(
-        [&](auto c)
-        {
-          _texture->generate_mipmaps(c);
-          _texture->layout(c, vk::ImageLayout::eShaderReadOnlyOptimal, vk::PipelineStageFlagBits2::eVertexShader,
-            vk::AccessFlagBits2::eShaderSampledRead);
-        },
-        gev::engine::get().queues().graphics_command_pool.get(), true);
-    }
+    upload(data.data(), data.size_bytes(), 1);
 
     _sampler = samplers::defaults().texture();
     _sampler_type = sampler_type::default_texture;
@@ -103,26 +85,7 @@ namespace gev::game
         .build();
     _texture_view = _texture->create_view(vk::ImageViewType::e2D);
 
-    auto const staging_buffer =
-      gev::buffer::host_local(width * height * components, vk::BufferUsageFlagBits::eTransferSrc);
-
-    staging_buffer->load_data<std::uint8_t const>(data);
-
-    gev::engine::get().execute_once([&](auto c)
-      { staging_buffer->copy_to(c, *_texture, vk::ImageAspectFlagBits::eColor); },
-      gev::engine::get().queues().graphics_command_pool.get(), true);
-
-    if (levels > 1)
-    {
-      gev::engine::get().execute_once(
-        [&](auto c)
-        {
-          _texture->generate_mipmaps(c);
-          _texture->layout(c, vk::ImageLayout::eShaderReadOnlyOptimal, vk::PipelineStageFlagBits2::eVertexShader,
-            vk::AccessFlagBits2::eShaderSampledRead);
-        },
-        gev::engine::get().queues().graphics_command_pool.get(), true);
-    }
+    upload(data.data(), data.size_bytes(), 1);
 
     _sampler = samplers::defaults().texture();
     _sampler_type = sampler_type::default_texture;
@@ -150,22 +113,7 @@ namespace gev::game
         .build();
     _texture_view = _texture->create_view(vk::ImageViewType::e2D);
 
-    auto const staging_buffer = gev::buffer::host_local(width * height * 4, vk::BufferUsageFlagBits::eTransferSrc);
-
-    staging_buffer->load_data<stbi_uc>(std::span{image_data.get(), std::size_t(width * height * 4)});
-
-    gev::engine::get().execute_once([&](auto c)
-      { staging_buffer->copy_to(c, *_texture, vk::ImageAspectFlagBits::eColor); },
-      gev::engine::get().queues().graphics_command_pool.get(), true);
-
-    gev::engine::get().execute_once(
-      [&](auto c)
-      {
-        _texture->generate_mipmaps(c);
-        _texture->layout(c, vk::ImageLayout::eShaderReadOnlyOptimal, vk::PipelineStageFlagBits2::eVertexShader,
-          vk::AccessFlagBits2::eShaderSampledRead);
-      },
-      gev::engine::get().queues().graphics_command_pool.get(), true);
+    upload(image_data.get(), std::size_t(width * height * 4), 1);
 
     _sampler = samplers::defaults().texture();
     _sampler_type = sampler_type::default_texture;
@@ -205,40 +153,57 @@ namespace gev::game
         .build();
     _texture_view = _texture->create_view(vk::ImageViewType::eCube);
 
-    gev::buffer staging_buffer(VMA_MEMORY_USAGE_AUTO_PREFER_HOST,
-      VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT,
-      vk::BufferCreateInfo()
-        .setSharingMode(vk::SharingMode::eExclusive)
-        .setSize(data.size() * sizeof(data[0]))
-        .setUsage(vk::BufferUsageFlagBits::eTransferSrc));
+    upload(data.data(), data.size() * sizeof(data[0]), 1);
 
-    staging_buffer.load_data<std::uint16_t>(data);
+    _sampler = samplers::defaults().cubemap();
+    _sampler_type = sampler_type::cubemap;
+  }
 
-    gev::engine::get().execute_once([&](auto c)
-      { staging_buffer.copy_to(c, *_texture, vk::ImageAspectFlagBits::eColor); },
-      gev::engine::get().queues().graphics_command_pool.get(), true);
+  void texture::upload(void const* data, std::size_t size, std::uint32_t num_levels)
+  {
+    std::uint32_t width = _texture->extent().width;
+    std::uint32_t height = _texture->extent().height;
+    auto const layers = _texture->array_layers();
 
-    gev::engine::get().execute_once(
-      [&](auto c)
+    std::vector<vk::BufferImageCopy> regions;
+    std::size_t offset = 0;
+    for (std::uint32_t mip = 0; mip < num_levels; ++mip)
+    {
+      regions.push_back(vk::BufferImageCopy()
+                          .setBufferOffset(offset)
+                          .setImageSubresource(vk::ImageSubresourceLayers(vk::ImageAspectFlagBits::eColor, mip, 0, layers))
+                          .setImageExtent(vk::Extent3D(std::max(width, 1u), std::max(height, 1u), 1)));
+
+      offset += width * height * layers * _texel_size;
+      width >>= 1;
+      height >>= 1;
+    }
+
+    bool const generate_mipmaps = num_levels < _texture->mip_levels();
+    _upload = gev::service<gev::upload_manager>()->upload(_texture, data, size, regions,
+      [img = _texture, generate_mipmaps](vk::CommandBuffer c)
       {
-        _texture->generate_mipmaps(c);
-        _texture->layout(c, vk::ImageLayout::eShaderReadOnlyOptimal, vk::PipelineStageFlagBits2::eVertexShader,
+        if (generate_mipmaps)
+          img->generate_mipmaps(c);
+        img->layout(c, vk::ImageLayout::eShaderReadOnlyOptimal,
+          vk::PipelineStageFlagBits2::eVertexShader | vk::PipelineStageFlagBits2::eFragmentShader,
           vk::AccessFlagBits2::eShaderSampledRead);
-      },
-      gev::engine::get().queues().graphics_command_pool.get(), true);
+      });
+  }
 
-    _sampler = samplers::defaults().cubemap();
-    _sampler_type = sampler_type::cubemap;
+  bool texture::is_uploaded() const
+  {
+    return gev::service<gev::upload_manager>()->is_complete(_upload);
   }
 
-  void texture::bind(vk::DescriptorSet set, std::uint32_t binding)
+  void texture::bind(vk::DescriptorSet set, std::uint32_t binding, std::uint32_t array_element)
   {
     gev::update_descriptor(set, binding,
       vk::DescriptorImageInfo()
         .setImageView(_texture_view.get())
         .setImageLayout(vk::ImageLayout::eShaderReadOnlyOptimal)
         .setSampler(_sampler),
-      vk::DescriptorType::eCombinedImageSampler);
+      vk::DescriptorType::eCombinedImageSampler, array_element);
   }
 
   gev::image const& texture::image() const
@@ -258,6 +223,7 @@ namespace gev::game
 
   void texture::serialize(serializer& base, std::ostream& out)
   {
+    gev::service<gev::upload_manager>()->wait(_upload);
     auto const buf = gev::buffer::host_local(_texture->size_bytes(), vk::BufferUsageFlagBits::eTransferDst);
 
     gev::engine::get().execute_once(
@@ -338,31 +304,6 @@ namespace gev::game
 
     assert(data.size() == _texture->size_bytes());
 
-    auto const buf = gev::buffer::host_local(data.size(), vk::BufferUsageFlagBits::eTransferSrc);
-    buf->load_data<char>(data);
-
-    gev::engine::get().execute_once(
-      [&](auto const& c)
-      {
-        _texture->layout(c, vk::ImageLayout::eTransferDstOptimal, vk::PipelineStageFlagBits2::eTransfer,
-          vk::AccessFlagBits2::eTransferWrite);
-
-        std::uint32_t width = size.width;
-        std::uint32_t height = size.height;
-
-        std::size_t offset = 0;
-        for (std::uint32_t mip = 0; mip < levels; ++mip)
-        {
-          buf->copy_to(c, *_texture, vk::ImageAspectFlagBits::eColor, mip, offset);
-
-          offset += width * height * layers * _texel_size;
-          width >>= 1;
-          height >>= 1;
-        }
-
-        _texture->layout(c, vk::ImageLayout::eShaderReadOnlyOptimal, vk::PipelineStageFlagBits2::eFragmentShader,
-          vk::AccessFlagBits2::eShaderSampledRead);
-      },
-      gev::engine::get().queues().transfer_command_pool.get(), true);
+    upload(data.data(), data.size(), levels);
   }
 }    // namespace gev::game
\ No newline at end of file
@@ -1,11 +1,16 @@
 #pragma once
 
 #include <any>
+#include <array>
 #include <chrono>
+#include <memory>
+#include <cstdint>
 #include <optional>
 #include <rnu/algorithm/smooth.hpp>
 #include <rnu/math/math.hpp>
 #include <span>
+#include <string>
+#include <unordered_map>
 #include <variant>
 #include <vector>
 #include <gev/res/serializer.hpp>
@@ -58,6 +63,8 @@ namespace gev::scenery
 
   class animation : public gev::serializable
   {
+    friend class animation_clip;
+
   public:
     animation() = default;
     animation(animation_target target, size_t node_index, std::vector<rnu::vec3> vec3_checkpoints,
@@ -65,8 +72,6 @@ namespace gev::scenery
     
     float duration() const;
 
-    void transform(float time, float mix_factor, std::vector<transform_node>& nodes) const;
-
     void serialize(serializer& base, std::ostream& out) override;
     void deserialize(serializer& base, std::istream& in) override;
 
@@ -78,29 +83,92 @@ namespace gev::scenery
     std::vector<float> _timestamps;
   };
 
-  class joint_animation : public gev::serializable
+  // Per instance state for sampling an animation_clip. The cursors remember the current keyframe of every track, the
+  // lanes hold the gathered values while they are interpolated.
+  struct animation_cursor
+  {
+    std::vector<std::uint32_t> vec3_keys;
+    std::vector<std::uint32_t> quat_keys;
+    std::vector<float> vec3_lanes;
+    std::vector<float> quat_lanes;
+  };
+
+  // Keys that linear interpolation between their quantized neighbours reproduces within these tolerances are dropped
+  // when a clip is compiled. Rotation errors are measured per quaternion component. Sampling a compiled clip at a key
+  // time is off by at most the tolerance, or by the quantization error where that is larger.
+  struct animation_compression
+  {
+    float location_tolerance = 1e-4f;
+    float rotation_tolerance = 1e-4f;
+    float scale_tolerance = 1e-4f;
+  };
+
+  // The channels of a clip compiled into flat arrays, split by value type. Vec3 keys are stored as 16 bit values
+  // normalized to the range of their track, rotations in smallest three encoding with 15 bits per component. Tracks
+  // with equal key times share them. Sampling first finds and decodes the keyframes of all tracks, then interpolates
+  // all tracks of one type together in structure of arrays layout.
+  class animation_clip
   {
   public:
-    struct anim_info
+    using packed_key = std::array<std::uint16_t, 3>;
+
+    struct track
     {
-      std::vector<animation> animation;
-      bool one_shot;
+      std::uint32_t node;
+      animation_target target;
+      std::uint32_t first_key;
+      std::uint32_t first_time;
+      std::uint32_t num_keys;
+      // Decoding range of vec3 keys.
+      rnu::vec3 offset;
+      rnu::vec3 extent;
     };
 
-    void set(std::vector<animation> anim, bool one_shot = true);
+    animation_clip() = default;
+    animation_clip(std::span<animation const> channels, animation_compression const& compression = {});
+
+    float duration() const;
+    // Keyframe lookup is amortized constant while the time only moves forward between calls.
+    void sample(float time, float mix_factor, animation_cursor& cursor, std::span<transform> locals) const;
+
+    void serialize(std::ostream& out) const;
+    void deserialize(std::istream& in);
+
+  private:
+    std::uint32_t share_times(std::span<float const> times);
+    // Samples the clip at all key times of the source channels and checks the keys against the error bound.
+    bool reproduces(std::span<animation const> channels, animation_compression const& compression) const;
+
+    std::vector<float> _times;
+
+    std::vector<track> _vec3_tracks;
+    std::vector<packed_key> _vec3_keys;
+
+    std::vector<track> _quat_tracks;
+    std::vector<packed_key> _quat_keys;
+
+    float _duration = 0.0f;
+  };
+
+  // Playback state of a clip. The compiled clip itself is immutable and shared between copies.
+  class joint_animation : public gev::serializable
+  {
+  public:
+    void set(std::vector<animation> anim, bool one_shot = true, animation_compression const& compression = {});
 
     void start(double offset = 0.0f);
 
-    void update(std::chrono::duration<double> d, std::vector<transform_node>& nodes);
+    void update(std::chrono::duration<double> d, std::span<transform> locals);
 
     void serialize(serializer& base, std::ostream& out) override;
     void deserialize(serializer& base, std::istream& in) override;
 
   private:
-    anim_info _anim;
+    std::shared_ptr<animation_clip const> _clip = std::make_shared<animation_clip>();
+    animation_cursor _cursor;
+    bool _one_shot = true;
     size_t _current;
     double _time = 0;
-    float _longest_duration = 0.0f;
     rnu::smooth<double> _ramp_up;
   };
 
@@ -110,7 +178,6 @@ namespace gev::scenery
     transform_tree() = default;
     transform_tree(std::vector<transform_node> nodes);
 
-    void animate(joint_animation& animation, std::chrono::duration<double> delta);
     rnu::mat4 const& global_transform(size_t node) const;
     std::span<transform_node const> nodes() const;
     void serialize(serializer& base, std::ostream& out) override;
@@ -123,6 +190,22 @@ namespace gev::scenery
     std::vector<rnu::mat4> _global_matrices;
   };
 
+  // Local and global transforms of one animated instance of a transform_tree.
+  class skeleton_pose
+  {
+  public:
+    skeleton_pose() = default;
+    skeleton_pose(transform_tree const& rest_pose);
+
+    void animate(transform_tree const& tree, joint_animation& animation, std::chrono::duration<double> delta);
+    transform const& local_transform(size_t node) const;
+    rnu::mat4 const& global_transform(size_t node) const;
+
+  private:
+    std::vector<transform> _locals;
+    std::vector<rnu::mat4> _globals;
+  };
+
   class skin : public serializable
   {
   public:
@@ -136,8 +219,8 @@ namespace gev::scenery
 
     std::uint32_t root_node() const;
 
-    std::vector<rnu::mat4>& apply_global_transforms(transform_tree const& tree);
-    
+    void apply_global_transforms(skeleton_pose const& pose, std::vector<rnu::mat4>& palette) const;
+
     void serialize(serializer& base, std::ostream& out) override;
     void deserialize(serializer& base, std::istream& in) override;
 
@@ -145,6 +228,26 @@ namespace gev::scenery
     size_t _root_node;
     std::vector<std::uint32_t> _joint_nodes;
     std::vector<rnu::mat4> _joint_matrices;
-    std::vector<rnu::mat4> _global_joint_matrices;
+  };
+
+  // The parts of a skinned rig that do not change at runtime. All instances of the rig share one skeleton and only keep
+  // their own skeleton_pose and joint_animation.
+  class skeleton : public serializable
+  {
+  public:
+    skeleton() = default;
+    skeleton(skin joints, transform_tree rest_pose, std::unordered_map<std::string, joint_animation> animations);
+
+    skin const& joints() const;
+    transform_tree const& rest_pose() const;
+    std::unordered_map<std::string, joint_animation> const& animations() const;
+
+    void serialize(serializer& base, std::ostream& out) override;
+    void deserialize(serializer& base, std::istream& in) override;
+
+  private:
+    skin _joints;
+    transform_tree _rest_pose;
+    std::unordered_map<std::string, joint_animation> _animations;
   };
 }    // namespace gev::scenery
\ No newline at end of file
@@ -222,7 +222,6 @@ namespace gev::scenery
     void activate() override;
     void deactivate() override;
     void set_shape(std::shared_ptr<collision_shape> shape);
-    void fixed_update(double time, double delta) override;
     void update() override;
     rnu::vec3 get_velocity() const;
     void set_velocity(float x, float y, float z);
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <array>
+#include <gev/scenery/component_phase.hpp>
 #include <gev/scenery/entity.hpp>
 #include <gev/res/serializer.hpp>
 #include <memory>
@@ -9,6 +11,7 @@ namespace gev::scenery
   class component : public std::enable_shared_from_this<component>, public serializable
   {
     friend class entity;
+    friend class entity_manager;
 
   public:
     virtual ~component() = default;
@@ -42,5 +45,10 @@ namespace gev::scenery
   private:
     std::weak_ptr<entity> _parent;
     bool _active = true;
+    // Position in the entity_manager's list of each phase, ~0u if not subscribed.
+    std::array<std::uint32_t, num_component_phases> _phase_slots = {~0u, ~0u, ~0u, ~0u};
+    bool _parallel = false;
+    // Position in the entity_manager's list of components of the same type.
+    std::uint32_t _type_slot = ~0u;
   };
 }    // namespace gev::scenery
\ No newline at end of file
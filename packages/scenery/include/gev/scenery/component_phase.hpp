@@ -0,0 +1,77 @@
+#pragma once
+
+#include <concepts>
+#include <cstdint>
+#include <type_traits>
+#include <typeinfo>
+
+namespace gev::scenery
+{
+  class component;
+
+  enum class component_phase : std::uint32_t
+  {
+    early_update,
+    fixed_update,
+    update,
+    late_update
+  };
+
+  constexpr std::size_t num_component_phases = 4;
+
+  using phase_mask = std::uint32_t;
+  constexpr phase_mask all_phases = (1u << num_component_phases) - 1;
+
+  constexpr phase_mask phase_bit(component_phase phase)
+  {
+    return 1u << std::uint32_t(phase);
+  }
+
+  // A phase counts as implemented if the type or one of its bases below component declares it.
+  template<typename T>
+  constexpr phase_mask detect_phases()
+  {
+    phase_mask result = 0;
+    if constexpr (!std::is_same_v<decltype(&T::early_update), void (component::*)()>)
+      result |= phase_bit(component_phase::early_update);
+    if constexpr (!std::is_same_v<decltype(&T::fixed_update), void (component::*)(double, double)>)
+      result |= phase_bit(component_phase::fixed_update);
+    if constexpr (!std::is_same_v<decltype(&T::update), void (component::*)()>)
+      result |= phase_bit(component_phase::update);
+    if constexpr (!std::is_same_v<decltype(&T::late_update), void (component::*)()>)
+      result |= phase_bit(component_phase::late_update);
+    return result;
+  }
+
+  // Components opt into running on worker threads with a static constexpr bool parallel_safe = true member. Their
+  // phases may then only touch the component and its own entity's transform, and must not create, destroy or reparent
+  // entities or add and remove components.
+  template<typename T>
+  constexpr bool detect_parallel_safe()
+  {
+    if constexpr (requires {
+                    { T::parallel_safe } -> std::convertible_to<bool>;
+                  })
+      return T::parallel_safe;
+    else
+      return false;
+  }
+
+  struct component_traits
+  {
+    phase_mask phases = all_phases;
+    bool parallel_safe = false;
+  };
+
+  void register_component_traits(std::type_info const& type, component_traits traits);
+  // Types that were never registered are subscribed to all phases and run on the main thread.
+  component_traits traits_of(std::type_info const& type);
+
+  // Component types created through a serializer should be registered up front, entity::emplace registers its type
+  // on its own.
+  template<typename T>
+  void register_component()
+  {
+    register_component_traits(typeid(T), component_traits{detect_phases<T>(), detect_parallel_safe<T>()});
+  }
+}    // namespace gev::scenery
@@ -0,0 +1,251 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <gev/scenery/parallel_executor.hpp>
+#include <memory>
+#include <span>
+#include <tuple>
+#include <typeinfo>
+#include <unordered_map>
+#include <vector>
+
+namespace gev::scenery
+{
+  class entity;
+
+  using entity_index = std::uint32_t;
+  constexpr entity_index invalid_entity_index = ~0u;
+
+  class component_pool_base
+  {
+  public:
+    virtual ~component_pool_base() = default;
+
+    virtual void remove(entity_index e) = 0;
+    virtual bool contains(entity_index e) const = 0;
+    virtual std::size_t size() const = 0;
+  };
+
+  // A sparse set: the components are stored densely, the sparse array maps entity indices to their position. Removal
+  // swaps the last component into the gap, so references are only stable until the pool is modified.
+  template<typename T>
+  class component_pool : public component_pool_base
+  {
+  public:
+    template<typename... Args>
+    T& emplace(entity_index e, Args&&... args)
+    {
+      if (e >= _sparse.size())
+        _sparse.resize(e + 1, invalid_entity_index);
+
+      if (auto const dense = _sparse[e]; dense != invalid_entity_index)
+      {
+        _data[dense] = T(std::forward<Args>(args)...);
+        return _data[dense];
+      }
+
+      _sparse[e] = std::uint32_t(_data.size());
+      _entities.push_back(e);
+      return _data.emplace_back(std::forward<Args>(args)...);
+    }
+
+    void remove(entity_index e) override
+    {
+      if (!contains(e))
+        return;
+
+      auto const dense = _sparse[e];
+      auto const last = std::uint32_t(_data.size() - 1);
+      if (dense != last)
+      {
+        _data[dense] = std::move(_data[last]);
+        _entities[dense] = _entities[last];
+        _sparse[_entities[dense]] = dense;
+      }
+      _data.pop_back();
+      _entities.pop_back();
+      _sparse[e] = invalid_entity_index;
+    }
+
+    bool contains(entity_index e) const override
+    {
+      return e < _sparse.size() && _sparse[e] != invalid_entity_index;
+    }
+
+    std::size_t size() const override
+    {
+      return _data.size();
+    }
+
+    T* find(entity_index e)
+    {
+      return contains(e) ? &_data[_sparse[e]] : nullptr;
+    }
+
+    T& get(entity_index e)
+    {
+      return _data[_sparse[e]];
+    }
+
+    std::span<T> data()
+    {
+      return _data;
+    }
+
+    std::span<entity_index const> entities() const
+    {
+      return _entities;
+    }
+
+  private:
+    std::vector<entity_index> _sparse;
+    std::vector<entity_index> _entities;
+    std::vector<T> _data;
+  };
+
+  class component_store
+  {
+  public:
+    template<typename T>
+    component_pool<T>& pool()
+    {
+      auto& p = _pools[typeid(T).hash_code()];
+      if (!p)
+        p = std::make_unique<component_pool<T>>();
+      return static_cast<component_pool<T>&>(*p);
+    }
+
+    template<typename T>
+    component_pool<T>* find_pool() const
+    {
+      auto const iter = _pools.find(typeid(T).hash_code());
+      if (iter == _pools.end())
+        return nullptr;
+      return static_cast<component_pool<T>*>(iter->second.get());
+    }
+
+    void remove_all(entity_index e)
+    {
+      for (auto const& [type, p] : _pools)
+        p->remove(e);
+    }
+
+  private:
+    std::unordered_map<std::size_t, std::unique_ptr<component_pool_base>> _pools;
+  };
+
+  // Iterates all entities that have every one of the components. The smallest pool drives the iteration, a view with a
+  // single component walks its pool linearly. Adding or removing components of the viewed types while iterating is not
+  // allowed.
+  template<typename... Ts>
+  class component_view
+  {
+  public:
+    component_view(std::span<entity* const> entities, component_pool<Ts>*... pools)
+      : _entities(entities),
+        _pools(pools...)
+    {
+    }
+
+    template<typename Func>
+    void each(Func&& func) const
+    {
+      if (!std::apply([](auto*... p) { return (p && ...); }, _pools))
+        return;
+
+      if constexpr (sizeof...(Ts) == 1)
+      {
+        auto& pool = *std::get<0>(_pools);
+        auto const entities = pool.entities();
+        auto const data = pool.data();
+        for (std::size_t i = 0; i < data.size(); ++i)
+          func(*_entities[entities[i]], data[i]);
+      }
+      else
+      {
+        for (auto const e : driver())
+        {
+          std::apply(
+            [&](auto*... p)
+            {
+              if ((p->contains(e) && ...))
+                func(*_entities[e], p->get(e)...);
+            },
+            _pools);
+        }
+      }
+    }
+
+    // Like each, but batches may run on several threads. Without an executor everything runs on the calling thread.
+    template<typename Func>
+    void parallel_each(parallel_executor const& executor, Func&& func) const
+    {
+      if (!executor)
+        return each(std::forward<Func>(func));
+      if (!std::apply([](auto*... p) { return (p && ...); }, _pools))
+        return;
+
+      if constexpr (sizeof...(Ts) == 1)
+      {
+        auto& pool = *std::get<0>(_pools);
+        auto const entities = pool.entities();
+        auto const data = pool.data();
+        executor(data.size(),
+          [&](std::size_t begin, std::size_t end)
+          {
+            for (auto i = begin; i < end; ++i)
+              func(*_entities[entities[i]], data[i]);
+          });
+      }
+      else
+      {
+        auto const entities = driver();
+        executor(entities.size(),
+          [&](std::size_t begin, std::size_t end)
+          {
+            for (auto const e : entities.subspan(begin, end - begin))
+            {
+              std::apply(
+                [&](auto*... p)
+                {
+                  if ((p->contains(e) && ...))
+                    func(*_entities[e], p->get(e)...);
+                },
+                _pools);
+            }
+          });
+      }
+    }
+
+    std::size_t size_hint() const
+    {
+      return driver().size();
+    }
+
+  private:
+    std::span<entity_index const> driver() const
+    {
+      std::span<entity_index const> smallest;
+      auto first = true;
+      std::apply(
+        [&](auto*... p)
+        {
+          (
+            [&]
+            {
+              auto const entities = p ? p->entities() : std::span<entity_index const>{};
+              if (first || entities.size() < smallest.size())
+                smallest = entities;
+              first = false;
+            }(),
+            ...);
+        },
+        _pools);
+      return smallest;
+    }
+
+    std::span<entity* const> _entities;
+    std::tuple<component_pool<Ts>*...> _pools;
+  };
+}    // namespace gev::scenery
@@ -1,6 +1,9 @@
 #pragma once
 
+#include <gev/scenery/component_phase.hpp>
+#include <gev/scenery/component_store.hpp>
 #include <gev/scenery/transform.hpp>
+#include <gev/scenery/transform_hierarchy.hpp>
 #include <gev/res/serializer.hpp>
 #include <gev/res/virtual_enable_shared_from_this.hpp>
 #include <memory>
@@ -17,8 +20,6 @@ namespace gev::scenery
     friend class entity_manager;
 
   public:
-    transform local_transform;
-
     entity() = default;
 
     entity(std::size_t id);
@@ -38,6 +39,7 @@ namespace gev::scenery
     template<typename T, typename... Args>
     std::shared_ptr<T> emplace(Args&&... args)
     {
+      register_component<T>();
       auto component = std::make_shared<T>(std::forward<Args>(args)...);
       add(component);
       return component;
@@ -74,14 +76,24 @@ namespace gev::scenery
 
     void erase(std::shared_ptr<component> comp);
 
+    // Dense components are plain data kept in the manager's component store for cache friendly iteration with
+    // entity_manager::view. They are not serialized and the entity has to belong to a manager. Defined in
+    // entity_manager.hpp.
+    template<typename T, typename... Args>
+    T& attach(Args&&... args);
+    template<typename T>
+    T* attached() const;
+    template<typename T>
+    void detach();
+
     std::size_t id() const;
+    entity_index index() const;
     void spawn() const;
     void despawn() const;
     void early_update() const;
     void update() const;
     void fixed_update(double time, double delta) const;
     void late_update() const;
-    void apply_transform();
     void set_active(bool active);
     bool is_inherited_active() const;
     bool is_active() const;
@@ -92,7 +104,14 @@ namespace gev::scenery
 
     std::span<std::shared_ptr<entity> const> children() const;
 
+    transform const& local_transform() const;
+    void set_local_transform(transform const& t);
+    // Marks the local transform as changed, the reference is only valid until the next structural change.
+    transform& edit_local_transform();
+    // Up to date as of the last entity_manager::apply_transform. Entities outside of a manager have no parent, their
+    // global transform is the local one.
     transform const& global_transform() const;
+    std::uint64_t transform_version() const;
 
     std::shared_ptr<entity> parent() const;
 
@@ -101,12 +120,17 @@ namespace gev::scenery
   private:
     void activate(bool propagate_to_children = true) const;
     void deactivate() const;
+    void refresh_inherited_active();
 
     std::size_t _id;
+    entity_index _index = invalid_entity_index;
     std::weak_ptr<entity> _parent;
     bool _active = true;
+    bool _inherited_active = true;
 
-    transform _global_transform;
+    // Only used while the entity does not belong to a manager, the hierarchy owns the transforms otherwise.
+    transform _local_transform;
+    transform_hierarchy* _transforms = nullptr;
     std::vector<std::shared_ptr<component>> _components;
     std::vector<std::shared_ptr<entity>> _children;
     std::weak_ptr<entity_manager> _manager;
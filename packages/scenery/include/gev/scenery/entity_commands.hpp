@@ -0,0 +1,62 @@
+#pragma once
+
+#include <gev/scenery/component_phase.hpp>
+#include <memory>
+#include <vector>
+
+namespace gev::scenery
+{
+  class component;
+  class entity;
+  class entity_manager;
+
+  // Records structural changes during the update phases, the entity_manager plays them back at its next sync point.
+  // Every thread has its own buffer, see entity_manager::commands. Instantiated entities and emplaced components can be
+  // set up right away, they only become part of the scene on playback.
+  class entity_commands
+  {
+    friend class entity_manager;
+
+  public:
+    std::shared_ptr<entity> instantiate(std::shared_ptr<entity> parent = nullptr);
+    std::shared_ptr<entity> instantiate(std::size_t id, std::shared_ptr<entity> parent = nullptr);
+    void destroy(std::shared_ptr<entity> e);
+    void reparent(std::shared_ptr<entity> target, std::shared_ptr<entity> new_parent = nullptr);
+
+    void add(std::shared_ptr<entity> target, std::shared_ptr<component> c);
+    void erase(std::shared_ptr<entity> target, std::shared_ptr<component> c);
+
+    template<typename T, typename... Args>
+    std::shared_ptr<T> emplace(std::shared_ptr<entity> target, Args&&... args)
+    {
+      register_component<T>();
+      auto component = std::make_shared<T>(std::forward<Args>(args)...);
+      add(std::move(target), component);
+      return component;
+    }
+
+    bool empty() const;
+
+  private:
+    enum class command_type
+    {
+      instantiate,
+      destroy,
+      reparent,
+      add,
+      erase
+    };
+
+    struct command
+    {
+      command_type type;
+      std::shared_ptr<entity> target;
+      std::shared_ptr<entity> parent;
+      std::shared_ptr<component> c;
+    };
+
+    void playback(entity_manager& manager, bool spawn);
+
+    std::vector<command> _commands;
+  };
+}    // namespace gev::scenery
@@ -1,13 +1,39 @@
 #pragma once
 
+#include <array>
+#include <functional>
+#include <gev/scenery/component_phase.hpp>
+#include <gev/scenery/component_store.hpp>
 #include <gev/scenery/entity.hpp>
+#include <gev/scenery/entity_commands.hpp>
+#include <gev/scenery/transform_hierarchy.hpp>
+#include <mutex>
 #include <span>
+#include <stdexcept>
+#include <thread>
+#include <typeinfo>
+#include <unordered_map>
 
 namespace gev::scenery
 {
+  enum class system_phase
+  {
+    early_update,
+    update,
+    late_update
+  };
+
   class entity_manager : public std::enable_shared_from_this<entity_manager>
   {
+    friend class entity;
+
   public:
+    using system = std::function<void()>;
+
+    // Parallel safe components of a phase only go to the executor from this many subscribers on.
+    constexpr static std::size_t parallel_threshold = 64;
+
+    // Structural changes apply immediately. While the update phases run, use commands() instead.
     std::shared_ptr<entity> instantiate(std::shared_ptr<entity> parent = nullptr);
     void add(std::shared_ptr<entity> existing, std::shared_ptr<entity> parent = nullptr);
     std::shared_ptr<entity> instantiate(std::size_t id, std::shared_ptr<entity> parent = nullptr);
@@ -20,21 +46,132 @@ namespace gev::scenery
 
     void destroy(std::shared_ptr<entity> e);
 
-    void spawn() const;
+    void spawn();
     void despawn();
-    void early_update() const;
-    void fixed_update(double time, double delta) const;
-    void update() const;
-    void late_update() const;
-    void apply_transform() const;
+    // The update phases only call the active components that implement them. Parallel safe components run first and in
+    // batches on the executor, the others follow on the calling thread in the order they were added.
+    void early_update();
+    void fixed_update(double time, double delta);
+    void update();
+    void late_update();
+    // Recomputes the global transforms of all entities whose local transform or parent changed since the last call.
+    void apply_transform();
+    // Used to spread large updates over several threads, everything runs on the calling thread without one.
+    void set_executor(parallel_executor executor);
+    parallel_executor const& executor() const;
+    // Ids do not have to be unique, any entity with the id is returned then.
     std::shared_ptr<entity> find_by_id(std::size_t id);
 
+    // Calls func(entity&, T&) for every active or inactive component of exactly the type T, in no particular order.
+    // Components must not be added or erased while iterating.
+    template<typename T, typename Func>
+    void each_with(Func&& func) const
+    {
+      auto const members = members_of(typeid(T));
+      for (auto const& m : members)
+        func(*m.owner, static_cast<T&>(*m.c));
+    }
+
+    template<typename T>
+    std::size_t count_with() const
+    {
+      return members_of(typeid(T)).size();
+    }
+
+    // The command buffer of the calling thread. All buffers are played back by flush_commands, which the engine calls
+    // once per frame after late_update. Entities instantiated through it are spawned on playback once spawn() ran.
+    entity_commands& commands();
+    void flush_commands();
+
+    // Systems run after the components of their phase and usually iterate views over dense components, which can use
+    // component_view::parallel_each with executor() for data they own exclusively.
+    void add_system(system_phase phase, system s);
+
+    template<typename... Ts>
+    component_view<Ts...> view()
+    {
+      return component_view<Ts...>(_entities, _components.find_pool<Ts>()...);
+    }
+
+    component_store& components();
+
   private:
     void assign_manager_impl(std::shared_ptr<entity> existing);
+    void register_entity(entity& e);
+    void unregister_entity(entity& e);
+    void run_systems(system_phase phase) const;
+    struct phase_subscriber;
+    std::span<phase_subscriber const> members_of(std::type_info const& type) const;
+    void subscribe(component& c, entity& owner);
+    void unsubscribe(component& c);
+    template<typename Func>
+    void run_phase(component_phase phase, Func&& func);
+    struct phase_list;
+    void compact(phase_list& list, component_phase phase);
 
     void remove_from_parent(std::shared_ptr<entity> const& target);
     void add_to_parent(std::shared_ptr<entity> const& target, std::shared_ptr<entity> parent = nullptr);
 
     std::vector<std::shared_ptr<entity>> _root_entities;
+
+    component_store _components;
+    transform_hierarchy _transforms;
+    parallel_executor _executor;
+    std::vector<entity*> _entities;
+    std::vector<entity_index> _free_indices;
+    std::array<std::vector<system>, 3> _systems;
+    bool _spawned = false;
+
+    std::mutex _commands_mutex;
+    std::vector<std::pair<std::thread::id, std::unique_ptr<entity_commands>>> _commands;
+
+    struct phase_subscriber
+    {
+      component* c;
+      entity* owner;
+    };
+
+    std::unordered_multimap<std::size_t, entity*> _entities_by_id;
+    std::unordered_map<std::size_t, std::vector<phase_subscriber>> _components_by_type;
+
+    // Unsubscribing leaves a hole that is compacted before the next run, so that the lists can change mid-phase.
+    struct phase_list
+    {
+      std::vector<phase_subscriber> subscribers;
+      bool holes = false;
+    };
+
+    // The first list of every phase runs on the calling thread, the second one holds the parallel safe components.
+    std::array<std::array<phase_list, 2>, num_component_phases> _phase_lists;
+    std::uint32_t _running_phases = 0;
   };
-}    // namespace gev::scenery
\ No newline at end of file
+
+  template<typename T, typename... Args>
+  T& entity::attach(Args&&... args)
+  {
+    auto const m = manager();
+    if (!m || _index == invalid_entity_index)
+      throw std::runtime_error("Dense components can only be attached to entities of an entity_manager.");
+    return m->components().pool<T>().emplace(_index, std::forward<Args>(args)...);
+  }
+
+  template<typename T>
+  T* entity::attached() const
+  {
+    auto const m = manager();
+    if (!m || _index == invalid_entity_index)
+      return nullptr;
+    auto const pool = m->components().find_pool<T>();
+    return pool ? pool->find(_index) : nullptr;
+  }
+
+  template<typename T>
+  void entity::detach()
+  {
+    auto const m = manager();
+    if (!m || _index == invalid_entity_index)
+      return;
+    if (auto const pool = m->components().find_pool<T>())
+      pool->remove(_index);
+  }
+}    // namespace gev::scenery
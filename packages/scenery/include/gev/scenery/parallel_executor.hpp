@@ -0,0 +1,11 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+
+namespace gev::scenery
+{
+  // Runs func over [0, count) in batches, possibly on several threads, and returns when all batches are done.
+  using parallel_executor =
+    std::function<void(std::size_t count, std::function<void(std::size_t begin, std::size_t end)> const& func)>;
+}    // namespace gev::scenery
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <gev/scenery/component_store.hpp>
+#include <gev/scenery/parallel_executor.hpp>
+#include <gev/scenery/transform.hpp>
+#include <vector>
+
+namespace gev::scenery
+{
+  // Local and global transforms of all entities of a manager in flat arrays. Nodes are sorted by depth, so every parent
+  // comes before its children and all nodes of one depth can be updated in parallel. Only nodes whose local transform
+  // or parent changed are recomputed.
+  class transform_hierarchy
+  {
+  public:
+    constexpr static std::size_t parallel_threshold = 4096;
+
+    void insert(entity_index e, transform const& local);
+    void erase(entity_index e);
+    void set_parent(entity_index e, entity_index parent);
+
+    // Setting local transforms of different entities from several threads at once is allowed.
+    void set_local(entity_index e, transform const& local);
+    transform& edit_local(entity_index e);
+    transform const& local(entity_index e) const;
+    transform const& global(entity_index e) const;
+    // Incremented whenever the global transform of the entity changes.
+    std::uint64_t version(entity_index e) const;
+
+    bool dirty() const;
+    void update(parallel_executor const& executor = {});
+
+  private:
+    void mark_dirty(std::uint32_t position);
+    void sort();
+    void update_range(std::size_t begin, std::size_t end);
+
+    constexpr static std::uint32_t no_position = ~0u;
+
+    std::vector<std::uint32_t> _positions;
+
+    std::vector<entity_index> _entities;
+    std::vector<entity_index> _parents;
+    std::vector<std::uint32_t> _parent_positions;
+    std::vector<transform> _locals;
+    std::vector<transform> _globals;
+    std::vector<std::uint64_t> _versions;
+    std::vector<std::uint64_t> _updated;
+    std::vector<std::uint8_t> _dirty;
+
+    // Start of every depth in the sorted arrays, plus the end.
+    std::vector<std::uint32_t> _levels;
+    bool _unsorted = false;
+    std::atomic<std::uint32_t> _first_dirty = no_position;
+    std::uint64_t _pass = 0;
+  };
+}    // namespace gev::scenery
@@ -1,7 +1,163 @@
+#include <algorithm>
+#include <cassert>
+#include <cmath>
 #include <gev/scenery/animation.hpp>
 
 namespace gev::scenery
 {
+  namespace
+  {
+    // Moves the cursor to the last key at or before the time and returns the interpolation factor towards the next one.
+    float advance(std::span<float const> times, float time, std::uint32_t& cursor)
+    {
+      auto const clamped = std::clamp(time, times.front(), times.back());
+      if (cursor >= times.size() || times[cursor] > clamped)
+        cursor = 0;
+
+      if (cursor + 1 < times.size() && times[cursor + 1] <= clamped)
+      {
+        // Usually the time only moved on to the next key, search the rest only after a jump.
+        ++cursor;
+        if (cursor + 1 < times.size() && times[cursor + 1] <= clamped)
+        {
+          auto const next = std::upper_bound(times.begin() + cursor + 1, times.end(), clamped);
+          cursor = std::uint32_t(std::distance(times.begin(), next) - 1);
+        }
+      }
+
+      if (cursor + 1 >= times.size())
+        return 0.0f;
+      return (clamped - times[cursor]) / (times[cursor + 1] - times[cursor]);
+    }
+
+    // Assets from before clips were compiled start with a plain one shot bool followed by the raw channels.
+    constexpr std::uint8_t compiled_clip_flag = 2;
+
+    // Smallest three components of a unit quaternion lie within this range.
+    constexpr float quat_component_range = 0.70710678f;
+
+    animation_clip::packed_key pack_vec3(rnu::vec3 const& v, rnu::vec3 const& offset, rnu::vec3 const& extent)
+    {
+      auto const quantize = [](float x, float o, float e)
+      { return std::uint16_t(e == 0.0f ? 0 : std::lround(std::clamp((x - o) / e, 0.0f, 1.0f) * 65535.0f)); };
+      return {quantize(v.x, offset.x, extent.x), quantize(v.y, offset.y, extent.y), quantize(v.z, offset.z, extent.z)};
+    }
+
+    rnu::vec3 unpack_vec3(animation_clip::packed_key const& k, rnu::vec3 const& offset, rnu::vec3 const& extent)
+    {
+      return rnu::vec3(offset.x + extent.x * (k[0] / 65535.0f), offset.y + extent.y * (k[1] / 65535.0f),
+        offset.z + extent.z * (k[2] / 65535.0f));
+    }
+
+    // The index of the dropped largest component goes into the top bits of the first two values.
+    animation_clip::packed_key pack_quat(rnu::quat const& q)
+    {
+      float const c[4] = {q.w, q.x, q.y, q.z};
+      std::size_t largest = 0;
+      for (std::size_t i = 1; i < 4; ++i)
+      {
+        if (std::abs(c[i]) > std::abs(c[largest]))
+          largest = i;
+      }
+
+      auto const sign = c[largest] < 0.0f ? -1.0f : 1.0f;
+      std::array<std::uint16_t, 3> v{};
+      for (std::size_t i = 0, j = 0; i < 4; ++i)
+      {
+        if (i == largest)
+          continue;
+        auto const normalized = std::clamp(sign * c[i] / quat_component_range, -1.0f, 1.0f);
+        v[j++] = std::uint16_t(std::lround((normalized * 0.5f + 0.5f) * 32767.0f));
+      }
+      return {std::uint16_t(v[0] | ((largest >> 1) << 15)), std::uint16_t(v[1] | ((largest & 1) << 15)), v[2]};
+    }
+
+    rnu::quat unpack_quat(animation_clip::packed_key const& k)
+    {
+      auto const largest = std::size_t(((k[0] >> 15) << 1) | (k[1] >> 15));
+      float c[4]{};
+      float sum = 0.0f;
+      for (std::size_t i = 0, j = 0; i < 4; ++i)
+      {
+        if (i == largest)
+          continue;
+        c[i] = ((k[j++] & 0x7fff) / 32767.0f * 2.0f - 1.0f) * quat_component_range;
+        sum += c[i] * c[i];
+      }
+      c[largest] = std::sqrt(std::max(0.0f, 1.0f - sum));
+      return rnu::quat(c[0], c[1], c[2], c[3]);
+    }
+
+    rnu::quat nlerp(rnu::quat const& a, rnu::quat b, float t)
+    {
+      if (a.w * b.w + a.x * b.x + a.y * b.y + a.z * b.z < 0.0f)
+        b = rnu::quat(-b.w, -b.x, -b.y, -b.z);
+      rnu::quat const r(
+        a.w + (b.w - a.w) * t, a.x + (b.x - a.x) * t, a.y + (b.y - a.y) * t, a.z + (b.z - a.z) * t);
+      auto const inv_length = 1.0f / std::sqrt(r.w * r.w + r.x * r.x + r.y * r.y + r.z * r.z);
+      return rnu::quat(r.w * inv_length, r.x * inv_length, r.y * inv_length, r.z * inv_length);
+    }
+
+    float error(rnu::vec3 const& a, rnu::vec3 const& b)
+    {
+      return std::max({std::abs(a.x - b.x), std::abs(a.y - b.y), std::abs(a.z - b.z)});
+    }
+
+    float error(rnu::quat const& a, rnu::quat const& b)
+    {
+      auto const sign = a.w * b.w + a.x * b.x + a.y * b.y + a.z * b.z < 0.0f ? -1.0f : 1.0f;
+      return std::max({std::abs(a.w - sign * b.w), std::abs(a.x - sign * b.x), std::abs(a.y - sign * b.y),
+        std::abs(a.z - sign * b.z)});
+    }
+
+    // Vec3 tracks are quantized over the range of all of their keys.
+    std::pair<rnu::vec3, rnu::vec3> value_range(std::span<rnu::vec3 const> values)
+    {
+      auto min = values.front();
+      auto max = values.front();
+      for (auto const& v : values)
+      {
+        min = rnu::vec3(std::min(min.x, v.x), std::min(min.y, v.y), std::min(min.z, v.z));
+        max = rnu::vec3(std::max(max.x, v.x), std::max(max.y, v.y), std::max(max.z, v.z));
+      }
+      return {min, max - min};
+    }
+
+    // Greedily extends every segment as long as interpolating between its quantized ends reproduces all keys in
+    // between, so the stored keys and not only the source values meet the tolerance.
+    template<typename T, typename Decode, typename Lerp>
+    std::vector<std::uint32_t> reduce_keys(std::span<float const> times, std::span<T const> values, float tolerance,
+      Decode&& decode, Lerp&& lerp)
+    {
+      std::vector<std::uint32_t> kept{0};
+      std::uint32_t anchor = 0;
+      auto anchor_value = decode(values[anchor]);
+      for (std::uint32_t end = 2; end < values.size(); ++end)
+      {
+        auto const end_value = decode(values[end]);
+        auto const span = times[end] - times[anchor];
+        for (auto i = anchor + 1; i < end; ++i)
+        {
+          auto const t = span > 0.0f ? (times[i] - times[anchor]) / span : 0.0f;
+          if (error(lerp(anchor_value, end_value, t), values[i]) > tolerance)
+          {
+            anchor = end - 1;
+            anchor_value = decode(values[anchor]);
+            kept.push_back(anchor);
+            break;
+          }
+        }
+      }
+      if (values.size() > 1)
+        kept.push_back(std::uint32_t(values.size() - 1));
+
+      auto const first = decode(values[0]);
+      if (kept.size() == 2 && std::ranges::all_of(values, [&](T const& v) { return error(first, v) <= tolerance; }))
+        kept.pop_back();
+      return kept;
+    }
+  }    // namespace
+
   animation::animation(animation_target target, size_t node_index, std::vector<rnu::vec3> vec3_checkpoints,
     std::vector<rnu::quat> quat_checkpoints, std::vector<float> timestamps)
     : _node_index(node_index),
@@ -15,55 +171,265 @@ namespace gev::scenery
   {
     return _timestamps.empty() ? 0 : _timestamps.back();
   }
-  void animation::transform(float time, float mix_factor, std::vector<transform_node>& nodes) const
+
+  animation_clip::animation_clip(std::span<animation const> channels, animation_compression const& compression)
   {
-    if (_timestamps.empty())
-      return;
+    std::vector<float> times;
+    for (auto const& c : channels)
+    {
+      auto const rotation = c._target == animation_target::rotation;
+      auto const num_values = rotation ? c._quat_checkpoints.size() : c._vec3_checkpoints.size();
+      auto const count = std::min(c._timestamps.size(), num_values);
+      if (count == 0)
+        continue;
 
-    auto const clamped_time = std::clamp(time, _timestamps.front(), _timestamps.back());
+      auto const all_times = std::span(c._timestamps).first(count);
+      auto const node = std::uint32_t(c._node_index);
+      if (rotation)
+      {
+        auto const values = std::span(c._quat_checkpoints).first(count);
+        auto const kept = reduce_keys(all_times, values, compression.rotation_tolerance,
+          [](rnu::quat const& q) { return unpack_quat(pack_quat(q)); },
+          [](rnu::quat const& a, rnu::quat const& b, float t) { return nlerp(a, b, t); });
 
-    auto const ts_iter = std::prev(std::upper_bound(begin(_timestamps), end(_timestamps), clamped_time));
-    auto const current_ts_index = std::distance(begin(_timestamps), ts_iter);
-    auto const next_ts_index = (current_ts_index + 1) % _timestamps.size();
+        times.clear();
+        for (auto const k : kept)
+          times.push_back(all_times[k]);
+        _quat_tracks.push_back(track{node, c._target, std::uint32_t(_quat_keys.size()), share_times(times),
+          std::uint32_t(kept.size()), {}, {}});
+        for (auto const k : kept)
+          _quat_keys.push_back(pack_quat(values[k]));
+      }
+      else
+      {
+        auto const values = std::span(c._vec3_checkpoints).first(count);
+        auto const tolerance = c._target == animation_target::scale ? compression.scale_tolerance :
+                                                                      compression.location_tolerance;
+        auto const [min, extent] = value_range(values);
+        auto const kept = reduce_keys(all_times, values, tolerance,
+          [&](rnu::vec3 const& v) { return unpack_vec3(pack_vec3(v, min, extent), min, extent); },
+          [](rnu::vec3 const& a, rnu::vec3 const& b, float t) { return a + (b - a) * t; });
 
-    auto const current_ts = _timestamps[current_ts_index];
-    auto const next_ts = _timestamps[next_ts_index];
-    auto const i = (next_ts_index == current_ts_index) ? 0.0 : (time - current_ts) / (next_ts - current_ts);
+        times.clear();
+        for (auto const k : kept)
+          times.push_back(all_times[k]);
+        _vec3_tracks.push_back(track{node, c._target, std::uint32_t(_vec3_keys.size()), share_times(times),
+          std::uint32_t(kept.size()), min, extent});
+        for (auto const k : kept)
+          _vec3_keys.push_back(pack_vec3(values[k], min, extent));
+      }
+      _duration = std::max(_duration, c.duration());
+    }
 
-    auto& n = nodes[_node_index];
+    assert(reproduces(channels, compression));
+  }
 
-    switch (_target)
+  bool animation_clip::reproduces(std::span<animation const> channels, animation_compression const& compression) const
+  {
+    std::size_t num_nodes = 0;
+    std::vector<float> times;
+    for (auto const& c : channels)
     {
-      case animation_target::location:
-      {
-        auto const& locations = _vec3_checkpoints;
-        auto const calc = interp(locations[current_ts_index], locations[next_ts_index], i);
-        auto const attenuated = interp(n.transformation.position, calc, mix_factor);
+      num_nodes = std::max(num_nodes, c._node_index + 1);
+      times.insert(times.end(), c._timestamps.begin(), c._timestamps.end());
+    }
+    std::ranges::sort(times);
+    times.erase(std::unique(times.begin(), times.end()), times.end());
 
-        n.transformation.position = attenuated;
-        break;
+    // Kept keys are only off by their quantization, all others by at most the tolerance. The slack covers the
+    // rounding of the sampling arithmetic.
+    std::vector<float> bounds(channels.size());
+    for (std::size_t i = 0; i < channels.size(); ++i)
+    {
+      auto const& c = channels[i];
+      if (c._target == animation_target::rotation)
+      {
+        auto quantization = 0.0f;
+        for (auto const& q : c._quat_checkpoints)
+          quantization = std::max(quantization, error(unpack_quat(pack_quat(q)), q));
+        bounds[i] = std::max(compression.rotation_tolerance, quantization) + 1e-6f;
       }
-      case animation_target::rotation:
+      else if (!c._vec3_checkpoints.empty())
+      {
+        auto const [min, extent] = value_range(c._vec3_checkpoints);
+        auto quantization = 0.0f;
+        auto magnitude = 1.0f;
+        for (auto const& v : c._vec3_checkpoints)
+        {
+          quantization = std::max(quantization, error(unpack_vec3(pack_vec3(v, min, extent), min, extent), v));
+          magnitude = std::max({magnitude, std::abs(v.x), std::abs(v.y), std::abs(v.z)});
+        }
+        auto const tolerance = c._target == animation_target::scale ? compression.scale_tolerance :
+                                                                      compression.location_tolerance;
+        bounds[i] = std::max(tolerance, quantization) + 1e-6f * magnitude;
+      }
+    }
+
+    std::vector<transform> locals(num_nodes);
+    std::vector<std::size_t> next_keys(channels.size(), 0);
+    animation_cursor cursor;
+    for (auto const time : times)
+    {
+      sample(time, 1.0f, cursor, locals);
+      for (std::size_t i = 0; i < channels.size(); ++i)
       {
-        auto const& rotations = _quat_checkpoints;
-        auto const rot = interp(rotations[current_ts_index], rotations[next_ts_index], i);
-        auto const attenuated = interp(n.transformation.rotation, rot, mix_factor);
+        auto const& c = channels[i];
+        auto const rotation = c._target == animation_target::rotation;
+        auto const num_values = rotation ? c._quat_checkpoints.size() : c._vec3_checkpoints.size();
+        auto const count = std::min(c._timestamps.size(), num_values);
+        auto& k = next_keys[i];
+        while (k < count && c._timestamps[k] < time)
+          ++k;
+        if (k >= count || c._timestamps[k] != time)
+          continue;
 
-        n.transformation.rotation = attenuated;
-        break;
+        auto const& local = locals[c._node_index];
+        auto const sampled_error = rotation ? error(local.rotation, c._quat_checkpoints[k]) :
+          error(c._target == animation_target::scale ? local.scale : local.position, c._vec3_checkpoints[k]);
+        if (sampled_error > bounds[i])
+          return false;
       }
-      case animation_target::scale:
+    }
+    return true;
+  }
+
+  std::uint32_t animation_clip::share_times(std::span<float const> times)
+  {
+    for (auto const* tracks : {&_vec3_tracks, &_quat_tracks})
+    {
+      for (auto const& t : *tracks)
       {
-        auto const& scales = _vec3_checkpoints;
-        auto const sca = interp(scales[current_ts_index], scales[next_ts_index], i);
-        auto const attenuated = interp(n.transformation.scale, sca, mix_factor);
+        if (t.num_keys == times.size() && std::equal(times.begin(), times.end(), _times.begin() + t.first_time))
+          return t.first_time;
+      }
+    }
+
+    auto const first = std::uint32_t(_times.size());
+    _times.insert(_times.end(), times.begin(), times.end());
+    return first;
+  }
 
-        n.transformation.scale = attenuated;
-        break;
+  float animation_clip::duration() const
+  {
+    return _duration;
+  }
+
+  void animation_clip::sample(float time, float mix_factor, animation_cursor& cursor, std::span<transform> locals) const
+  {
+    // Lanes: key a, key b and the current value per component, then the interpolation factor.
+    auto const num_vec3 = _vec3_tracks.size();
+    cursor.vec3_keys.resize(num_vec3, 0);
+    cursor.vec3_lanes.resize(num_vec3 * 10);
+    auto const v = [&](std::size_t lane) { return cursor.vec3_lanes.data() + lane * num_vec3; };
+    auto const vec3_target = [&](track const& t) -> rnu::vec3&
+    {
+      auto& n = locals[t.node];
+      return t.target == animation_target::scale ? n.scale : n.position;
+    };
+
+    for (std::size_t i = 0; i < num_vec3; ++i)
+    {
+      auto const& t = _vec3_tracks[i];
+      auto const times = std::span(_times).subspan(t.first_time, t.num_keys);
+      auto const factor = advance(times, time, cursor.vec3_keys[i]);
+      auto const a = t.first_key + cursor.vec3_keys[i];
+      auto const b = cursor.vec3_keys[i] + 1 < t.num_keys ? a + 1 : a;
+      auto const& current = vec3_target(t);
+      auto const key_a = unpack_vec3(_vec3_keys[a], t.offset, t.extent);
+      auto const key_b = unpack_vec3(_vec3_keys[b], t.offset, t.extent);
+      v(0)[i] = key_a.x, v(1)[i] = key_a.y, v(2)[i] = key_a.z;
+      v(3)[i] = key_b.x, v(4)[i] = key_b.y, v(5)[i] = key_b.z;
+      v(6)[i] = current.x, v(7)[i] = current.y, v(8)[i] = current.z;
+      v(9)[i] = factor;
+    }
+
+    for (std::size_t c = 0; c < 3; ++c)
+    {
+      auto const a = v(c);
+      auto const b = v(c + 3);
+      auto const result = v(c + 6);
+      auto const factor = v(9);
+      for (std::size_t i = 0; i < num_vec3; ++i)
+      {
+        auto const sampled = a[i] + (b[i] - a[i]) * factor[i];
+        result[i] += (sampled - result[i]) * mix_factor;
+      }
+    }
+
+    for (std::size_t i = 0; i < num_vec3; ++i)
+      vec3_target(_vec3_tracks[i]) = rnu::vec3(v(6)[i], v(7)[i], v(8)[i]);
+
+    // Rotations use normalized lerp along the shorter arc. Key reduction only bounds the error at the source key
+    // times, in between it drifts from slerp by an amount that grows with the angle between the kept keys.
+    auto const num_quat = _quat_tracks.size();
+    cursor.quat_keys.resize(num_quat, 0);
+    cursor.quat_lanes.resize(num_quat * 13);
+    auto const q = [&](std::size_t lane) { return cursor.quat_lanes.data() + lane * num_quat; };
+
+    for (std::size_t i = 0; i < num_quat; ++i)
+    {
+      auto const& t = _quat_tracks[i];
+      auto const times = std::span(_times).subspan(t.first_time, t.num_keys);
+      auto const factor = advance(times, time, cursor.quat_keys[i]);
+      auto const a = t.first_key + cursor.quat_keys[i];
+      auto const b = cursor.quat_keys[i] + 1 < t.num_keys ? a + 1 : a;
+      auto const& current = locals[t.node].rotation;
+      auto const key_a = unpack_quat(_quat_keys[a]);
+      auto const key_b = unpack_quat(_quat_keys[b]);
+      q(0)[i] = key_a.w, q(1)[i] = key_a.x, q(2)[i] = key_a.y, q(3)[i] = key_a.z;
+      q(4)[i] = key_b.w, q(5)[i] = key_b.x, q(6)[i] = key_b.y, q(7)[i] = key_b.z;
+      q(8)[i] = current.w, q(9)[i] = current.x, q(10)[i] = current.y, q(11)[i] = current.z;
+      q(12)[i] = factor;
+    }
+
+    auto const nlerp = [&](float* a[4], float* b[4], float const* factor, float mix)
+    {
+      for (std::size_t i = 0; i < num_quat; ++i)
+      {
+        auto const t = factor ? factor[i] : mix;
+        auto const dot = a[0][i] * b[0][i] + a[1][i] * b[1][i] + a[2][i] * b[2][i] + a[3][i] * b[3][i];
+        auto const sign = dot < 0.0f ? -1.0f : 1.0f;
+        float r[4];
+        for (std::size_t c = 0; c < 4; ++c)
+          r[c] = a[c][i] + (b[c][i] * sign - a[c][i]) * t;
+        auto const inv_length = 1.0f / std::sqrt(r[0] * r[0] + r[1] * r[1] + r[2] * r[2] + r[3] * r[3]);
+        for (std::size_t c = 0; c < 4; ++c)
+          b[c][i] = r[c] * inv_length;
       }
+    };
+    float* keys_a[4] = {q(0), q(1), q(2), q(3)};
+    float* keys_b[4] = {q(4), q(5), q(6), q(7)};
+    float* current[4] = {q(8), q(9), q(10), q(11)};
+    nlerp(keys_a, keys_b, q(12), 0.0f);
+    nlerp(current, keys_b, nullptr, mix_factor);
+
+    for (std::size_t i = 0; i < num_quat; ++i)
+    {
+      auto& r = locals[_quat_tracks[i].node].rotation;
+      r.w = q(4)[i], r.x = q(5)[i], r.y = q(6)[i], r.z = q(7)[i];
     }
   }
 
+  void animation_clip::serialize(std::ostream& out) const
+  {
+    serializable::write_typed(_duration, out);
+    serializable::write_vector(_times, out);
+    serializable::write_vector(_vec3_tracks, out);
+    serializable::write_vector(_vec3_keys, out);
+    serializable::write_vector(_quat_tracks, out);
+    serializable::write_vector(_quat_keys, out);
+  }
+
+  void animation_clip::deserialize(std::istream& in)
+  {
+    serializable::read_typed(_duration, in);
+    serializable::read_vector(_times, in);
+    serializable::read_vector(_vec3_tracks, in);
+    serializable::read_vector(_vec3_keys, in);
+    serializable::read_vector(_quat_tracks, in);
+    serializable::read_vector(_quat_keys, in);
+  }
+
   void animation::serialize(serializer& base, std::ostream& out) 
   {
     write_typed(_node_index, out);
@@ -109,24 +475,24 @@ namespace gev::scenery
   {
     return _root_node;
   }
-  std::vector<rnu::mat4>& skin::apply_global_transforms(transform_tree const& tree)
+  void skin::apply_global_transforms(skeleton_pose const& pose, std::vector<rnu::mat4>& palette) const
   {
-    _global_joint_matrices.resize(size(), rnu::mat4(1.0f));
+    palette.resize(size(), rnu::mat4(1.0f));
 
     for (int i = 0; i < size(); ++i)
     {
-      auto const& g = tree.global_transform(joint_node(i));
-      _global_joint_matrices[i] = g * joint_matrix(i);
+      auto const& g = pose.global_transform(joint_node(i));
+      palette[i] = g * joint_matrix(i);
     }
-    return _global_joint_matrices;
   }
 
+  // The skin used to own the joint palette, assets still contain an empty slot for it.
   void skin::serialize(serializer& base, std::ostream& out)
   {
     write_size(_root_node, out);
     write_vector(_joint_nodes, out);
     write_vector(_joint_matrices, out);
-    write_vector(_global_joint_matrices, out);
+    write_vector(std::vector<rnu::mat4>{}, out);
   }
 
   void skin::deserialize(serializer& base, std::istream& in)
@@ -134,7 +500,8 @@ namespace gev::scenery
     read_size(_root_node, in);
     read_vector(_joint_nodes, in);
     read_vector(_joint_matrices, in);
-    read_vector(_global_joint_matrices, in);
+    std::vector<rnu::mat4> palette;
+    read_vector(palette, in);
   }
 
   transform_tree::transform_tree(std::vector<transform_node> nodes)
@@ -143,12 +510,6 @@ namespace gev::scenery
     recompute_globals();
   }
 
-  void transform_tree::animate(joint_animation& animation, std::chrono::duration<double> delta)
-  {
-    animation.update(delta, _nodes);
-    recompute_globals();
-  }
-
   std::span<transform_node const> transform_tree::nodes() const
   {
     return _nodes;
@@ -207,12 +568,11 @@ namespace gev::scenery
     read_vector(_global_matrices, in);
   }
 
-  void joint_animation::set(std::vector<animation> anim, bool one_shot)
+  void joint_animation::set(std::vector<animation> anim, bool one_shot, animation_compression const& compression)
   {
-    for (auto const& a : anim)
-      _longest_duration = std::max(_longest_duration, a.duration());
-    _anim.animation = std::move(anim);
-    _anim.one_shot = one_shot;
+    _clip = std::make_shared<animation_clip>(anim, compression);
+    _cursor = {};
+    _one_shot = one_shot;
   }
 
   void joint_animation::start(double offset)
@@ -223,50 +583,140 @@ namespace gev::scenery
     _current = 0;
   }
 
-  void joint_animation::update(std::chrono::duration<double> d, std::vector<transform_node>& nodes)
+  void joint_animation::update(std::chrono::duration<double> d, std::span<transform> locals)
   {
     _time += d.count();
     _ramp_up.update(d.count());
 
     bool animation_finished = false;
-    if (_longest_duration <= _time)
+    if (_clip->duration() <= _time)
       animation_finished = true;
 
     if (animation_finished)
     {
-      if (!_anim.one_shot)
-        _time = std::fmodf(_time, _longest_duration);
+      if (!_one_shot)
+        _time = std::fmodf(_time, _clip->duration());
     }
 
-    for (auto& a : _anim.animation)
-      a.transform(_time, float(_ramp_up.value()), nodes);
+    _clip->sample(float(_time), float(_ramp_up.value()), _cursor, locals);
   }
 
-  void joint_animation::serialize(serializer& base, std::ostream& out) 
+  void joint_animation::serialize(serializer& base, std::ostream& out)
   {
-    write_typed(_anim.one_shot, out);
-    write_typed(_longest_duration, out);
-    write_size(_anim.animation.size(), out);
-    for (auto& anim : _anim.animation)
-    {
-      anim.serialize(base, out);
-    }
+    write_typed(std::uint8_t(_one_shot | compiled_clip_flag), out);
+    _clip->serialize(out);
   }
 
-  void joint_animation::deserialize(serializer& base, std::istream& in) 
+  void joint_animation::deserialize(serializer& base, std::istream& in)
   {
-    read_typed(_anim.one_shot, in);
-    read_typed(_longest_duration, in);
-    std::size_t count = 0ull;
-    read_typed(count, in);
-    _anim.animation.resize(count);
-    for (auto& anim : _anim.animation)
+    std::uint8_t flags = 0;
+    read_typed(flags, in);
+    _one_shot = flags & 1;
+    if (flags & compiled_clip_flag)
+    {
+      auto clip = std::make_shared<animation_clip>();
+      clip->deserialize(in);
+      _clip = std::move(clip);
+    }
+    else
     {
-      anim.deserialize(base, in);
+      float longest_duration = 0.0f;
+      read_typed(longest_duration, in);
+      std::size_t count = 0ull;
+      read_typed(count, in);
+      std::vector<animation> channels(count);
+      for (auto& c : channels)
+        c.deserialize(base, in);
+      _clip = std::make_shared<animation_clip>(channels);
     }
+    _cursor = {};
     _time = 0.0;
     _ramp_up = 0;
     _ramp_up.to(1.0);
     _current = 0;
   }
-}    // namespace gev::scenery
\ No newline at end of file
+
+  skeleton::skeleton(skin joints, transform_tree rest_pose, std::unordered_map<std::string, joint_animation> animations)
+    : _joints(std::move(joints)), _rest_pose(std::move(rest_pose)), _animations(std::move(animations))
+  {
+  }
+
+  skin const& skeleton::joints() const
+  {
+    return _joints;
+  }
+
+  transform_tree const& skeleton::rest_pose() const
+  {
+    return _rest_pose;
+  }
+
+  std::unordered_map<std::string, joint_animation> const& skeleton::animations() const
+  {
+    return _animations;
+  }
+
+  void skeleton::serialize(serializer& base, std::ostream& out)
+  {
+    _joints.serialize(base, out);
+    _rest_pose.serialize(base, out);
+
+    write_size(_animations.size(), out);
+    for (auto& [name, anim] : _animations)
+    {
+      write_string(name, out);
+      anim.serialize(base, out);
+    }
+  }
+
+  void skeleton::deserialize(serializer& base, std::istream& in)
+  {
+    _joints.deserialize(base, in);
+    _rest_pose.deserialize(base, in);
+
+    std::size_t count = 0ull;
+    read_size(count, in);
+    for (std::size_t i = 0; i < count; ++i)
+    {
+      std::string name;
+      read_string(name, in);
+      _animations[name].deserialize(base, in);
+    }
+  }
+
+  skeleton_pose::skeleton_pose(transform_tree const& rest_pose)
+  {
+    auto const nodes = rest_pose.nodes();
+    _locals.reserve(nodes.size());
+    _globals.reserve(nodes.size());
+    for (std::size_t i = 0; i < nodes.size(); ++i)
+    {
+      _locals.push_back(nodes[i].transformation);
+      _globals.push_back(rest_pose.global_transform(i));
+    }
+  }
+
+  void skeleton_pose::animate(
+    transform_tree const& tree, joint_animation& animation, std::chrono::duration<double> delta)
+  {
+    animation.update(delta, _locals);
+
+    auto const nodes = tree.nodes();
+    for (std::size_t i = 0; i < nodes.size(); ++i)
+    {
+      _globals[i] = _locals[i].matrix();
+      if (nodes[i].parent != -1)
+        _globals[i] = _globals[nodes[i].parent] * _globals[i];
+    }
+  }
+
+  transform const& skeleton_pose::local_transform(size_t node) const
+  {
+    return _locals[node];
+  }
+
+  rnu::mat4 const& skeleton_pose::global_transform(size_t node) const
+  {
+    return _globals[node];
+  }
+}    // namespace gev::scenery
@@ -193,7 +193,7 @@ namespace gev::scenery
       _rigid_body->setWorldTransform(tf);
       _rigid_body->setLinearVelocity({0, 0, 0});
       s->add(_rigid_body.get(), _group, _mask);
-      _last_transform = owner()->local_transform;
+      _last_transform = owner()->local_transform();
     }
   }
 
@@ -203,21 +203,19 @@ namespace gev::scenery
       s->erase(_rigid_body.get());
   }
 
-  void collider_component::fixed_update(double time, double delta) {}
-
   void collider_component::update()
   {
     if (auto const o = owner())
     {
-      if (_last_transform != o->local_transform)
+      if (_last_transform != o->local_transform())
       {
         btTransform tf = _rigid_body->getWorldTransform();
-        if ((_last_transform.position != o->local_transform.position).any())
+        if ((_last_transform.position != o->local_transform().position).any())
         {
           tf.setOrigin(
             {o->global_transform().position.x, o->global_transform().position.y, o->global_transform().position.z});
         }
-        if (_last_transform.rotation == o->local_transform.rotation)
+        if (_last_transform.rotation == o->local_transform().rotation)
         {
           tf.setRotation({o->global_transform().rotation.w, o->global_transform().rotation.x,
             o->global_transform().rotation.y, o->global_transform().rotation.z});
@@ -237,11 +235,11 @@ namespace gev::scenery
         rnu::mat4 next_global;
         tf.getOpenGLMatrix(next_global.data());
 
-        auto const r = o->local_transform.rotation;
-        o->local_transform = inv_parent * next_global;
-        o->local_transform.rotation = r;
+        transform local = inv_parent * next_global;
+        local.rotation = o->local_transform().rotation;
+        o->set_local_transform(local);
       }
-      _last_transform = o->local_transform;
+      _last_transform = o->local_transform();
     }
   }
 
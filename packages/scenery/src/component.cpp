@@ -1,7 +1,28 @@
 #include <gev/scenery/component.hpp>
+#include <mutex>
+#include <unordered_map>
 
 namespace gev::scenery
 {
+  namespace
+  {
+    std::mutex traits_mutex;
+    std::unordered_map<std::size_t, component_traits> traits_by_type;
+  }    // namespace
+
+  void register_component_traits(std::type_info const& type, component_traits traits)
+  {
+    std::unique_lock lock(traits_mutex);
+    traits_by_type[type.hash_code()] = traits;
+  }
+
+  component_traits traits_of(std::type_info const& type)
+  {
+    std::unique_lock lock(traits_mutex);
+    auto const iter = traits_by_type.find(type.hash_code());
+    return iter == traits_by_type.end() ? component_traits{} : iter->second;
+  }
+
   std::shared_ptr<entity> component::owner() const
   {
     return _parent.lock();
@@ -13,9 +13,16 @@ namespace gev::scenery
     return _id;
   }
 
+  entity_index entity::index() const
+  {
+    return _index;
+  }
+
   void entity::add(std::shared_ptr<component> c)
   {
     c->_parent = unsafe_shared_from_this<entity>();
+    if (auto const m = manager(); m && _index != invalid_entity_index)
+      m->subscribe(*c, *this);
     _components.push_back(std::move(c));
 
     std::sort(_components.begin(), _components.end(),
@@ -61,6 +68,8 @@ namespace gev::scenery
     if (found != end(_components))
     {
       found->get()->despawn();
+      if (auto const m = manager())
+        m->unsubscribe(**found);
       _components.erase(found);
     }
   }
@@ -93,6 +102,7 @@ namespace gev::scenery
   void entity::set_active(bool active)
   {
     _active = active;
+    refresh_inherited_active();
     if (is_inherited_active())
       activate();
     else if (!active)
@@ -101,14 +111,15 @@ namespace gev::scenery
 
   bool entity::is_inherited_active() const
   {
-    if (!_active)
-      return false;
-
-    if (_parent.expired())
-      return _active;
+    return _inherited_active;
+  }
 
-    auto parent = _parent.lock();
-    return _active && parent->is_inherited_active();
+  void entity::refresh_inherited_active()
+  {
+    auto const p = parent();
+    _inherited_active = _active && (!p || p->_inherited_active);
+    for (auto const& c : _children)
+      c->refresh_inherited_active();
   }
 
   bool entity::is_active() const
@@ -162,7 +173,7 @@ namespace gev::scenery
   {
     write_size(_id, out);
     write_typed(_active, out);
-    write_typed(local_transform, out);
+    write_typed(local_transform(), out);
 
     write_size(_components.size(), out);
     for (auto const& c : _components)
@@ -181,7 +192,10 @@ namespace gev::scenery
     
     read_size(_id, in);
     read_typed(_active, in);
-    read_typed(local_transform, in);
+    _inherited_active = _active;
+    transform local;
+    read_typed(local, in);
+    set_local_transform(local);
 
     std::size_t num = 0;
     read_size(num, in);
@@ -249,19 +263,32 @@ namespace gev::scenery
     return _children;
   }
 
-  void entity::apply_transform()
+  transform const& entity::local_transform() const
   {
-    _global_transform = _global_transform.matrix() * local_transform.matrix();
-    for (auto const& c : _children)
-    {
-      c->_global_transform = _global_transform;
-      c->apply_transform();
-    }
+    return _transforms ? _transforms->local(_index) : _local_transform;
+  }
+
+  void entity::set_local_transform(transform const& t)
+  {
+    if (_transforms)
+      _transforms->set_local(_index, t);
+    else
+      _local_transform = t;
+  }
+
+  transform& entity::edit_local_transform()
+  {
+    return _transforms ? _transforms->edit_local(_index) : _local_transform;
   }
 
   transform const& entity::global_transform() const
   {
-    return _global_transform;
+    return _transforms ? _transforms->global(_index) : _local_transform;
+  }
+
+  std::uint64_t entity::transform_version() const
+  {
+    return _transforms ? _transforms->version(_index) : 0;
   }
 
   std::shared_ptr<entity> entity::parent() const
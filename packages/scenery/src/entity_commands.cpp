@@ -0,0 +1,111 @@
+#include <algorithm>
+#include <gev/scenery/component.hpp>
+#include <gev/scenery/entity_commands.hpp>
+#include <gev/scenery/entity_manager.hpp>
+
+namespace gev::scenery
+{
+  std::shared_ptr<entity> entity_commands::instantiate(std::shared_ptr<entity> parent)
+  {
+    return instantiate(~0, std::move(parent));
+  }
+
+  std::shared_ptr<entity> entity_commands::instantiate(std::size_t id, std::shared_ptr<entity> parent)
+  {
+    auto r = std::make_shared<entity>(id);
+    _commands.push_back(command{command_type::instantiate, r, std::move(parent), nullptr});
+    return r;
+  }
+
+  void entity_commands::destroy(std::shared_ptr<entity> e)
+  {
+    _commands.push_back(command{command_type::destroy, std::move(e), nullptr, nullptr});
+  }
+
+  void entity_commands::reparent(std::shared_ptr<entity> target, std::shared_ptr<entity> new_parent)
+  {
+    _commands.push_back(command{command_type::reparent, std::move(target), std::move(new_parent), nullptr});
+  }
+
+  void entity_commands::add(std::shared_ptr<entity> target, std::shared_ptr<component> c)
+  {
+    _commands.push_back(command{command_type::add, std::move(target), nullptr, std::move(c)});
+  }
+
+  void entity_commands::erase(std::shared_ptr<entity> target, std::shared_ptr<component> c)
+  {
+    _commands.push_back(command{command_type::erase, std::move(target), nullptr, std::move(c)});
+  }
+
+  bool entity_commands::empty() const
+  {
+    return _commands.empty();
+  }
+
+  void entity_commands::playback(entity_manager& manager, bool spawn)
+  {
+    auto const alive = [&](std::shared_ptr<entity> const& e)
+    { return e && e->manager().get() == &manager && e->index() != invalid_entity_index; };
+
+    // New entities and components are spawned after all commands were applied, so that everything added to a new
+    // entity in the same buffer is spawned together with it.
+    std::vector<std::shared_ptr<entity>> new_entities;
+    std::vector<std::shared_ptr<component>> new_components;
+    for (auto& cmd : _commands)
+    {
+      switch (cmd.type)
+      {
+      case command_type::instantiate:
+        manager.add(cmd.target, std::move(cmd.parent));
+        new_entities.push_back(std::move(cmd.target));
+        break;
+      case command_type::destroy:
+        if (alive(cmd.target))
+          manager.destroy(std::move(cmd.target));
+        break;
+      case command_type::reparent:
+        if (alive(cmd.target))
+          manager.reparent(cmd.target, std::move(cmd.parent));
+        break;
+      case command_type::add:
+        cmd.target->add(cmd.c);
+        new_components.push_back(std::move(cmd.c));
+        break;
+      case command_type::erase:
+        cmd.target->erase(std::move(cmd.c));
+        break;
+      }
+    }
+    _commands.clear();
+
+    if (!spawn)
+      return;
+
+    auto const has_new_ancestor = [&](std::shared_ptr<entity> e)
+    {
+      for (e = e->parent(); e; e = e->parent())
+      {
+        if (std::ranges::find(new_entities, e) != new_entities.end())
+          return true;
+      }
+      return false;
+    };
+
+    for (auto const& c : new_components)
+    {
+      auto const owner = c->owner();
+      if (!alive(owner) || std::ranges::find(new_entities, owner) != new_entities.end() || has_new_ancestor(owner))
+        continue;
+
+      c->spawn();
+      if (c->is_inherited_active())
+        c->activate();
+    }
+
+    for (auto const& e : new_entities)
+    {
+      if (alive(e) && !has_new_ancestor(e))
+        e->spawn();
+    }
+  }
+}    // namespace gev::scenery
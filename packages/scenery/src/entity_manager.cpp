@@ -1,4 +1,7 @@
+#include <algorithm>
+#include <gev/scenery/component.hpp>
 #include <gev/scenery/entity_manager.hpp>
+#include <utility>
 
 namespace gev::scenery
 {
@@ -18,15 +21,75 @@ namespace gev::scenery
 
   void entity_manager::assign_manager_impl(std::shared_ptr<entity> existing)
   {
-    existing->_manager = shared_from_this();
+    auto const previous = existing->manager();
+    if (previous.get() != this)
+    {
+      if (previous)
+        previous->unregister_entity(*existing);
+      existing->_manager = shared_from_this();
+    }
+    if (existing->_index == invalid_entity_index)
+      register_entity(*existing);
+
     for (auto const& ch : existing->_children)
       assign_manager_impl(ch);
   }
 
+  void entity_manager::register_entity(entity& e)
+  {
+    if (_free_indices.empty())
+    {
+      e._index = entity_index(_entities.size());
+      _entities.push_back(&e);
+    }
+    else
+    {
+      e._index = _free_indices.back();
+      _free_indices.pop_back();
+      _entities[e._index] = &e;
+    }
+
+    if (e._id != ~0)
+      _entities_by_id.emplace(e._id, &e);
+    _transforms.insert(e._index, e._local_transform);
+    e._transforms = &_transforms;
+    if (auto const p = e.parent(); p && p->_transforms == &_transforms)
+      _transforms.set_parent(e._index, p->_index);
+
+    auto const p = e.parent();
+    e._inherited_active = e._active && (!p || p->_inherited_active);
+    for (auto const& c : e._components)
+      subscribe(*c, e);
+  }
+
+  void entity_manager::unregister_entity(entity& e)
+  {
+    for (auto const& ch : e._children)
+      unregister_entity(*ch);
+
+    if (e._index == invalid_entity_index)
+      return;
+
+    for (auto const& c : e._components)
+      unsubscribe(*c);
+    auto const [first, last] = _entities_by_id.equal_range(e._id);
+    auto const found = std::find_if(first, last, [&](auto const& p) { return p.second == &e; });
+    if (found != last)
+      _entities_by_id.erase(found);
+    e._local_transform = _transforms.local(e._index);
+    _transforms.erase(e._index);
+    e._transforms = nullptr;
+    _components.remove_all(e._index);
+    _entities[e._index] = nullptr;
+    _free_indices.push_back(e._index);
+    e._index = invalid_entity_index;
+  }
+
   std::shared_ptr<entity> entity_manager::instantiate(std::size_t id, std::shared_ptr<entity> parent)
   {
     auto r = std::make_shared<entity>(id);
     r->_manager = shared_from_this();
+    register_entity(*r);
     add_to_parent(r, parent);
     return r;
   }
@@ -36,18 +99,15 @@ namespace gev::scenery
     if (id == ~0)
       return nullptr;
 
-    for (auto const& c : _root_entities)
-    {
-      if (auto const found = c->find_by_id(id))
-        return found;
-    }
-    return nullptr;
+    auto const iter = _entities_by_id.find(id);
+    return iter == _entities_by_id.end() ? nullptr : iter->second->unsafe_shared_from_this<entity>();
   }
 
   void entity_manager::destroy(std::shared_ptr<entity> e)
   {
     remove_from_parent(e);
     e->despawn();
+    unregister_entity(*e);
   }
 
   void entity_manager::reparent(std::shared_ptr<entity> const& target, std::shared_ptr<entity> new_parent)
@@ -74,6 +134,9 @@ namespace gev::scenery
         parent->_children.erase(found);
     }
     target->_parent.reset();
+    if (target->_transforms == &_transforms)
+      _transforms.set_parent(target->_index, invalid_entity_index);
+    target->refresh_inherited_active();
   }
 
   void entity_manager::add_to_parent(std::shared_ptr<entity> const& target, std::shared_ptr<entity> parent)
@@ -84,52 +147,213 @@ namespace gev::scenery
     {
       auto&& r = parent->_children.emplace_back(target);
       r->_parent = parent;
+      if (target->_transforms == &_transforms && parent->_transforms == &_transforms)
+        _transforms.set_parent(target->_index, parent->_index);
     }
+    target->refresh_inherited_active();
   }
 
-  void entity_manager::apply_transform() const
+  void entity_manager::apply_transform()
   {
-    for (auto const& c : _root_entities)
-    {
-      c->_global_transform = {};
-      c->apply_transform();
-    }
+    _transforms.update(_executor);
+  }
+
+  void entity_manager::set_executor(parallel_executor executor)
+  {
+    _executor = std::move(executor);
+  }
+
+  parallel_executor const& entity_manager::executor() const
+  {
+    return _executor;
   }
 
-  void entity_manager::spawn() const
+  void entity_manager::spawn()
   {
     apply_transform();
     for (auto const& c : _root_entities)
       c->spawn();
+    _spawned = true;
   }
 
   void entity_manager::despawn()
   {
     while (!_root_entities.empty())
       destroy(_root_entities.back());
+    _spawned = false;
   }
 
-  void entity_manager::early_update() const
+  entity_commands& entity_manager::commands()
   {
-    for (auto const& c : _root_entities)
-      c->early_update();
+    auto const thread = std::this_thread::get_id();
+    std::unique_lock lock(_commands_mutex);
+    auto const iter = std::ranges::find(_commands, thread, [](auto const& p) { return p.first; });
+    if (iter != _commands.end())
+      return *iter->second;
+    return *_commands.emplace_back(thread, std::make_unique<entity_commands>()).second;
   }
 
-  void entity_manager::update() const
+  void entity_manager::flush_commands()
   {
-    for (auto const& c : _root_entities)
-      c->update();
+    // Playback may record new commands, those are applied in the same flush.
+    while (true)
+    {
+      std::vector<entity_commands> pending;
+      {
+        std::unique_lock lock(_commands_mutex);
+        for (auto const& [thread, buffer] : _commands)
+        {
+          if (!buffer->empty())
+            pending.push_back(std::exchange(*buffer, entity_commands{}));
+        }
+      }
+      if (pending.empty())
+        return;
+
+      for (auto& buffer : pending)
+        buffer.playback(*this, _spawned);
+    }
   }
 
-  void entity_manager::fixed_update(double time, double delta) const
+  void entity_manager::subscribe(component& c, entity& owner)
   {
-    for (auto const& c : _root_entities)
-      c->fixed_update(time, delta);
+    auto const traits = traits_of(typeid(c));
+    c._parallel = traits.parallel_safe;
+    for (std::size_t phase = 0; phase < num_component_phases; ++phase)
+    {
+      if (!(traits.phases & phase_bit(component_phase(phase))) || c._phase_slots[phase] != ~0u)
+        continue;
+
+      auto& list = _phase_lists[phase][c._parallel];
+      c._phase_slots[phase] = std::uint32_t(list.subscribers.size());
+      list.subscribers.push_back(phase_subscriber{&c, &owner});
+    }
+
+    if (c._type_slot == ~0u)
+    {
+      auto& members = _components_by_type[typeid(c).hash_code()];
+      c._type_slot = std::uint32_t(members.size());
+      members.push_back(phase_subscriber{&c, &owner});
+    }
   }
 
-  void entity_manager::late_update() const
+  void entity_manager::unsubscribe(component& c)
   {
-    for (auto const& c : _root_entities)
-      c->late_update();
+    for (std::size_t phase = 0; phase < num_component_phases; ++phase)
+    {
+      if (c._phase_slots[phase] == ~0u)
+        continue;
+
+      auto& list = _phase_lists[phase][c._parallel];
+      list.subscribers[c._phase_slots[phase]].c = nullptr;
+      list.holes = true;
+      c._phase_slots[phase] = ~0u;
+    }
+
+    if (c._type_slot != ~0u)
+    {
+      auto& members = _components_by_type[typeid(c).hash_code()];
+      members[c._type_slot] = members.back();
+      members[c._type_slot].c->_type_slot = c._type_slot;
+      members.pop_back();
+      c._type_slot = ~0u;
+    }
+  }
+
+  std::span<entity_manager::phase_subscriber const> entity_manager::members_of(std::type_info const& type) const
+  {
+    auto const iter = _components_by_type.find(type.hash_code());
+    if (iter == _components_by_type.end())
+      return {};
+    return iter->second;
+  }
+
+  void entity_manager::compact(phase_list& list, component_phase phase)
+  {
+    if (!list.holes)
+      return;
+
+    std::erase_if(list.subscribers, [](phase_subscriber const& s) { return s.c == nullptr; });
+    for (std::uint32_t slot = 0; slot < list.subscribers.size(); ++slot)
+      list.subscribers[slot].c->_phase_slots[std::size_t(phase)] = slot;
+    list.holes = false;
+  }
+
+  template<typename Func>
+  void entity_manager::run_phase(component_phase phase, Func&& func)
+  {
+    auto& [serial, parallel] = _phase_lists[std::size_t(phase)];
+    if (_running_phases == 0)
+    {
+      compact(serial, phase);
+      compact(parallel, phase);
+    }
+
+    ++_running_phases;
+    auto const run = [&](phase_subscriber const& s)
+    {
+      if (s.c && s.c->_active && s.owner->_inherited_active)
+        func(*s.c);
+    };
+
+    auto const& subscribers = parallel.subscribers;
+    if (_executor && subscribers.size() >= parallel_threshold)
+    {
+      _executor(subscribers.size(),
+        [&](std::size_t begin, std::size_t end)
+        {
+          for (auto i = begin; i < end; ++i)
+            run(subscribers[i]);
+        });
+    }
+    else
+    {
+      for (auto const& s : subscribers)
+        run(s);
+    }
+
+    // Components subscribed during the phase are appended and still run in it.
+    for (std::size_t i = 0; i < serial.subscribers.size(); ++i)
+      run(serial.subscribers[i]);
+    --_running_phases;
+  }
+
+  void entity_manager::early_update()
+  {
+    run_phase(component_phase::early_update, [](component& c) { c.early_update(); });
+    run_systems(system_phase::early_update);
+  }
+
+  void entity_manager::update()
+  {
+    run_phase(component_phase::update, [](component& c) { c.update(); });
+    run_systems(system_phase::update);
+  }
+
+  void entity_manager::fixed_update(double time, double delta)
+  {
+    run_phase(component_phase::fixed_update, [&](component& c) { c.fixed_update(time, delta); });
+  }
+
+  void entity_manager::late_update()
+  {
+    run_phase(component_phase::late_update, [](component& c) { c.late_update(); });
+    run_systems(system_phase::late_update);
+  }
+
+  void entity_manager::add_system(system_phase phase, system s)
+  {
+    _systems[std::size_t(phase)].push_back(std::move(s));
+  }
+
+  void entity_manager::run_systems(system_phase phase) const
+  {
+    for (auto const& s : _systems[std::size_t(phase)])
+      s();
+  }
+
+  component_store& entity_manager::components()
+  {
+    return _components;
   }
 }    // namespace gev::scenery
\ No newline at end of file
@@ -0,0 +1,216 @@
+#include <algorithm>
+#include <gev/scenery/transform_hierarchy.hpp>
+
+namespace gev::scenery
+{
+  void transform_hierarchy::insert(entity_index e, transform const& local)
+  {
+    if (e >= _positions.size())
+      _positions.resize(e + 1, no_position);
+
+    auto const position = std::uint32_t(_entities.size());
+    _positions[e] = position;
+    _entities.push_back(e);
+    _parents.push_back(invalid_entity_index);
+    _parent_positions.push_back(no_position);
+    _locals.push_back(local);
+    _globals.push_back(local);
+    _versions.push_back(0);
+    _updated.push_back(0);
+    _dirty.push_back(0);
+    _unsorted = true;
+    mark_dirty(position);
+  }
+
+  void transform_hierarchy::erase(entity_index e)
+  {
+    auto const position = _positions[e];
+    auto const last = std::uint32_t(_entities.size() - 1);
+    if (position != last)
+    {
+      _entities[position] = _entities[last];
+      _parents[position] = _parents[last];
+      _locals[position] = _locals[last];
+      _globals[position] = _globals[last];
+      _versions[position] = _versions[last];
+      _updated[position] = _updated[last];
+      _dirty[position] = _dirty[last];
+      _positions[_entities[position]] = position;
+      if (_dirty[position])
+        mark_dirty(position);
+    }
+    _entities.pop_back();
+    _parents.pop_back();
+    _parent_positions.pop_back();
+    _locals.pop_back();
+    _globals.pop_back();
+    _versions.pop_back();
+    _updated.pop_back();
+    _dirty.pop_back();
+    _positions[e] = no_position;
+    _unsorted = true;
+  }
+
+  void transform_hierarchy::set_parent(entity_index e, entity_index parent)
+  {
+    auto const position = _positions[e];
+    _parents[position] = parent;
+    _unsorted = true;
+    mark_dirty(position);
+  }
+
+  void transform_hierarchy::set_local(entity_index e, transform const& local)
+  {
+    auto const position = _positions[e];
+    if (_locals[position] != local)
+    {
+      _locals[position] = local;
+      mark_dirty(position);
+    }
+  }
+
+  transform& transform_hierarchy::edit_local(entity_index e)
+  {
+    auto const position = _positions[e];
+    mark_dirty(position);
+    return _locals[position];
+  }
+
+  transform const& transform_hierarchy::local(entity_index e) const
+  {
+    return _locals[_positions[e]];
+  }
+
+  transform const& transform_hierarchy::global(entity_index e) const
+  {
+    return _globals[_positions[e]];
+  }
+
+  std::uint64_t transform_hierarchy::version(entity_index e) const
+  {
+    return _versions[_positions[e]];
+  }
+
+  bool transform_hierarchy::dirty() const
+  {
+    return _unsorted || _first_dirty != no_position;
+  }
+
+  void transform_hierarchy::update(parallel_executor const& executor)
+  {
+    if (_unsorted)
+      sort();
+    if (_first_dirty == no_position)
+      return;
+
+    ++_pass;
+    for (std::size_t level = 0; level + 1 < _levels.size(); ++level)
+    {
+      auto const begin = std::max(_levels[level], _first_dirty.load());
+      auto const end = _levels[level + 1];
+      if (begin >= end)
+        continue;
+
+      if (executor && end - begin >= parallel_threshold)
+        executor(end - begin, [&](std::size_t b, std::size_t e) { update_range(begin + b, begin + e); });
+      else
+        update_range(begin, end);
+    }
+    _first_dirty = no_position;
+  }
+
+  void transform_hierarchy::mark_dirty(std::uint32_t position)
+  {
+    _dirty[position] = 1;
+    auto first = _first_dirty.load(std::memory_order_relaxed);
+    while (position < first && !_first_dirty.compare_exchange_weak(first, position, std::memory_order_relaxed))
+    {
+    }
+  }
+
+  void transform_hierarchy::sort()
+  {
+    auto const count = std::uint32_t(_entities.size());
+    auto const parent_position = [&](std::uint32_t position)
+    {
+      auto const parent = _parents[position];
+      return parent < _positions.size() ? _positions[parent] : no_position;
+    };
+
+    std::vector<std::uint32_t> depths(count, no_position);
+    std::vector<std::uint32_t> chain;
+    std::uint32_t max_depth = 0;
+    for (std::uint32_t i = 0; i < count; ++i)
+    {
+      auto position = i;
+      while (position != no_position && depths[position] == no_position)
+      {
+        chain.push_back(position);
+        position = parent_position(position);
+      }
+
+      auto depth = position == no_position ? 0u : depths[position] + 1;
+      for (auto iter = chain.rbegin(); iter != chain.rend(); ++iter)
+        depths[*iter] = depth++;
+      chain.clear();
+      max_depth = std::max(max_depth, depths[i]);
+    }
+
+    _levels.assign(count == 0 ? 1 : max_depth + 2, 0);
+    for (auto const depth : depths)
+      ++_levels[depth + 1];
+    for (std::size_t level = 1; level < _levels.size(); ++level)
+      _levels[level] += _levels[level - 1];
+
+    std::vector<std::uint32_t> order(count);
+    auto offsets = _levels;
+    for (std::uint32_t i = 0; i < count; ++i)
+      order[offsets[depths[i]]++] = i;
+
+    auto const permute = [&](auto& values)
+    {
+      std::remove_reference_t<decltype(values)> sorted;
+      sorted.reserve(values.size());
+      for (auto const position : order)
+        sorted.push_back(std::move(values[position]));
+      values = std::move(sorted);
+    };
+    permute(_entities);
+    permute(_parents);
+    permute(_locals);
+    permute(_globals);
+    permute(_versions);
+    permute(_updated);
+    permute(_dirty);
+
+    _first_dirty = no_position;
+    for (std::uint32_t position = 0; position < count; ++position)
+    {
+      _positions[_entities[position]] = position;
+      if (_dirty[position])
+        mark_dirty(position);
+    }
+    for (std::uint32_t position = 0; position < count; ++position)
+      _parent_positions[position] = parent_position(position);
+    _unsorted = false;
+  }
+
+  void transform_hierarchy::update_range(std::size_t begin, std::size_t end)
+  {
+    for (auto position = begin; position < end; ++position)
+    {
+      auto const parent = _parent_positions[position];
+      auto const parent_changed = parent != no_position && _updated[parent] == _pass;
+      if (!_dirty[position] && !parent_changed)
+        continue;
+
+      if (parent == no_position)
+        _globals[position] = _locals[position];
+      else
+        _globals[position] = _globals[parent].matrix() * _locals[position].matrix();
+      _dirty[position] = 0;
+      _updated[position] = _pass;
+      ++_versions[position];
+    }
+  }
+}    // namespace gev::scenery